@@ -17,7 +17,7 @@ namespace octillion
 class octillion::LoginServer : public octillion::SslServerCallback
 {
     private:
-        const std::string tag_ = "LoginServer";
+        constexpr static const char* tag_ = "LoginServer";
         
         const static uint64_t token_timeout_ = 30 * 1000; // 30 sec
         const static int      blow_fish_factor_ = 12;
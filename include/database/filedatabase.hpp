@@ -28,7 +28,7 @@ public:
 class octillion::FileDatabase : public octillion::Database
 {
 private:
-    const std::string tag_ = "FileDatabase";
+    constexpr static const char* tag_ = "FileDatabase";
 
 public:
     FileDatabase();
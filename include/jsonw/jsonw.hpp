@@ -8,2092 +8,4100 @@
 #include <iostream> 
 #include <fstream>   // read json from file 
 #include <sstream>   // string buffer
-#include <cmath>     // pow
-#include <queue>     // token container
+#include <cctype>    // isxdigit
+#include <cstring>   // memchr
+#include <cstdlib>   // strtold
+#include <cstdint>   // int_fast64_t
+#include <climits>   // number range
+#include <cfloat>    // number range
+#include <cerrno>    // number range
+#include <cstdio>    // snprintf
 #include <string>    // string and wstring
 #include <map>       // json object container
 #include <vector>    // array container
 #include <locale>    // ucs utf8 convertor
 #include <codecvt>   // ucs utf8 convertor
 #include <memory>    // smart pointer
-
-// JsonTokenW presents a token in json data. It has a static member function 
-// 'parse()' that can parse the json from text to token. However, JsonW caller 
-// does not need to access this class at all. See README.md for detail.
-class JsonTokenW
+#include <atomic>    // arena reference count
+#include <algorithm> // sort object names
+
+// sse2 and avx2 for the structural index and the utf8 check, picked at
+// run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OCTILLION_JSONW_X86 1
+#include <immintrin.h>
+#else
+#define OCTILLION_JSONW_X86 0
+#endif
+
+// JsonIndexW is the first stage of parsing a large json text. It reads
+// the text in blocks of 64 bytes, finds quotes, backslashes and white 
+// spaces with SSE2 or AVX2 when the cpu has them, tells the characters 
+// inside strings from the structure, and keeps the offsets of the tokens
+// that begin after white space, of the closing quotes, and of the 
+// backslashes and EOLs inside strings. JsonTokenW jumps over white space
+// to the next offset, and copies a string in one go if the next offset 
+// is its closing quote. A token right after another one is read without
+// the index. The text is indexed a window at a time, so the index never 
+// grows with the text. It also checks utf8 with AVX2 for 
+// JsonTokenW::utf8valid(). Caller does not need to access this class 
+// except for choosing the instruction set, e.g. to compare them.
+class JsonIndexW
 {
 public:
-    enum class Type
-    {
-        NumberInteger,
-        NumberFloat,
-        String,
-        LeftCurlyBracket,
-        RightCurlyBracket,
-        LeftSquareBracket,
-        RightSquareBracket,
-        Colon,
-        Comma,
-        Boolean,
-        Null,
-        Bad
-    };
-
-public:
-    // parse json text from wistream instead of istream
-    JsonTokenW(std::wistream& ins)
-    {
-        type_ = Type::Bad;
-        wchar_t character;
-
-        if (!ins.good())
-        {
-            return;
-        }
-
-        character = ins.peek();
-
-        // return false if no more data to read
-        if (character == std::char_traits<wchar_t>::eof())
-        {
-            return;
-        }
-
-        // handle single character token
-        switch (character)
-        {
-        case L'{': type_ = Type::LeftCurlyBracket;  ins.get(); return;
-        case L'}': type_ = Type::RightCurlyBracket; ins.get(); return;
-        case L'[': type_ = Type::LeftSquareBracket;   ins.get(); return;
-        case L']': type_ = Type::RightSquareBracket;  ins.get(); return;
-        case L':': type_ = Type::Colon;              ins.get(); return;
-        case L',': type_ = Type::Comma;              ins.get(); return;
-        }
+    // instruction set for the block classification and the utf8 check
+    const static int SCALAR = 0;
+    const static int SSE2 = 1;
+    const static int AVX2 = 2;
 
-        // handle number
-        if (iswdigit(character) || character == L'-')
-        {
-            std::wstring numberstr;
-            std::wstring expstr;
-            bool containdot = false;
-            bool containexp = false;
-            bool negativeexp = false;
-            int exponent = 0;
-
-            // negative value
-            if (character == L'-')
-            {
-                numberstr.push_back(character);
-                ins.get();
-                character = ins.peek();
-            }
+    // texts shorter than this are not worth an index, longer than this 
+    // do not fit the offsets
+    const static size_t MIN_SIZE = 4096;
+    const static size_t MAX_SIZE = 0xFFFFFFFEu;
 
-            // if start with 0, it must followed by . or standalone zero
-            if (character == L'0')
-            {
-                numberstr.push_back(character);
-                ins.get();
-                character = ins.peek();
-
-                if (character != L'.')
-                {
-                    type_ = Type::NumberInteger;
-                    integer_ = 0;
-                    return;
-                }
+    // bytes indexed at a time, a multiple of the 64 bytes block
+    const static size_t WINDOW = 4096;
 
-                containdot = true;
-                numberstr.push_back(character);
-                ins.get();
-                character = ins.peek();
-            }
+    // offset after the last one of a window, the next window is indexed
+    // when it is reached. The last window ends with the text size.
+    const static uint32_t MORE = 0xFFFFFFFFu;
 
-            while (iswdigit(character) || character == L'.' || character == L'e')
-            {
-                // handle .
-                if (character == L'.')
-                {
-                    if (containdot || numberstr.length() == 0)
-                    {
-                        return;
-                    }
-                    else if (numberstr.length() == 1 && !iswdigit(numberstr.at(0)))
-                    {
-                        return;
-                    }
-                    else
-                    {
-                        containdot = true;
-                    }
-                }
+public:
+    JsonIndexW() {}
 
-                if (character == L'e' || character == L'E')
-                {
-                    containexp = true;
-                    break;
-                }
+    // start indexing text, nothing is read until the first seek()
+    void reset(const char* data, size_t size)
+    {
+        data_ = data;
+        size_ = size;
+        indexed_ = 0;
+        escaped_ = 0;
+        inside_ = 0;
+        space_ = 0;
+        offsets_.resize(WINDOW + 8);
+        offsets_[0] = MORE;
+        next_ = offsets_.data();
+        active_ = true;
+    }
 
-                numberstr.push_back(character);
-                ins.get();
-                character = ins.peek();
-            }
+    // index is no longer used after stop(), e.g. the token reader and the
+    // index disagree on the text
+    bool active() const { return active_; }
+    void stop() { active_ = false; }
 
-            // last character in numberstr has to be a digit
-            if (numberstr.length() == 0 || !iswdigit(numberstr.back()))
+    // first offset at or after 'pos', or the text size if there is no 
+    // more. Offsets before 'pos' are dropped, 'pos' never goes back.
+    uint32_t seek(size_t pos)
+    {
+        for (;;)
+        {
+            while (*next_ < pos)
             {
-                return;
+                next_++;
             }
 
-            // first digit cannot be zero except frac or zero
-            if (!containdot && numberstr.at(0) == L'0' && numberstr.length() > 1)
+            if (*next_ != MORE)
             {
-                return;
+                return *next_;
             }
 
-            // handle exponent notation
-            if (character == L'e' || character == L'E')
-            {
-                ins.get();
-                character = ins.peek();
-                if (character == L'-')
-                {
-                    negativeexp = true;
-                    ins.get();
-                    character = ins.peek();
-                }
-
-                if (character == L'+')
-                {
-                    ins.get();
-                    character = ins.peek();
-                }
+            fill();
+        }
+    }
 
-                while (iswdigit(character))
-                {
-                    expstr.push_back(character);
-                    ins.get();
-                    character = ins.peek();
-                }
+    // true if the index closes a string at 'offset', which is the last
+    // offset seek() returned
+    bool closes(uint32_t offset) const
+    {
+        size_t bit = offset - window_;
+        return ((insides_[bit >> 6] >> (bit & 63)) & 1) == 0 && data_[offset] == '\"';
+    }
 
-                if (expstr.length() == 0)
-                {
-                    return;
-                }
+    // instruction set in use, it is the best one the cpu supports unless 
+    // it is lowered by simd(int)
+    static int simd()
+    {
+        return level();
+    }
 
-                try
-                {
-                    exponent = std::stoi(expstr);
-                }
-                catch (const std::out_of_range& oor)
-                {
-                    std::cerr << "Out of Range error: " << oor.what() << '\n';
-                    type_ = Type::Bad;
-                    return;
-                }
-            }
+    static void simd(int set)
+    {
+        level() = std::min(set, detect());
+    }
 
-            if (containdot)
-            {
-                try
-                {
-                    frac_ = std::stold(numberstr);
-                }
-                catch (const std::out_of_range&)
-                {
-                    type_ = Type::Bad;
-                    return;
-                }
+    // JsonTokenW walks the index of a large text only when it is enabled,
+    // it is on by default if the cpu has SSE2, the scalar index is slower
+    // than the single pass. Turning it on or off is for comparing the two
+    // stages with the single pass, see test/json/bench.cpp.
+    static bool enabled()
+    {
+        return enabling();
+    }
 
-                type_ = Type::NumberFloat;
-            }
-            else
-            {
-                try
-                {
-                    integer_ = std::stoll(numberstr);
-                }
-                catch (const std::out_of_range&)
-                {
-                    type_ = Type::Bad;
-                    return;
-                }
+    static void enable(bool on)
+    {
+        enabling() = on;
+    }
 
-                type_ = Type::NumberInteger;
-            }
+#if OCTILLION_JSONW_X86
+    // check utf8 in blocks of 32 bytes with the same rule as utf8valid(),
+    // by looking up the error bits of every two bytes in three tables. The
+    // text from 'idx' on is left to utf8valid(), that is the last block, 
+    // the sequence it cuts, and the last 3 bytes in which a sequence may 
+    // run over the end and is dropped without checking.
+    __attribute__((target("avx2")))
+    static bool utf8_avx2(const char* data, size_t size, size_t& idx)
+    {
+        const char kTooShort = 1 << 0;  // 11______ 0_______, 11______ 11______
+        const char kTooLong = 1 << 1;   // 0_______ 10______
+        const char kOverlong3 = 1 << 2; // 11100000 100_____
+        const char kTooLarge = 1 << 3;  // 11110100 1001____, 11110101+ 10______
+        const char kOverlong2 = 1 << 5; // 1100000_ 10______
+        const char kOverlong4 = 1 << 6; // 11110000 1000____, 11110101+ 1000____
+        const char kTwoConts = (char)(1 << 7); // 10______ 10______
+        const char kCarry = kTooShort | kTooLong | kTwoConts;
+
+        const __m256i high1 = _mm256_setr_epi8(
+            kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+            kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+            kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3,
+            kTooShort | kTooLarge | kOverlong4,
+            kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+            kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+            kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3,
+            kTooShort | kTooLarge | kOverlong4);
+        const __m256i low1 = _mm256_setr_epi8(
+            kCarry | kOverlong2 | kOverlong3 | kOverlong4, kCarry | kOverlong2,
+            kCarry, kCarry, kCarry | kTooLarge,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4,
+            kCarry | kOverlong2 | kOverlong3 | kOverlong4, kCarry | kOverlong2,
+            kCarry, kCarry, kCarry | kTooLarge,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4, kCarry | kTooLarge | kOverlong4,
+            kCarry | kTooLarge | kOverlong4);
+        const __m256i high2 = _mm256_setr_epi8(
+            kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+            kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kOverlong4,
+            kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+            kTooLong | kOverlong2 | kTwoConts | kTooLarge,
+            kTooLong | kOverlong2 | kTwoConts | kTooLarge,
+            kTooShort, kTooShort, kTooShort, kTooShort,
+            kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+            kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kOverlong4,
+            kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+            kTooLong | kOverlong2 | kTwoConts | kTooLarge,
+            kTooLong | kOverlong2 | kTwoConts | kTooLarge,
+            kTooShort, kTooShort, kTooShort, kTooShort);
+
+        const __m256i nibble = _mm256_set1_epi8(0x0F);
+        const __m256i lastbytes = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+        __m256i prev = _mm256_setzero_si256();
+        __m256i incomplete = _mm256_setzero_si256();
+        __m256i error = _mm256_setzero_si256();
+
+        for (idx = 0; idx + 32 + 3 <= size; idx += 32)
+        {
+            __m256i input = _mm256_loadu_si256((const __m256i*)(data + idx));
 
-            if (containexp)
+            // ascii block, only a sequence cut by the previous block is wrong
+            if (_mm256_movemask_epi8(input) == 0)
             {
-                double multiplier;
-                if (negativeexp)
-                {
-                    multiplier = std::pow(10, -1 * exponent);
-                }
-                else
-                {
-                    multiplier = std::pow(10, exponent);
-                }
-
-                if (multiplier == HUGE_VAL || multiplier == -HUGE_VAL)
-                {
-                    std::cerr << "Out of Range error" << std::endl;
-                    type_ = Type::Bad;
-                    return;
-                }
-
-                if (type_ == Type::NumberInteger)
-                {
-                    frac_ = 1.0 * integer_;
-                    type_ = Type::NumberFloat;
-                }
-
-                frac_ = frac_ * multiplier;
+                error = _mm256_or_si256(error, incomplete);
+                incomplete = _mm256_setzero_si256();
+                prev = input;
+                continue;
             }
 
-            return;
+            __m256i shifted = _mm256_permute2x128_si256(prev, input, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+            __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+            __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+
+            __m256i special = _mm256_and_si256(
+                _mm256_and_si256(
+                    _mm256_shuffle_epi8(high1, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                    _mm256_shuffle_epi8(low1, _mm256_and_si256(prev1, nibble))),
+                _mm256_shuffle_epi8(high2, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+
+            // the 3rd and 4th byte of a sequence have to be continuations
+            __m256i must23 = _mm256_or_si256(
+                _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+                _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80))));
+            must23 = _mm256_and_si256(must23, _mm256_set1_epi8(kTwoConts));
+
+            error = _mm256_or_si256(error, _mm256_xor_si256(must23, special));
+            incomplete = _mm256_subs_epu8(input, lastbytes);
+            prev = input;
         }
 
-        // handle 'true'
-        if (character == L't')
+        if (!_mm256_testz_si256(error, error))
         {
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'r')
-            {
-                return;
-            }
-
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'u')
-            {
-                return;
-            }
-
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'e')
-            {
-                return;
-            }
-
-            ins.get();
-            type_ = Type::Boolean;
-            boolean_ = true;
-            return;
+            return false;
         }
 
-        // handle 'false'
-        if (character == L'f')
+        // leave the sequence cut by the last block to utf8valid()
+        for (size_t back = 1; back <= 3 && back <= idx; back++)
         {
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'a')
+            unsigned char lead = (unsigned char)data[idx - back];
+            if (lead < 0x80)
             {
-                return;
+                break;
             }
-
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'l')
+            else if (lead >= 0xC0)
             {
-                return;
+                size_t length = lead < 0xE0 ? 2 : (lead < 0xF0 ? 3 : 4);
+                if (back < length)
+                {
+                    idx -= back;
+                }
+                break;
             }
+        }
 
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L's')
-            {
-                return;
-            }
+        return true;
+    }
+#endif
 
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'e')
-            {
-                return;
-            }
+private:
+    // bits of one 64 bytes block, bit n is the nth character
+    struct Block
+    {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t space;
+        uint64_t eol;
+    };
 
-            ins.get();
-            type_ = Type::Boolean;
-            boolean_ = false;
-            return;
-        }
+    // index the next window of text
+    void fill()
+    {
+        size_t end = (size_ - indexed_ < WINDOW) ? size_ : indexed_ + WINDOW;
+        uint32_t* out = offsets_.data();
+        window_ = indexed_;
 
-        // handle 'null'
-        if (character == L'n')
+        for (; indexed_ < end; indexed_ += 64)
         {
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'u')
-            {
-                return;
-            }
+            Block block;
+            const char* data = data_ + indexed_;
+            char last[64];
 
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'l')
+            // pad the last block with white spaces
+            if (size_ - indexed_ < 64)
             {
-                return;
+                memset(last, ' ', sizeof(last));
+                memcpy(last, data, size_ - indexed_);
+                data = last;
             }
 
-            ins.get();
-            character = ins.peek();
-            if (character == std::char_traits<wchar_t>::eof() || character != L'l')
-            {
-                return;
-            }
-
-            ins.get();
-            type_ = Type::Null;
-            return;
+            classify(data, block);
+            out = mark(block, out);
         }
 
-        // the only remaining possible token is string, must start with \"
-        if (character != L'\"')
+        if (indexed_ >= size_)
         {
-            return;
+            indexed_ = size_;
+            out[0] = (uint32_t)size_;
         }
-
-        // consume \"
-        ins.get();
-        character = ins.peek();
-
-        // handle string
-        bool backslash = false;
-        std::wstring strbuf;
-
-        while (character != std::char_traits<wchar_t>::eof())
+        else
         {
-            if (backslash)
-            {
-                // previous character is backslash
-                if (character == L'u')
-                {
-                    // special case for \u
-                    std::wstring hexbuf(L"0x");
-                    ins.get();
-                    hexbuf.push_back(ins.get());
-                    hexbuf.push_back(ins.get());
-                    hexbuf.push_back(ins.get());
-                    hexbuf.push_back(ins.get());
-
-                    if (hexbuf.at(2) == std::char_traits<wchar_t>::eof() ||
-                        hexbuf.at(3) == std::char_traits<wchar_t>::eof() ||
-                        hexbuf.at(4) == std::char_traits<wchar_t>::eof() ||
-                        hexbuf.at(5) == std::char_traits<wchar_t>::eof())
-                    {
-                        return;
-                    }
-
-                    try
-                    {
-                        unsigned int charvalue = std::stoul(hexbuf, NULL, 16);
-                        strbuf.push_back((wchar_t)charvalue);
-                        character = ins.peek();
-                        backslash = false;
-                        continue;
-                    }
-                    catch (const std::invalid_argument&)
-                    {
-                        return;
-                    }
-                    catch (const std::out_of_range&)
-                    {
-                        return;
-                    }
-                }
+            out[0] = MORE;
+        }
 
-                // other single character cases
-                switch (character)
-                {
-                case L'\"': strbuf.push_back(L'\"'); break;
-                case L'\\': strbuf.push_back(L'\\'); break;
-                case L'/': strbuf.push_back(L'/'); break;
-                case L'b':  strbuf.push_back((wchar_t)0x08); break;
-                case L'f':  strbuf.push_back((wchar_t)0x0c); break;
-                case L'n':  strbuf.push_back(L'\n'); break;
-                case L'r':  strbuf.push_back(L'\r'); break;
-                case L't':  strbuf.push_back(L'\t'); break;
-                }
+        next_ = offsets_.data();
+    }
 
-                ins.get();
-                character = ins.peek();
-                backslash = false;
-                continue;
-            }
-            else if (character == L'\\')
-            {
-                // special , set flag and fo next round
-                backslash = true;
-                ins.get();
-                character = ins.peek();
-                continue;
-            }
-            else if (character == L'\r' || character == L'\n')
-            {
-                // unexpected EOL
-                return;
-            }
-            else if (character == L'\"')
-            {
-                ins.get();
-                type_ = Type::String;
-                wstring_ = strbuf;
-                return;
-            }
-            else
+    // write the offsets of one block from its character classes, return 
+    // the end of the offsets written
+    uint32_t* mark(const Block& block, uint32_t* out)
+    {
+        // a backslash escapes the next character unless it is escaped,
+        // i.e. the characters after the odd backslashes of a run. Adding
+        // the runs that start on odd bits to the backslashes carries them
+        // to their ends, that flips the odd and even bits of those runs.
+        const uint64_t kEven = 0x5555555555555555ULL;
+        uint64_t backslash = block.backslash & ~escaped_;
+        uint64_t follows = (backslash << 1) | escaped_;
+        uint64_t oddstarts = backslash & ~kEven & ~follows;
+        uint64_t evenruns = oddstarts + backslash;
+        escaped_ = (evenruns < backslash) ? 1 : 0;
+        uint64_t escaped = (kEven ^ (evenruns << 1)) & follows;
+
+        // characters between an opening quote and a closing quote, the
+        // opening quote is inside and the closing quote is not
+        uint64_t quote = block.quote & ~escaped;
+        uint64_t inside = quote;
+        inside ^= inside << 1;
+        inside ^= inside << 2;
+        inside ^= inside << 4;
+        inside ^= inside << 8;
+        inside ^= inside << 16;
+        inside ^= inside << 32;
+        inside ^= inside_;
+        inside_ = (inside >> 63) ? ~0ULL : 0;
+        insides_[(indexed_ - window_) >> 6] = inside;
+
+        // first character of a token after white space, an opening quote
+        // is one of them
+        uint64_t close = quote & ~inside;
+        uint64_t within = inside & ~quote;
+        uint64_t after = (block.space << 1) | space_;
+        uint64_t start = ~(block.space | close | within) & after;
+        space_ = block.space >> 63;
+
+        uint64_t bits = start | close | ((block.backslash | block.eol) & within);
+        uint32_t base = (uint32_t)indexed_;
+        uint32_t* next = out + popcount(bits);
+
+        // 8 offsets at a time, the ones past the last bit are garbage and
+        // are written over by the next block
+        while (out < next)
+        {
+            for (int i = 0; i < 8; i++)
             {
-                strbuf.push_back(character);
-                ins.get();
-                character = ins.peek();
+                out[i] = base + ctz(bits | (1ULL << 63));
+                bits &= bits - 1;
             }
+            out += 8;
         }
 
-        // unexpected EOF
-        return;
+        return next;
     }
 
-public:
-    enum Type type() const { return type_; }
-    int_fast64_t integer() const { return integer_; }
-    long double frac() const { return frac_; }
-    std::wstring wstring() const { return wstring_; }
-    bool boolean() const { return boolean_; }
-
-private:
-    // determine if  character is white space for json
-    static bool isskippable(wchar_t character)
+    static int popcount(uint64_t bits)
     {
-        if (character == L' ' || character == L'\r' || character == L'\n' || character == L'\t')
-        {
-            return true;
-        }
-        else
+#if defined(__GNUC__)
+        return __builtin_popcountll(bits);
+#else
+        int count = 0;
+        for (; bits != 0; bits &= bits - 1)
         {
-            return false;
+            count++;
         }
+        return count;
+#endif
+    }
+
+    static int ctz(uint64_t bits)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(bits);
+#else
+        static const int kDeBruijn[64] = {
+            0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6 };
+        return kDeBruijn[((bits & (0 - bits)) * 0x03F79D71B4CB0A89ULL) >> 58];
+#endif
     }
 
-    // skip the white space and check if next non-ws is valid 
-    // beginning character for json token
-    static bool findnext(std::wistream& ins)
+    static void classify(const char* data, Block& block)
     {
-        wchar_t character;
-        if (!ins.good())
+#if OCTILLION_JSONW_X86
+        if (level() == AVX2)
         {
-            return false;
+            classify_avx2(data, block);
+            return;
         }
-
-        character = ins.peek();
-
-        // return false if no more data to read
-        if (character == std::char_traits<wchar_t>::eof())
+        else if (level() == SSE2)
         {
-            return false;
+            classify_sse2(data, block);
+            return;
         }
-
-        // skip white space 
-        while (isskippable(character))
+#endif
+        block = Block();
+        for (int i = 0; i < 64; i++)
         {
-            ins.get();
-            character = ins.peek();
-
-            if (character == std::char_traits<wchar_t>::eof())
+            uint64_t bit = 1ULL << i;
+            switch (data[i])
             {
-                return false;
+            case '\"': block.quote |= bit; break;
+            case '\\': block.backslash |= bit; break;
+            case ' ': case '\t': block.space |= bit; break;
+            case '\r': case '\n': block.space |= bit; block.eol |= bit; break;
             }
         }
+    }
 
-        // check next character is valid begin character for token 
-        if (character == L'[' || character == L']' ||
-            character == L'{' || character == L'}' ||
-            character == L':' || iswdigit(character) ||
-            character == L',' || character == L'\"' ||
-            character == L'-' || character == L't' ||
-            character == L'f' || character == L'n')
+#if OCTILLION_JSONW_X86
+    __attribute__((target("sse2")))
+    static void classify_sse2(const char* data, Block& block)
+    {
+        block = Block();
+        for (int i = 0; i < 64; i += 16)
         {
-            return true;
+            __m128i chars = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i eol = _mm_or_si128(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('\r')),
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')));
+            __m128i space = _mm_or_si128(eol, _mm_or_si128(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t'))));
+
+            block.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('\"'))) << i;
+            block.backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('\\'))) << i;
+            block.space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << i;
+            block.eol |= (uint64_t)(uint16_t)_mm_movemask_epi8(eol) << i;
         }
-        else
+    }
+
+    __attribute__((target("avx2")))
+    static void classify_avx2(const char* data, Block& block)
+    {
+        block = Block();
+        for (int i = 0; i < 64; i += 32)
         {
-            return false;
+            __m256i chars = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i eol = _mm256_or_si256(
+                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\r')),
+                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\n')));
+            __m256i space = _mm256_or_si256(eol, _mm256_or_si256(
+                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\t'))));
+
+            block.quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\"'))) << i;
+            block.backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\\'))) << i;
+            block.space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << i;
+            block.eol |= (uint64_t)(uint32_t)_mm256_movemask_epi8(eol) << i;
         }
     }
+#endif
 
-public:
-    // parse text data from wistream and store tokens in queue
-    static bool parse(std::wistream& ins, std::queue<JsonTokenW>& tokens)
+    // best instruction set of the cpu
+    static int detect()
     {
-        bool success = findnext(ins);
-
-        while (success)
+#if OCTILLION_JSONW_X86
+        if (__builtin_cpu_supports("avx2"))
         {
-            JsonTokenW token(ins);
+            return AVX2;
+        }
+        else if (__builtin_cpu_supports("sse2"))
+        {
+            return SSE2;
+        }
+#endif
+        return SCALAR;
+    }
 
-            if (token.type() == JsonTokenW::Type::Bad)
-            {
-                std::queue<JsonTokenW>().swap(tokens); // clear
-                return false;
-            }
-            else
-            {
-                tokens.push(token);
-            }
+    static int& level()
+    {
+        static int level = detect();
+        return level;
+    }
 
-            success = findnext(ins);
-        }
-        return true;
+    static bool& enabling()
+    {
+        static bool on = detect() != SCALAR;
+        return on;
     }
 
 private:
-    enum Type type_ = Type::Bad;
-    int_fast64_t integer_ = 0;
-    long double frac_ = 0.0;
-    std::wstring wstring_;
-    bool boolean_ = true;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t indexed_ = 0;
+
+    // carry from the previous block
+    uint64_t escaped_ = 0;
+    uint64_t inside_ = 0;
+    uint64_t space_ = 0;
+
+    std::vector<uint32_t> offsets_;
+    const uint32_t* next_ = nullptr; // in offsets_
+
+    // inside bits of the blocks in the window from window_ on
+    size_t window_ = 0;
+    uint64_t insides_[WINDOW / 64];
+    bool active_ = false;
 };
 
-// JsonW is one and the only one class that caller should access. It
-// represents a json 'value' defined in json standard. In other words,
-// JsonW could be a number, a string, a boolean, a null, a json array or
-// an json object. See README.md for the usage.
-class JsonW
+// JsonTokenW reads the tokens of json text one by one, straight from a
+// contiguous utf8 buffer or chunk by chunk from a stream. A large text or
+// chunk is read through JsonIndexW. JsonW parses the text by pulling 
+// tokens from it, caller does not need to access this class at all. See
+// README.md for detail.
+class JsonTokenW
 {
 public:
-    // type of jsonw
-    const static int BAD = 0;
-    const static int OBJECT = 1;    
-    const static int ARRAY  = 2;
-    const static int INTEGER  = 3;
-    const static int FLOAT = 4;
-    const static int STRING = 5;
-    const static int BOOLEAN = 6;
-    const static int NULLVALUE = 7;
+    enum class Type
+    {
+        NumberInteger,
+        NumberFloat,
+        String,
+        LeftCurlyBracket,
+        RightCurlyBracket,
+        LeftSquareBracket,
+        RightSquareBracket,
+        Colon,
+        Comma,
+        Boolean,
+        Null,
+        Bad,
+        End
+    };
+
+public:
+    // read utf8 json text, the buffer has to outlive the JsonTokenW
+    JsonTokenW(const char* data, size_t size)
+    {
+        ptr_ = data;
+        end_ = data + size;
+        index(data, size);
+    }
+
+    // read utf8 json text from a stream, only the chunk in use and the
+    // token across its end are kept in memory. Text stops at the first NUL
+    // character. Utf8 is checked chunk by chunk, an invalid sequence makes
+    // the token that reaches it Type::Bad. The stream has to outlive the
+    // JsonTokenW.
+    explicit JsonTokenW(std::istream& in) : source_(new Source(in))
+    {
+    }
+
+    // read next token and return its type. Type::End means no more token,
+    // either the data runs out or the next character cannot begin a token.
+    // Type::Bad means the text is not a valid token. Both of them end the
+    // reading, calling next() again returns the same type.
+    Type next()
+    {
+        if (type_ != Type::Bad && type_ != Type::End)
+        {
+            type_ = token();
+        }
+
+        return type_;
+    }
+
+public:
+    enum Type type() const { return type_; }
+    int_fast64_t integer() const { return integer_; }
+    long double frac() const { return frac_; }
+    std::string& str() { return string_; }
+    bool boolean() const { return boolean_; }
+
+private:
+    // stream source of the text, buffer_ holds the text from the current
+    // token on. [0, checked_) is valid utf8, the rest is a sequence cut by
+    // the end of the chunk and waits for the next one.
+    class Source
+    {
+    public:
+        const static size_t CHUNK = 64 * 1024;
+
+        explicit Source(std::istream& in) : in_(in) {}
+
+        // drop the first 'count' bytes
+        void compact(size_t count)
+        {
+            if (count > 0)
+            {
+                memmove(buffer_.data(), buffer_.data() + count, filled_ - count);
+                filled_ -= count;
+                checked_ -= count;
+            }
+        }
+
+        // read the next chunk and check it, return false if there is
+        // nothing more to read or the text is not valid utf8. A sequence
+        // cut by the end of the stream ends the text like utf8valid() does.
+        bool fill()
+        {
+            if (eof_ || bad_)
+            {
+                return false;
+            }
+
+            // a long token grows the buffer, otherwise it stays one chunk
+            if (buffer_.size() - filled_ < CHUNK / 2)
+            {
+                buffer_.resize(filled_ + CHUNK);
+            }
+
+            in_.read(buffer_.data() + filled_, buffer_.size() - filled_);
+            filled_ += (size_t)in_.gcount();
+            eof_ = !in_.good();
+
+            size_t size = filled_ - checked_;
+            if (!utf8valid(buffer_.data() + checked_, size))
+            {
+                bad_ = true;
+                return false;
+            }
+
+            checked_ += size;
+            return true;
+        }
+
+        std::istream& in_;
+        std::vector<char> buffer_;
+        size_t filled_ = 0;  // bytes read into buffer_
+        size_t checked_ = 0; // bytes checked as utf8
+        bool eof_ = false;   // stream has no more data
+        bool nul_ = false;   // text stops at a NUL character
+        bool bad_ = false;   // text is not valid utf8
+    };
+
+    Type token()
+    {
+        return source_ ? stream() : scan();
+    }
+
+    // stream source, a token that reaches the end of the chunk may go on in
+    // the next one, it is read again from 'mark' once the chunk is there
+    Type stream()
+    {
+        Type type = Type::End;
+
+        for (;;)
+        {
+            while (ptr_ < end_ && isskippable(*ptr_))
+                ptr_++;
+
+            const char* mark = ptr_;
+            if (ptr_ < end_)
+            {
+                type = scan();
+                if (ptr_ < end_)
+                {
+                    break;
+                }
+
+                ptr_ = mark;
+            }
+
+            if (!more(mark))
+            {
+                type = (ptr_ < end_) ? scan() : Type::End;
+                break;
+            }
+        }
+
+        if (source_->bad_)
+        {
+            return Type::Bad;
+        }
+
+        return (type == Type::End) ? rest() : type;
+    }
+
+    // stream source, drop the text before 'mark' and read chunks until
+    // there is more text after end_. Return false if the text is over.
+    // 'mark', ptr_ and end_ move along with the text.
+    bool more(const char*& mark)
+    {
+        Source& source = *source_;
+        if (source.eof_ || source.nul_ || source.bad_)
+        {
+            return false;
+        }
+
+        size_t ptr = ptr_ - mark;
+        size_t end = end_ - mark;
+        size_t before = end;
+
+        source.compact(mark - source.buffer_.data());
+        while (end == before && !source.nul_ && source.fill())
+        {
+            const char* text = source.buffer_.data();
+            const char* nul = (const char*)memchr(text + end, 0, source.checked_ - end);
+            if (nul != nullptr)
+            {
+                end = nul - text;
+                source.nul_ = true;
+            }
+            else
+            {
+                end = source.checked_;
+            }
+        }
+
+        mark = source.buffer_.data();
+        ptr_ = mark + ptr;
+        end_ = mark + end;
+
+        // a token begins at 'mark', the index starts over from there
+        index(mark, end);
+
+        return end > before;
+    }
+
+    // stream source, text after the last token is not read as tokens but
+    // has to be valid utf8, same as a buffer is checked as a whole
+    Type rest()
+    {
+        Source& source = *source_;
+        do
+        {
+            source.compact(source.checked_);
+        } while (source.fill());
+
+        ptr_ = end_ = source.buffer_.data();
+        index_.stop();
+        return source.bad_ ? Type::Bad : Type::End;
+    }
+
+    // index the text from 'data' on if it is large enough
+    void index(const char* data, size_t size)
+    {
+        begin_ = data;
+        if (JsonIndexW::enabled() && size >= JsonIndexW::MIN_SIZE && size <= JsonIndexW::MAX_SIZE)
+        {
+            index_.reset(data, size);
+        }
+        else
+        {
+            index_.stop();
+        }
+    }
+
+    // read one token from [ptr_, end_)
+    Type scan()
+    {
+        // skip the white space, the index jumps to the next token
+        if (ptr_ < end_ && isskippable(*ptr_) && index_.active())
+        {
+            skip();
+        }
+        else
+        {
+            while (ptr_ < end_ && isskippable(*ptr_))
+                ptr_++;
+        }
+
+        if (ptr_ == end_)
+        {
+            return Type::End;
+        }
+
+        switch (*ptr_)
+        {
+        case '{': ptr_++; return Type::LeftCurlyBracket;
+        case '}': ptr_++; return Type::RightCurlyBracket;
+        case '[': ptr_++; return Type::LeftSquareBracket;
+        case ']': ptr_++; return Type::RightSquareBracket;
+        case ':': ptr_++; return Type::Colon;
+        case ',': ptr_++; return Type::Comma;
+        case '\"': return string();
+        case 't': boolean_ = true; return literal("true", Type::Boolean);
+        case 'f': boolean_ = false; return literal("false", Type::Boolean);
+        case 'n': return literal("null", Type::Null);
+        case '-': return number();
+        default:
+            if (isdecimal(*ptr_))
+            {
+                return number();
+            }
+
+            // not a valid begin character for token
+            return Type::End;
+        }
+    }
+
+    // handle 'true', 'false' and 'null'
+    Type literal(const char* text, Type type)
+    {
+        for (; *text != '\0'; text++, ptr_++)
+        {
+            if (ptr_ == end_ || *ptr_ != *text)
+            {
+                return Type::Bad;
+            }
+        }
+
+        return type;
+    }
+
+    // handle number. A number starting with 0 must be followed by '.' or it
+    // is a standalone zero. An exponent makes the number a float only if it
+    // is a lower case 'e' after the digits, an exponent out of int range or
+    // over 10^308 makes the number bad, so does an integer out of the range
+    // of long long.
+    Type number()
+    {
+        const char* begin = ptr_;
+        bool negative = false;
+        bool containdot = false;
+        bool containexp = false;
+        bool negativeexp = false;
+
+        if (*ptr_ == '-')
+        {
+            negative = true;
+            ptr_++;
+        }
+
+        if (ptr_ < end_ && *ptr_ == '0')
+        {
+            ptr_++;
+            if (ptr_ == end_ || *ptr_ != '.')
+            {
+                integer_ = 0;
+                return Type::NumberInteger;
+            }
+
+            containdot = true;
+            ptr_++;
+        }
+
+        while (ptr_ < end_ && (isdecimal(*ptr_) || *ptr_ == '.' || *ptr_ == 'e'))
+        {
+            if (*ptr_ == '.')
+            {
+                if (containdot || (negative && ptr_ - begin == 1))
+                {
+                    return Type::Bad;
+                }
+
+                containdot = true;
+            }
+            else if (*ptr_ == 'e')
+            {
+                containexp = true;
+                break;
+            }
+
+            ptr_++;
+        }
+
+        // last character has to be a digit
+        const char* mantissa = ptr_;
+        if (mantissa == begin || !isdecimal(mantissa[-1]))
+        {
+            return Type::Bad;
+        }
+
+        // exponent, 'e-+5' is read as 'e-5'
+        const char* exponent = nullptr;
+        long long expvalue = 0;
+        if (ptr_ < end_ && (*ptr_ == 'e' || *ptr_ == 'E'))
+        {
+            ptr_++;
+            if (ptr_ < end_ && *ptr_ == '-')
+            {
+                negativeexp = true;
+                ptr_++;
+            }
+
+            if (ptr_ < end_ && *ptr_ == '+')
+            {
+                ptr_++;
+            }
+
+            exponent = ptr_;
+            while (ptr_ < end_ && isdecimal(*ptr_))
+            {
+                if (expvalue <= INT_MAX)
+                {
+                    expvalue = expvalue * 10 + (*ptr_ - '0');
+                }
+                ptr_++;
+            }
+
+            if (ptr_ == exponent || expvalue > INT_MAX)
+            {
+                return Type::Bad;
+            }
+        }
+
+        if (containdot)
+        {
+            if (!decimal(begin, mantissa, frac_))
+            {
+                return Type::Bad;
+            }
+        }
+        else if (!digits(begin, mantissa, integer_))
+        {
+            return Type::Bad;
+        }
+
+        if (!containexp)
+        {
+            return containdot ? Type::NumberFloat : Type::NumberInteger;
+        }
+
+        // 10^exponent has to fit in double
+        if (!negativeexp && expvalue > DBL_MAX_10_EXP)
+        {
+            return Type::Bad;
+        }
+
+        // read mantissa and exponent together so the value is rounded once
+        std::string text(begin, mantissa);
+        text.push_back('e');
+        if (negativeexp)
+        {
+            text.push_back('-');
+        }
+        text.append(exponent, ptr_);
+        frac_ = std::strtold(text.c_str(), nullptr);
+
+        return Type::NumberFloat;
+    }
+
+    // integer in [begin, end), return false if it is out of the range of
+    // long long
+    static bool digits(const char* begin, const char* end, int_fast64_t& integer)
+    {
+        bool negative = (*begin == '-');
+        unsigned long long value = 0;
+        unsigned long long limit = negative ?
+            (unsigned long long)LLONG_MAX + 1 : (unsigned long long)LLONG_MAX;
+
+        for (const char* ptr = negative ? begin + 1 : begin; ptr < end; ptr++)
+        {
+            unsigned int digit = *ptr - '0';
+            if (value > (limit - digit) / 10)
+            {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+
+        integer = negative ? (int_fast64_t)(0 - value) : (int_fast64_t)value;
+        return true;
+    }
+
+    // decimal number in [begin, end), return false if it is out of the range
+    // of long double
+    static bool decimal(const char* begin, const char* end, long double& frac)
+    {
+        // up to 19 significant digits fit in 64 bits mantissa of long double,
+        // one division gives the correctly rounded value
+        static const long double kPow10[] = {
+            1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L,
+            1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L };
+        unsigned long long value = 0;
+        int count = 0;
+        int fraction = -1;
+
+        for (const char* ptr = (*begin == '-') ? begin + 1 : begin; ptr < end; ptr++)
+        {
+            if (*ptr == '.')
+            {
+                fraction = 0;
+                continue;
+            }
+
+            if (value != 0 || *ptr != '0')
+            {
+                count++;
+            }
+
+            value = value * 10 + (*ptr - '0');
+            if (fraction >= 0)
+            {
+                fraction++;
+            }
+
+            if (count > 19)
+            {
+                break;
+            }
+        }
+
+        if (count <= 19 && fraction <= 19)
+        {
+            frac = (long double)value / kPow10[fraction];
+            if (*begin == '-')
+            {
+                frac = -frac;
+            }
+            return true;
+        }
+
+        // slow path, same as stold
+        std::string text(begin, end);
+        errno = 0;
+        frac = std::strtold(text.c_str(), nullptr);
+        return errno != ERANGE;
+    }
+
+    // jump over the white space at ptr_ to the next token by the index.
+    // The index is outside of strings wherever the token reader is, 
+    // string() makes sure of it.
+    void skip()
+    {
+        ptr_ = begin_ + index_.seek(ptr_ - begin_);
+    }
+
+    // handle string, a string without escape or EOL is copied in one go
+    // when the offset after its opening quote is a quote
+    Type string()
+    {
+        if (index_.active())
+        {
+            const char* close = begin_ + index_.seek(ptr_ - begin_ + 1);
+            if (close < end_ && *close == '\"')
+            {
+                string_.assign(ptr_ + 1, close);
+                ptr_ = close + 1;
+                return Type::String;
+            }
+        }
+
+        Type type = quoted();
+
+        // index has to close the string at the same quote, e.g. '\u' takes
+        // the 4 characters after it even if one of them is a quote. If not,
+        // the rest of the text is scanned character by character.
+        if (type == Type::String && index_.active())
+        {
+            uint32_t pos = (uint32_t)(ptr_ - begin_ - 1);
+            if (index_.seek(pos) != pos || !index_.closes(pos))
+            {
+                index_.stop();
+            }
+        }
+
+        return type;
+    }
+
+    // scan string character by character, control characters except EOL
+    // are kept as they are
+    Type quoted()
+    {
+        // consume \"
+        ptr_++;
+        string_.clear();
+
+        while (ptr_ < end_)
+        {
+            // copy plain characters in one go
+            const char* plain = ptr_;
+            while (ptr_ < end_ && *ptr_ != '\"' && *ptr_ != '\\' && *ptr_ != '\r' && *ptr_ != '\n')
+            {
+                ptr_++;
+            }
+            string_.append(plain, ptr_);
+
+            if (ptr_ == end_)
+            {
+                break;
+            }
+
+            char character = *ptr_++;
+            if (character == '\"')
+            {
+                return Type::String;
+            }
+            else if (character != '\\')
+            {
+                // unexpected EOL
+                return Type::Bad;
+            }
+            else if (ptr_ == end_)
+            {
+                break;
+            }
+
+            character = *ptr_;
+            if (character == 'u')
+            {
+                // special case for \u, the 4 characters after it are
+                // read as code points and the leading hex digits among
+                // them make the value, same as stoul("0x....", 16)
+                unsigned int charvalue = 0;
+                bool hexdigit = true;
+                ptr_++;
+
+                for (int i = 0; i < 4; i++)
+                {
+                    if (ptr_ == end_)
+                    {
+                        return Type::Bad;
+                    }
+
+                    unsigned int codepoint = getcodepoint();
+                    if (hexdigit && codepoint < 0x80 && isxdigit(codepoint))
+                    {
+                        charvalue = charvalue * 16 +
+                            (isdigit(codepoint) ? codepoint - '0' : (codepoint | 0x20) - 'a' + 10);
+                    }
+                    else
+                    {
+                        hexdigit = false;
+                    }
+                }
+
+                utf8(string_, charvalue);
+                continue;
+            }
+
+            // other single character cases
+            switch (character)
+            {
+            case '\"': string_.push_back('\"'); break;
+            case '\\': string_.push_back('\\'); break;
+            case '/': string_.push_back('/'); break;
+            case 'b':  string_.push_back((char)0x08); break;
+            case 'f':  string_.push_back((char)0x0c); break;
+            case 'n':  string_.push_back('\n'); break;
+            case 'r':  string_.push_back('\r'); break;
+            case 't':  string_.push_back('\t'); break;
+            }
+
+            // unknown escaped character is dropped as a whole
+            getcodepoint();
+        }
+
+        // unexpected EOF
+        return Type::Bad;
+    }
+
+    // read one utf8 encoded code point, data is already checked by utf8valid()
+    unsigned int getcodepoint()
+    {
+        unsigned int character = (unsigned char)*ptr_++;
+        int length = 0;
+
+        if (character < 0x80)
+        {
+            return character;
+        }
+        else if ((character & 0xE0) == 0xC0)
+        {
+            character &= 0x1F;
+            length = 1;
+        }
+        else if ((character & 0xF0) == 0xE0)
+        {
+            character &= 0x0F;
+            length = 2;
+        }
+        else
+        {
+            character &= 0x07;
+            length = 3;
+        }
+
+        for (int i = 0; i < length; i++)
+        {
+            character = (character << 6) | ((unsigned char)*ptr_++ & 0x3F);
+        }
+
+        return character;
+    }
+
+    static bool isdecimal(char character)
+    {
+        return character >= '0' && character <= '9';
+    }
+
+    // determine if  character is white space for json
+    static bool isskippable(char character)
+    {
+        if (character == ' ' || character == '\r' || character == '\n' || character == '\t')
+        {
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+public:
+    // append a code point to utf8 string, a lone surrogate is encoded as
+    // three bytes like codecvt_utf8 does
+    static void utf8(std::string& str, unsigned int codepoint)
+    {
+        if (codepoint < 0x80)
+        {
+            str.push_back((char)codepoint);
+        }
+        else if (codepoint < 0x800)
+        {
+            str.push_back((char)(0xC0 | (codepoint >> 6)));
+            str.push_back((char)(0x80 | (codepoint & 0x3F)));
+        }
+        else if (codepoint < 0x10000)
+        {
+            str.push_back((char)(0xE0 | (codepoint >> 12)));
+            str.push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+            str.push_back((char)(0x80 | (codepoint & 0x3F)));
+        }
+        else
+        {
+            str.push_back((char)(0xF0 | (codepoint >> 18)));
+            str.push_back((char)(0x80 | ((codepoint >> 12) & 0x3F)));
+            str.push_back((char)(0x80 | ((codepoint >> 6) & 0x3F)));
+            str.push_back((char)(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    // check utf8 data with the same rule as codecvt_utf8, return false if
+    // data contains invalid sequence. A sequence longer than the remaining
+    // data ends the text, the remaining is dropped by shrinking 'size'.
+    static bool utf8valid(const char* data, size_t& size)
+    {
+        const unsigned char* ptr = (const unsigned char*)data;
+        size_t idx = 0;
+
+#if OCTILLION_JSONW_X86
+        if (JsonIndexW::simd() == JsonIndexW::AVX2 && !JsonIndexW::utf8_avx2(data, size, idx))
+        {
+            return false;
+        }
+#endif
+
+        while (idx < size)
+        {
+            // skip ascii characters 8 bytes at a time
+            if (idx + 8 <= size)
+            {
+                uint64_t block;
+                memcpy(&block, ptr + idx, 8);
+                if ((block & 0x8080808080808080ULL) == 0)
+                {
+                    idx += 8;
+                    continue;
+                }
+            }
+
+            unsigned char lead = ptr[idx];
+            size_t length;
+
+            if (lead < 0x80)
+            {
+                idx++;
+                continue;
+            }
+            else if (lead < 0xC2)
+            {
+                return false; // continuation byte or overlong
+            }
+            else if (lead < 0xE0)
+            {
+                length = 2;
+            }
+            else if (lead < 0xF0)
+            {
+                length = 3;
+            }
+            else if (lead < 0xF5)
+            {
+                length = 4;
+            }
+            else
+            {
+                return false;
+            }
+
+            if (idx + length > size)
+            {
+                size = idx; // incomplete tail
+                return true;
+            }
+
+            for (size_t i = 1; i < length; i++)
+            {
+                unsigned char next = ptr[idx + i];
+                if ((next & 0xC0) != 0x80)
+                {
+                    return false;
+                }
+
+                if (i == 1 && 
+                    ((lead == 0xE0 && next < 0xA0) ||
+                     (lead == 0xF0 && next < 0x90) ||
+                     (lead == 0xF4 && next >= 0x90)))
+                {
+                    return false; // overlong or out of range
+                }
+            }
+
+            idx += length;
+        }
+
+        return true;
+    }
+
+private:
+    const char* ptr_ = nullptr;
+    const char* end_ = nullptr;
+    const char* begin_ = nullptr; // offset 0 of the index
+    JsonIndexW index_;
+    std::unique_ptr<Source> source_; // stream only
+
+    enum Type type_ = Type::Null;
+    int_fast64_t integer_ = 0;
+    long double frac_ = 0.0;
+    std::string string_;
+    bool boolean_ = true;
+};
+
+// JsonArenaW holds the memory of the values parsed from one json text.
+// Values are carved out of big chunks and never freed one by one, the 
+// arena counts the blocks in use and releases all the chunks at once when
+// the last one is freed. Carving is not thread safe, the blocks of one 
+// arena should be allocated by one thread, but they can be freed anywhere.
+// JsonW caller does not need to access this class at all.
+class JsonArenaW
+{
+public:
+    // reference count starts from 0, every block in use holds a reference
+    static JsonArenaW* create()
+    {
+        return new JsonArenaW();
+    }
+
+    void retain()
+    {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    void* allocate(size_t size)
+    {
+        size = (size + kAlign - 1) & ~(kAlign - 1);
+
+        if (size > left_)
+        {
+            size_t chunksize = size + kAlign > next_ ? size + kAlign : next_;
+            char* chunk = (char*)::operator new(chunksize);
+
+            // first bytes of a chunk link to the previous chunk
+            *(char**)chunk = chunks_;
+            chunks_ = chunk;
+            ptr_ = chunk + kAlign;
+            left_ = chunksize - kAlign;
+
+            if (next_ < kMaxChunk)
+            {
+                next_ = next_ * 2;
+            }
+        }
+
+        void* ptr = ptr_;
+        ptr_ += size;
+        left_ -= size;
+        return ptr;
+    }
+
+private:
+    JsonArenaW()
+    {
+        ptr_ = first_;
+        left_ = sizeof(first_);
+    }
+
+    ~JsonArenaW()
+    {
+        while (chunks_ != nullptr)
+        {
+            char* chunk = chunks_;
+            chunks_ = *(char**)chunk;
+            ::operator delete(chunk);
+        }
+    }
+
+private:
+    const static size_t kAlign = 16;
+    const static size_t kMaxChunk = 64 * 1024;
+
+    std::atomic<size_t> refs_{ 0 };
+    char* chunks_ = nullptr;
+    char* ptr_ = nullptr;
+    size_t left_ = 0;
+    size_t next_ = 2048;
+
+    // a small text fits in the first block, no more allocation is needed
+    alignas(16) char first_[512];
+};
+
+// JsonAllocatorW allocates from a JsonArenaW, or from the heap if there 
+// is no arena. Each block from the arena keeps the arena alive until it is
+// deallocated, so a value can outlive the root it was parsed with. JsonW 
+// caller does not need to access this class at all.
+template <typename T>
+class JsonAllocatorW
+{
+public:
+    typedef T value_type;
+
+    explicit JsonAllocatorW(JsonArenaW* arena = nullptr) : arena_(arena)
+    {
+    }
+
+    template <typename U>
+    JsonAllocatorW(const JsonAllocatorW<U>& rhs) : arena_(rhs.arena())
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (arena_ != nullptr)
+        {
+            arena_->retain();
+            return (T*)arena_->allocate(n * sizeof(T));
+        }
+
+        return (T*)::operator new(n * sizeof(T));
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        if (arena_ != nullptr)
+        {
+            arena_->release();
+        }
+        else
+        {
+            ::operator delete(ptr);
+        }
+    }
+
+    JsonArenaW* arena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const JsonAllocatorW<U>& rhs) const { return arena_ == rhs.arena(); }
+
+    template <typename U>
+    bool operator!=(const JsonAllocatorW<U>& rhs) const { return arena_ != rhs.arena(); }
+
+private:
+    JsonArenaW* arena_;
+};
+
+template <typename Buffer>
+class JsonWriterW;
+
+// JsonW is one and the only one class that caller should access. It
+// represents a json 'value' defined in json standard. In other words,
+// JsonW could be a number, a string, a boolean, a null, a json array or
+// an json object. Strings and names are kept in utf8, the std::wstring
+// interface converts on the fly. Values parsed from one text share one
+// arena, an object keeps its name-value pairs sorted by name in a flat
+// vector. See README.md for the usage.
+class JsonW
+{
+private:
+    typedef std::string String;
+    typedef std::pair<std::string, std::shared_ptr<JsonW>> Member;
+    typedef std::vector<Member, JsonAllocatorW<Member>> Object;
+    typedef std::vector<std::shared_ptr<JsonW>, JsonAllocatorW<std::shared_ptr<JsonW>>> Array;
+
+    template <typename Buffer>
+    friend class JsonWriterW;
+    friend class JsonBindW;
+
+    // frozen root with its text, see freeze()
+    struct Frozen;
+
+public:
+    // type of jsonw
+    const static int BAD = 0;
+    const static int OBJECT = 1;    
+    const static int ARRAY  = 2;
+    const static int INTEGER  = 3;
+    const static int FLOAT = 4;
+    const static int STRING = 5;
+    const static int BOOLEAN = 6;
+    const static int NULLVALUE = 7;
+
+public:
+    // construtor and destructor
+    // 1. default constructor - NULL value
+    // 2. copy constructor - deep copy
+    // 3. construct by utf8 file input stream 
+    // 4. construct by utf8 string (std::string / const char*)
+    // 5. construct by ucs string (std::wstring / const wchar_t*)
+    // 6. construct by reading tokens (JsonTokenW)
+    // 7. destrcutor that calls help function clean()
+    JsonW()
+    {
+        type_ = NULLVALUE;
+        valid_ = true;
+    }
+
+    explicit JsonW(const JsonW& rhs)
+    {
+        copy(rhs);
+    }
+
+    explicit JsonW(std::ifstream& fin)
+    {
+        if (!fin.good())
+        {
+            return;
+        }
+
+        // tokens come chunk by chunk, the file is not read as a whole
+        JsonTokenW tokens(fin);
+        init(tokens);
+    }
+
+    explicit JsonW(const char* utf8str)
+    {
+        init(utf8str, std::char_traits<char>::length(utf8str));
+    }
+
+    explicit JsonW(const wchar_t* wstr)
+    {
+        // convert to utf8
+        std::string utf8str = toutf8(wstr);
+
+        init(utf8str.data(), utf8str.length());
+    }
+
+    JsonW(const wchar_t* ucsdata, size_t size)
+    {
+        // convert to utf8, unlike c string the NUL character is kept
+        std::string utf8str = toutf8(std::wstring(ucsdata, size));
+
+        init(utf8str.data(), utf8str.length(), false);
+    }
+
+    JsonW(const char* utf8data, size_t length)
+    {
+        init(utf8data, length);
+    }
+    
+    ~JsonW()
+    {
+        clean();
+    }
+
+public:    
+    JsonW(JsonTokenW& tokens)
+    {
+        Parser parser(tokens);
+        parse(parser);
+    }
+    
+private:
+    // private help data for parsing. Values of one json text are allocated
+    // from the same arena, the members of unfinished objects and arrays are
+    // stacked in one vector and moved into place in one go when it closes.
+    struct Parser
+    {
+        explicit Parser(JsonTokenW& tokens) : 
+            tokens_(tokens), alloc_(JsonArenaW::create())
+        {
+            // hold the arena in case nothing is allocated from it
+            alloc_.arena()->retain();
+        }
+
+        ~Parser()
+        {
+            alloc_.arena()->release();
+        }
+
+        Parser(const Parser&) = delete;
+        Parser& operator=(const Parser&) = delete;
+
+        JsonTokenW& tokens_;
+        JsonAllocatorW<JsonW> alloc_;
+        std::vector<Member> members_;
+        std::vector<std::shared_ptr<JsonW>> items_;
+    };
+
+    // read one json value, the current token is the first token of the 
+    // value, and it is the token after the value on return
+    void parse(Parser& parser)
+    {
+        JsonTokenW& tokens = parser.tokens_;
+
+        clean();
+        type_ = BAD;
+
+        switch (tokens.type())
+        {
+        case JsonTokenW::Type::LeftCurlyBracket: // object
+            valid_ = jobject(parser, *this);
+            return;
+        case JsonTokenW::Type::LeftSquareBracket: // array
+            valid_ = jarray(parser, *this);
+            return;
+        case JsonTokenW::Type::NumberInteger:
+            become(INTEGER);
+            integer_ = tokens.integer();
+            tokens.next();
+            return;
+        case JsonTokenW::Type::NumberFloat:
+            become(FLOAT);
+            frac_ = tokens.frac();
+            tokens.next();
+            return;
+        case JsonTokenW::Type::String:
+            become(STRING);
+            string_.swap(tokens.str());
+            tokens.next();
+            return;
+        case JsonTokenW::Type::Boolean:
+            become(BOOLEAN);
+            boolean_ = tokens.boolean();
+            tokens.next();
+            return;
+        case JsonTokenW::Type::Null:
+            become(NULLVALUE);
+            tokens.next();
+            return;
+        default: // bad token
+            valid_ = false;
+            return;
+        }
+    }
+
+    // deep copy from another JsonW except that the frozen values in it are
+    // shared, the copy lives on the heap
+    void copy(const JsonW& rhs)
+    {
+        become(rhs.type_);
+        boolean_ = rhs.boolean_;
+
+        switch (rhs.type_)
+        {
+        case INTEGER:
+            integer_ = rhs.integer_;
+            break;
+        case FLOAT:
+            frac_ = rhs.frac_;
+            break;
+        case STRING:
+            string_ = rhs.string_;
+            break;
+        case OBJECT:
+            jobject_.reserve(rhs.jobject_.size());
+            for (const auto& it : rhs.jobject_)
+            {
+                jobject_.push_back(Member(it.first, share(it.second)));
+            }
+            break;
+        case ARRAY:
+            jarray_.reserve(rhs.jarray_.size());
+            for (const auto& it : rhs.jarray_)
+            {
+                jarray_.push_back(share(it));
+            }
+            break;
+        }
+
+        valid_ = rhs.valid_;
+    }
+
+    // private help function, share a frozen value and copy the others
+    static std::shared_ptr<JsonW> share(const std::shared_ptr<const JsonW>& jvalue)
+    {
+        if (jvalue == nullptr || jvalue->frozen_)
+        {
+            return std::const_pointer_cast<JsonW>(jvalue);
+        }
+
+        return std::make_shared<JsonW>(*jvalue);
+    }
+
+    // private help function, freeze the value and everything in it
+    void seal()
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        frozen_ = true;
+
+        if (type_ == OBJECT)
+        {
+            for (const auto& it : jobject_)
+            {
+                if (it.second != nullptr)
+                {
+                    it.second->seal();
+                }
+            }
+        }
+        else if (type_ == ARRAY)
+        {
+            for (const auto& it : jarray_)
+            {
+                if (it != nullptr)
+                {
+                    it->seal();
+                }
+            }
+        }
+    }
+
+public:
+    // return false if json data is invalid
+    bool valid() const { return valid_; }
+    
+    // get type of jsonw
+    int type() const { return type_; }
+    
+    //
+    // simple data accessors
+    //
+
+    // get the number of data in this json value
+    // for number, string and boolean, return 1
+    // for array, return the number of values inside it
+    // for object, return the number of name-value pairs inside it
+    // others return 0
+    size_t size() const
+    {
+        switch (type_)
+        {
+        case BAD:
+            return 0;
+        case OBJECT:
+            return jobject_.size();
+        case ARRAY:
+            return jarray_.size();
+        case INTEGER:
+        case FLOAT:
+        case STRING:
+        case BOOLEAN:
+            return 1;
+        case NULLVALUE:
+        default:
+            return 0;
+        }
+    }
+
+    // value of another type reads as 0 or empty string
+    long long integer() const { return type_ == INTEGER ? integer_ : 0; }
+    long double frac() const { return type_ == FLOAT ? frac_ : 0.0; }    
+    std::wstring wstr() const { return toucs(str()); }
+    const std::string& str() const { return type_ == STRING ? string_ : nullstr(); }
+    bool boolean() const { return boolean_; }
+
+    void integer(long long integer)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(INTEGER);
+        integer_ = integer;
+    }
+
+    void frac(long double frac)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(FLOAT);
+        frac_ = frac;
+    }
+
+    void wstr(const std::wstring& wstr)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(STRING);
+        string_ = toutf8(wstr);
+    }
+
+    void wstr(const wchar_t* wstr)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(STRING);
+        string_ = toutf8(wstr);
+    }
+
+    void wstr(const wchar_t* wstr, size_t length)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(STRING);
+        std::wstring usc(wstr, length);
+        string_ = toutf8(usc);
+    }
+
+    void str(const std::string& str)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(STRING);
+        string_ = str;
+    }
+
+    void str(const char* str)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(STRING);
+        string_ = str;
+    }
+
+    void str(const char* str, size_t length)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(STRING);
+        string_.assign(str, length);
+    }
+
+    void boolean(bool boolean)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        become(BOOLEAN);
+        boolean_ = boolean;
+    }
+
+    void reset()
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        clean();
+    }
+
+    void json(const std::string& text)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        clean();
+        init(text.data(), text.length());
+    }
+
+    void json(const char* text)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        clean();
+        init(text, std::char_traits<char>::length(text));
+    }
+
+    void json(const char* text, size_t size)
+    {
+        if (frozen_)
+        {
+            return;
+        }
+
+        clean();
+        init(text, size);
+    }
+
+    //
+    // json object accessor member
+    //
+    
+    // return all available keys in either ucs or utf8 enconding
+    void wkeys(std::vector<std::wstring>& keys) const
+    {
+        if (type_ != OBJECT)
+        {
+            return;
+        }
+
+        for (const auto& it : jobject_)
+        {
+            keys.push_back(toucs(it.first));
+        }
+
+        return;
+    }
+
+    void keys(std::vector<std::string>& keys) const
+    {
+        if (type_ != OBJECT)
+        {
+            return;
+        }
+
+        for (const auto& it : jobject_)
+        {
+            keys.push_back(it.first);
+        }
+
+        return;
+    }
+
+    // get json value via specific key, return nullptr if
+    // no such entry or 'this' is not an json object
+    std::shared_ptr<JsonW> get(const std::wstring& wkey) const
+    {
+        return get(toutf8(wkey));
+    }
+
+    std::shared_ptr<JsonW> get(const std::string& key) const
+    {
+        if (type_ != OBJECT)
+        {
+            return nullptr;
+        }
+
+        // names of a small object are compared one by one
+        if (jobject_.size() <= 8)
+        {
+            for (const auto& it : jobject_)
+            {
+                if (it.first == key)
+                {
+                    return it.second;
+                }
+            }
+
+            return nullptr;
+        }
+
+        auto it = find(jobject_, key);
+        if (it == jobject_.end() || it->first != key)
+        {
+            return nullptr;
+        }
+
+        return it->second;
+    }
+    
+    // delete a name-pair value inside json object by the name
+    // return false if no such value
+    bool erase(std::wstring wkey)
+    {
+        return erase(toutf8(wkey));
+    }
+    
+    bool erase(std::string key)
+    {
+        if (frozen_)
+        {
+            return false;
+        }
+
+        if (type_ != OBJECT)
+        {
+            return false;
+        }
+
+        auto it = find(jobject_, key);
+        if (it == jobject_.end() || it->first != key)
+        {
+            return false;
+        }
+        
+        jobject_.erase(it);
+        return true;
+    }
+
+    // set json value using specific key, return false
+    // if key length is 0
+    bool add(std::wstring wkey, std::shared_ptr<JsonW> jvalue)
+    {
+        return add(toutf8(wkey), jvalue);
+    }
+
+    // a frozen value is shared, a value that is not frozen is copied
+    bool add(std::wstring wkey, std::shared_ptr<const JsonW> jvalue)
+    {
+        return add(toutf8(wkey), share(jvalue));
+    }
+
+    bool add(std::string key, std::shared_ptr<const JsonW> jvalue)
+    {
+        return add(key, share(jvalue));
+    }
+
+    bool add(std::string key, std::shared_ptr<JsonW> jvalue)
+    {
+        if (frozen_)
+        {
+            return false;
+        }
+
+        if (key.length() == 0)
+        {
+            return false;
+        }
+
+        if (type_ != OBJECT)
+        {
+            become(OBJECT);
+        }
+        
+        auto it = find(jobject_, key);
+        if (it != jobject_.end() && it->first == key)
+        {
+            it->second = jvalue;
+        }
+        else
+        {
+            jobject_.insert(it, Member(key, jvalue));
+        }
+
+        return true;
+    }
+
+    bool add(std::wstring wkey, long long integer)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->integer(integer);
+        return add(wkey, jvalue);
+    }
+
+    bool add(std::wstring wkey, long integer)
+    {
+        return add(wkey, (long long)integer);
+    }
+
+    bool add(std::wstring wkey, int integer)
+    {
+        return add(wkey, (long long)integer);
+    }
+
+    bool add(std::wstring wkey, short integer)
+    {
+        return add(wkey, (long long)integer);
+    }
+
+    bool add(std::string key, long long integer)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->integer(integer);
+        return add(key, jvalue);
+    }
+
+    bool add(std::string key, long integer)
+    {
+        return add(key, (long long)integer);
+    }
+
+    bool add(std::string key, int integer)
+    {
+        return add(key, (long long)integer);
+    }
+
+    bool add(std::string key, short integer)
+    {
+        return add(key, (long long)integer);
+    }
+
+    bool add(std::wstring wkey, long double frac)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->frac(frac);
+        return add(wkey, jvalue);
+    }
+
+    bool add(std::wstring wkey, double frac)
+    {
+        return add(wkey, (long double)frac);
+    }
+
+    bool add(std::wstring wkey, float frac)
+    {
+        return add(wkey, (long double)frac);
+    }
+
+    bool add(std::string key, long double frac)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->frac(frac);
+        return add(key, jvalue);
+    }
+
+    bool add(std::string key, double frac)
+    {
+        return add(key, (long double)frac);
+    }
+
+    bool add(std::string key, float frac)
+    {
+        return add(key, (long double)frac);
+    }
+
+    bool add(std::wstring wkey, std::wstring wstr)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->wstr(wstr);
+        return add(wkey, jvalue);
+    }
+
+    bool add(std::string key, std::string str)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->str(str);
+        return add(key, jvalue);
+    }
+
+    bool add(std::wstring wkey, bool boolean )
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->boolean(boolean);
+        return add(wkey, jvalue);
+    }
+
+    bool add(std::string key, bool boolean)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->boolean(boolean);
+        return add(key, jvalue);
+    }
+
+    //
+    // json array accessors
+    //
+
+    // retrieve the json value in array
+    std::shared_ptr<JsonW> get(size_t idx) const
+    {
+        if (type_ != ARRAY || idx >= jarray_.size())
+        {
+            return nullptr;
+        }
+
+        return jarray_.at(idx);
+    }
+
+    // add one json value into array, a frozen value is shared and a value
+    // that is not frozen is copied
+    bool add(std::shared_ptr<const JsonW> junit)
+    {
+        return add(share(junit));
+    }
+
+    // add one json value into array
+    bool add(std::shared_ptr<JsonW> junit)
+    {
+        if (frozen_)
+        {
+            return false;
+        }
+
+        if (type_ != ARRAY)
+        {
+            become(ARRAY);
+        }
+
+        if (junit == nullptr)
+        {
+            // NULLVALUE json value
+            jarray_.push_back(std::make_shared<JsonW>());
+        }
+        else
+        {
+            jarray_.push_back(junit);
+        }
+        
+        valid_ = true;        
+        return true;
+    }
+
+    bool add(long long integer)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->integer(integer);
+        return add(jvalue);
+    }
 
-public:
-    // construtor and destructor
-    // 1. default constructor - NULL value
-    // 2. copy constructor - deep copy
-    // 3. construct by utf8 file input stream 
-    // 4. construct by utf8 string (std::string / const char*)
-    // 5. construct by ucs string (std::wstring / const wchar_t*)
-    // 6. construct by a sequence of token (JsonTokenW)
-    // 7. destrcutor that calls help function clean()
-    JsonW()
+    bool add(long integer)
     {
-        type_ = NULLVALUE;
-        valid_ = true;
+        return add((long long)integer);
     }
 
-    explicit JsonW(const JsonW& rhs)
+    bool add(int integer)
     {
-        copy(rhs);
+        return add((long long)integer);
     }
 
-    explicit JsonW(std::ifstream& fin)
+    bool add(short integer)
     {
-        if (!fin.good())
+        return add((long long)integer);
+    }
+
+    bool add(long double frac)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->frac(frac);
+        return add(jvalue);
+    }
+
+    bool add(double frac)
+    {
+        return add((long double)frac);
+    }
+
+    bool add(float frac)
+    {
+        return add((long double)frac);
+    }
+
+    bool add(std::wstring wstr)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->wstr(wstr);
+        return add(jvalue);
+    }
+
+    bool add(std::string str)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->str(str);
+        return add(jvalue);
+    }
+
+    bool add(bool boolean)
+    {
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
+        jvalue->boolean(boolean);
+        return add(jvalue);
+    }
+    
+    // delete a value inside json array by index, 
+    // return false if no such value.
+    bool erase(size_t idx)
+    {
+        if (frozen_)
         {
-            return;
+            return false;
         }
 
-        // convert to std::string
-        std::string utf8str(
-            (std::istreambuf_iterator<char>(fin)),
-            (std::istreambuf_iterator<char>()));
+        if ( type_ != ARRAY )
+        {
+            return false;
+        }
 
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wstr = conv.from_bytes(utf8str);
+        if ( size() <= idx )
+        {
+            return false;
+        }
+
+        jarray_.erase( jarray_.begin() + idx );
+        
+        return true;
+    }
 
-        // convert to wstringbuf
-        std::wstringbuf strBuf(wstr.data());
+public:    
+    //
+    // operator overloading
+    //
+    JsonW& operator=(short value)
+    {
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        // convert to wistream
-        std::wistream wins(&strBuf);
+        become(INTEGER);
+        integer_ = value;
 
-        // constructor with std::wstring parameter
-        init(wins);
+        return *this;
     }
 
-    explicit JsonW(const char* utf8str)
+    JsonW& operator=(int value)
     {
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wstr = conv.from_bytes(utf8str);
-
-        // convert to wstringbuf
-        std::wstringbuf strBuf(wstr.data());
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        // convert to wistream
-        std::wistream wins(&strBuf);
+        become(INTEGER);
+        integer_ = value;
 
-        // constructor with std::wstring parameter
-        init(wins);
+        return *this;
     }
 
-    explicit JsonW(const wchar_t* wstr)
+    JsonW& operator=( long value )
     {
-        // convert to wstringbuf
-        std::wstringbuf strBuf(wstr);
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        // convert to wistream
-        std::wistream wins(&strBuf);
+        become(INTEGER);
+        integer_ = value;
 
-        // constructor with wistream parameter 
-        init(wins);
+        return *this;
     }
 
-    JsonW(const wchar_t* ucsdata, size_t size)
+    JsonW& operator=(long long value)
     {
-        // convert to std::wstring
-        std::wstring wstr(ucsdata, size);
+        if (frozen_)
+        {
+            return *this;
+        }
+
+        become(INTEGER);
+        integer_ = value;
 
-        // convert to wstringbuf
-        std::wstringbuf strBuf(wstr);
+        return *this;
+    }
+    
+    JsonW& operator=(long double value)
+    {
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        // convert to wistream
-        std::wistream wins(&strBuf);
+        become(FLOAT);
+        frac_ = value;
 
-        // constructor with wistream parameter 
-        init(wins);
+        return *this;
     }
 
-    JsonW(const char* utf8data, size_t length)
+    JsonW& operator=(double value)
+    {
+        if (frozen_)
+        {
+            return *this;
+        }
+
+        become(FLOAT);
+        frac_ = value;
+
+        return *this;
+    }
+
+    JsonW& operator=(float value)
     {
-        // convert to std::string
-        std::string utf8str(utf8data, length);
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wstr = conv.from_bytes(utf8str);
+        become(FLOAT);
+        frac_ = value;
+
+        return *this;
+    }
 
-        // convert to wstringbuf
-        std::wstringbuf strBuf(wstr.data());
+    JsonW& operator=(const wchar_t* value)
+    {
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        // convert to wistream
-        std::wistream wins(&strBuf);
+        become(STRING);
+        string_ = toutf8(value);
 
-        // constructor with std::wstring parameter
-        init(wins);
+        return *this;
     }
     
-    ~JsonW()
+    JsonW& operator=(const std::wstring& value)
     {
-        clean();
+        if (frozen_)
+        {
+            return *this;
+        }
+
+        become(STRING);
+        string_ = toutf8(value);
+
+        return *this;
     }
 
-public:    
-    JsonW(std::queue<JsonTokenW>& tokens)
+    JsonW& operator=(const char* value)
     {
-        parse(tokens);
+        if (frozen_)
+        {
+            return *this;
+        }
+
+        become(STRING);
+        string_ = value;
+
+        return *this;
     }
-    
-private:
-    // read json data from a sequence of tokens
-    void parse(std::queue<JsonTokenW>& tokens)
+
+    JsonW& operator=(std::string value)
     {
-        clean();
-        type_ = BAD;
+        if (frozen_)
+        {
+            return *this;
+        }
 
-        if (tokens.empty())
-            return;
+        become(STRING);
+        string_ = value;
 
-        valid_ = true;
+        return *this;
+    }
+   
+    JsonW& operator=(bool boolean)
+    {
+        if (frozen_)
+        {
+            return *this;
+        }
+
+        become(BOOLEAN);
+        boolean_ = boolean;
 
-        switch (tokens.front().type())
+        return *this;
+    }    
+        
+    JsonW& operator=(const JsonW& junit)
+    {
+        if (this != &junit && !frozen_)
         {
-        case JsonTokenW::Type::LeftCurlyBracket: // object
-            valid_ = jobject(tokens, jobject_);
-            if (valid_)
+            copy(junit);
+        }
+        return *this;
+    }
+
+    JsonW& operator[] (size_t index)
+    {
+        if (frozen_)
+        {
+            return index < size() ? *(get(index)) : bad();
+        }
+
+        if (type_ != ARRAY)
+        {
+            become(ARRAY);
+        }
+
+        if (index >= size())
+        {
+            for (size_t i = size(); i <= index; i++)
             {
-                type_ = OBJECT;
+                add(std::make_shared<JsonW>());
             }
-            return;
-        case JsonTokenW::Type::LeftSquareBracket: // array
-            valid_ = jarray(tokens, jarray_);
-            if (valid_)
+        }
+
+        return *(get(index));
+    }
+
+    JsonW& operator[] (int index)
+    {
+        if (index < 0)
+        {
+            return bad();
+        }
+
+        if (frozen_)
+        {
+            return (size_t)index < size() ? *(get(index)) : bad();
+        }
+
+        if (type_ != ARRAY)
+        {
+            become(ARRAY);
+        }
+
+        if (index >= (int)size())
+        {
+            for (size_t i = size(); i <= (size_t)index; i++)
             {
-                type_ = ARRAY;
+                add(std::make_shared<JsonW>());
             }
-            return;
-        case JsonTokenW::Type::NumberInteger:
-            type_ = INTEGER;
-            integer_ = tokens.front().integer();
-            tokens.pop();
-            return;
-        case JsonTokenW::Type::NumberFloat:
-            type_ = FLOAT;
-            frac_ = tokens.front().frac();
-            tokens.pop();
-            return;
-        case JsonTokenW::Type::String:
-            type_ = STRING;
-            wstring_ = tokens.front().wstring();
-            tokens.pop();
-            return;
-        case JsonTokenW::Type::Boolean:
-            type_ = BOOLEAN;
-            boolean_ = tokens.front().boolean();
-            tokens.pop();
-            return;
-        case JsonTokenW::Type::Null:
-            type_ = NULLVALUE;
-            tokens.pop();
-            return;
-        default: // bad token
-            valid_ = false;
-            return;
         }
+
+        return *(get(index));
     }
 
-    // deep copy from another JsonW
-    void copy(const JsonW& rhs)
+    JsonW& operator[] (const char* name)
     {
-        clean();
-
-        type_ = rhs.type_;
-        valid_ = rhs.valid_;
-        integer_ = rhs.integer_;
-        frac_ = rhs.frac_;
-        wstring_ = rhs.wstring_;
-        boolean_ = rhs.boolean_;
+        return (*this)[std::string(name)];
+    }
 
-        for (const auto& it : rhs.jobject_)
+    JsonW& operator[] (const std::string& name)
+    {
+        if (name.length() == 0)
         {
-            std::wstring name = it.first;
-
-            std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>(*(it.second.get()));
-            jobject_[name] = jvalue;
+            return bad();
         }
 
-        for (const auto& it : rhs.jarray_)
+        if (frozen_)
         {
-            std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>(*(it.get()));
-            jarray_.push_back(jvalue);
+            std::shared_ptr<JsonW> jvalue = get(name);
+            return jvalue != nullptr ? *jvalue : bad();
         }
-    }
 
-public:
-    // return false if json data is invalid
-    bool valid() const { return valid_; }
-    
-    // get type of jsonw
-    int type() const { return type_; }
-    
-    //
-    // simple data accessors
-    //
+        if (type_ != OBJECT)
+        {
+            become(OBJECT);
+        }
 
-    // get the number of data in this json value
-    // for number, string and boolean, return 1
-    // for array, return the number of values inside it
-    // for object, return the number of name-value pairs inside it
-    // others return 0
-    size_t size() const
-    {
-        switch (type_)
+        auto it = find(jobject_, name);
+        if (it == jobject_.end() || it->first != name)
         {
-        case BAD:
-            return 0;
-        case OBJECT:
-            return jobject_.size();
-        case ARRAY:
-            return jarray_.size();
-        case INTEGER:
-        case FLOAT:
-        case STRING:
-        case BOOLEAN:
-            return 1;
-        case NULLVALUE:
-        default:
-            return 0;
+            it = jobject_.insert(it, Member(name, std::make_shared<JsonW>()));
         }
-    }
 
-    long long integer() const { return integer_; }
-    long double frac() const { return frac_; }    
-    std::wstring wstr() const { return wstring_; }
-    std::string str() const
-    {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        return conv.to_bytes(wstring_);
+        return *(it->second);
     }
-    bool boolean() const { return boolean_; }
 
-    void integer(long long integer)
+    JsonW& operator[] (const wchar_t* name)
     {
-        clean();
-        type_ = INTEGER;
-        integer_ = integer;
+        return (*this)[toutf8(name)];
     }
 
-    void frac(long double frac)
+    JsonW& operator[] (const std::wstring& wname)
     {
-        clean();
-        type_ = FLOAT;
-        frac_ = frac;
+        return (*this)[toutf8(wname)];
     }
 
-    void wstr(const std::wstring& wstr)
+    // format json data into ucs text
+    std::wstring wtext( bool singleline = true ) const
     {
-        clean();
-        type_ = STRING;
-        wstring_ = wstr;
+        return toucs(text( singleline ));
     }
 
-    void wstr(const wchar_t* wstr)
-    {
-        clean();
-        type_ = STRING;
-        wstring_ = wstr;
-    }
+    // format json data into utf8 text in json standard, see JsonWriterW
+    // for writing into an existing buffer
+    std::string text( bool singleline = true ) const;
 
-    void wstr(const wchar_t* wstr, size_t length)
-    {
-        clean();
-        type_ = STRING;
-        std::wstring usc(wstr, length);
-        wstring_ = usc;
-    }
+    // freeze a copy of the value. Nothing in a frozen value can be changed
+    // any more, setters, add() and erase() on it do nothing, so it can be 
+    // shared by many documents and threads. Adding it into a document, or
+    // copying a document that holds it, shares it instead of copying, and
+    // its single line text is written once here and reused by JsonWriterW.
+    static std::shared_ptr<const JsonW> freeze(const JsonW& jvalue);
 
-    void str(const std::string& str)
+    bool frozen() const { return frozen_; }
+
+    friend std::ostream& operator<<(std::ostream& os, const JsonW& rhs)
     {
-        clean();
-        type_ = STRING;
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        wstring_ = conv.from_bytes(str);
+        os << rhs.text();
+        return os;
     }
 
-    void str(const char* str)
+    friend std::wostream& operator<<(std::wostream& wos, const JsonW& rhs)
     {
-        clean();
-        type_ = STRING;
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        wstring_ = conv.from_bytes(str);
+        wos << rhs.wtext();
+        return wos;
     }
 
-    void str(const char* str, size_t length)
+public:
+    // Singleton bad JsonW instance
+    static JsonW& bad()
     {
-        clean();
-        type_ = STRING;
-        std::string utf8(str, length);
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        wstring_ = conv.from_bytes(utf8);
+        static JsonW instance;
+        instance.clean();
+        instance.type_ = BAD;
+        instance.valid_ = false;
+        return instance;
     }
 
-    void boolean(bool boolean)
+private:
+    // empty string for str() of non-string value
+    static const std::string& nullstr()
     {
-        clean();
-        type_ = BOOLEAN;
-        boolean_ = boolean;
+        static const std::string instance;
+        return instance;
     }
 
-    void reset()
+private:
+    // private static help function - parse tokens into json object,
+    // 'jobject' becomes an object only if the whole object is valid
+    static bool jobject(Parser& parser, JsonW& jobject)
     {
-        clean();
+        JsonTokenW& tokens = parser.tokens_;
+        std::vector<Member>& members = parser.members_;
+        size_t base = members.size();
+        bool closed = false;
+
+        // Object must start with LeftCurlyBracket:'{'
+        if (tokens.type() != JsonTokenW::Type::LeftCurlyBracket)
+        {
+            return false;
+        }
+        tokens.next();
+
+        while (!closed)
+        {
+            std::string key;
+
+            if (tokens.type() == JsonTokenW::Type::RightCurlyBracket)
+            {
+                tokens.next();
+                closed = true;
+                break;
+            }
+            else if (tokens.type() != JsonTokenW::Type::String)
+            {
+                break;
+            }
+
+            key.swap(tokens.str());
+            if (key.length() == 0 || tokens.next() != JsonTokenW::Type::Colon)
+            {
+                break;
+            }
+
+            tokens.next();
+            std::shared_ptr<JsonW> junit = std::allocate_shared<JsonW>(parser.alloc_);
+            junit->parse(parser);
+            if (junit->valid() == false)
+            {
+                break;
+            }
+
+            members.push_back(Member(std::move(key), std::move(junit)));
+
+            if (tokens.type() == JsonTokenW::Type::Comma)
+            {
+                // consume comma and expect next key-data set
+                tokens.next();
+            }
+        }
+
+        // sort by name, duplicate key is not allowed
+        std::sort(members.begin() + base, members.end(), 
+            [](const Member& lhs, const Member& rhs) { return lhs.first < rhs.first; });
+
+        for (size_t i = base + 1; closed && i < members.size(); i++)
+        {
+            if (members[i].first == members[i - 1].first)
+            {
+                closed = false;
+            }
+        }
+
+        if (closed)
+        {
+            jobject.become(OBJECT, parser.alloc_.arena());
+            jobject.jobject_.reserve(members.size() - base);
+            for (size_t i = base; i < members.size(); i++)
+            {
+                jobject.jobject_.push_back(std::move(members[i]));
+            }
+        }
+
+        members.erase(members.begin() + base, members.end());
+        return closed;
     }
 
-    void json(const std::string& text)
+    // private static help function - parse tokens into json array,
+    // 'jarray' becomes an array only if the whole array is valid
+    static bool jarray(Parser& parser, JsonW& jarray)
     {
-        clean();
+        JsonTokenW& tokens = parser.tokens_;
+        std::vector<std::shared_ptr<JsonW>>& items = parser.items_;
+        size_t base = items.size();
+        bool closed = false;
 
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wstr = conv.from_bytes(text);
+        // Array must start with LeftSquareBracket:'['
+        if (tokens.type() != JsonTokenW::Type::LeftSquareBracket)
+        {
+            return false;
+        }
+        tokens.next();
+
+        if (tokens.type() == JsonTokenW::Type::RightSquareBracket)
+        {
+            tokens.next();
+            closed = true;
+        }
+
+        while (!closed)
+        {
+            switch (tokens.type())
+            {
+            case JsonTokenW::Type::LeftCurlyBracket:
+            case JsonTokenW::Type::LeftSquareBracket:
+            case JsonTokenW::Type::NumberInteger:
+            case JsonTokenW::Type::NumberFloat:
+            case JsonTokenW::Type::Boolean:
+            case JsonTokenW::Type::String:
+            case JsonTokenW::Type::Null:
+                break;
+            default:
+                // invalid
+                items.erase(items.begin() + base, items.end());
+                return false;
+            }
+
+            std::shared_ptr<JsonW> junit = std::allocate_shared<JsonW>(parser.alloc_);
+            junit->parse(parser);
+            if (junit->valid() == false)
+            {
+                break;
+            }
+
+            items.push_back(std::move(junit));
 
-        // convert to wstringbuf
-        std::wstringbuf strBuf(wstr.data());
+            // if followed by comma, continually read next value, a comma 
+            // right before ']' is allowed
+            if (tokens.type() == JsonTokenW::Type::Comma)
+            {
+                tokens.next();
+                if (tokens.type() == JsonTokenW::Type::RightSquareBracket)
+                {
+                    tokens.next();
+                    closed = true;
+                }
+            }
+            else if (tokens.type() == JsonTokenW::Type::RightSquareBracket)
+            {
+                tokens.next();
+                closed = true;
+            }
+            else
+            {
+                break;
+            }
+        }
 
-        // convert to wistream
-        std::wistream wins(&strBuf);
+        if (closed)
+        {
+            jarray.become(ARRAY, parser.alloc_.arena());
+            jarray.jarray_.reserve(items.size() - base);
+            for (size_t i = base; i < items.size(); i++)
+            {
+                jarray.jarray_.push_back(std::move(items[i]));
+            }
+        }
 
-        // constructor with std::wstring parameter
-        init(wins);
+        items.erase(items.begin() + base, items.end());
+        return closed;
     }
 
-    void json(const char* text)
+    // private static help function, position of 'key' in sorted members, 
+    // or the position to insert it
+    static Object::iterator find(Object& jobject, const std::string& key)
     {
-        std::string utf8(text);
-        json(utf8);
+        return std::lower_bound(jobject.begin(), jobject.end(), key,
+            [](const Member& lhs, const std::string& rhs) { return lhs.first < rhs; });
     }
 
-    void json(const char* text, size_t size)
+    static Object::const_iterator find(const Object& jobject, const std::string& key)
     {
-        std::string utf8(text, size);
-        json(utf8);
+        return std::lower_bound(jobject.begin(), jobject.end(), key,
+            [](const Member& lhs, const std::string& rhs) { return lhs.first < rhs; });
     }
-
-    //
-    // json object accessor member
-    //
     
-    // return all available keys in either ucs or utf8 enconding
-    void wkeys(std::vector<std::wstring>& keys) const
+private:
+    // private help function, release all resource 
+    void clean()
     {
-        auto it = jobject_.begin();
-
-        while (it != jobject_.end())
+        switch (type_)
         {
-            keys.push_back(it->first);
-            it++;
+        case STRING:
+            string_.~String();
+            break;
+        case OBJECT:
+            jobject_.~Object();
+            break;
+        case ARRAY:
+            jarray_.~Array();
+            break;
         }
 
-        return;
+        type_ = NULLVALUE;
+        valid_ = true;
     }
 
-    void keys(std::vector<std::string>& keys) const
+    // private help function, release all resource and become an empty 
+    // value of 'type', object and array take their memory from 'arena'
+    // or from the heap if it is nullptr
+    void become(int type, JsonArenaW* arena = nullptr)
     {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        auto it = jobject_.begin();
+        clean();
 
-        while (it != jobject_.end())
+        switch (type)
         {
-            keys.push_back(conv.to_bytes(it->first));
-            it++;
+        case INTEGER:
+            integer_ = 0;
+            break;
+        case FLOAT:
+            frac_ = 0.0;
+            break;
+        case STRING:
+            new (&string_) String();
+            break;
+        case OBJECT:
+            new (&jobject_) Object(JsonAllocatorW<Member>(arena));
+            break;
+        case ARRAY:
+            new (&jarray_) Array(JsonAllocatorW<std::shared_ptr<JsonW>>(arena));
+            break;
         }
 
-        return;
+        type_ = type;
     }
 
-    // get json value via specific key, return nullptr if
-    // no such entry or 'this' is not an json object
-    std::shared_ptr<JsonW> get(const std::wstring& wkey) const
+    // private help function, read json data from utf8 text, text stops 
+    // at the first NUL character if it comes from a c string
+    void init(const char* utf8data, size_t size, bool cstring = true)
     {
-        auto it = jobject_.find(wkey);
-        if (it == jobject_.end())
+        if (!JsonTokenW::utf8valid(utf8data, size))
         {
-            return nullptr;
+            type_ = BAD;
+            valid_ = false;
+            return;
         }
 
-        return it->second;
-    }
+        if (cstring)
+        {
+            const char* nul = (const char*)memchr(utf8data, 0, size);
+            if (nul != nullptr)
+            {
+                size = nul - utf8data;
+            }
+        }
 
-    std::shared_ptr<JsonW> get(const std::string& key) const
-    {
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wkey = conv.from_bytes(key.data());
-        return get(wkey);
+        JsonTokenW tokens(utf8data, size);
+        init(tokens);
     }
-    
-    // delete a name-pair value inside json object by the name
-    // return false if no such value
-    bool erase(std::wstring wkey)
+
+    // private help function, read json data from tokens
+    void init(JsonTokenW& tokens)
     {
-        auto it = jobject_.find(wkey);
-        if (it == jobject_.end())
+        // no token at all, not a json value but not an error either
+        if (tokens.next() == JsonTokenW::Type::End)
         {
-            return false;
+            clean();
+            type_ = BAD;
+            return;
         }
-        
-        jobject_.erase(it);
-        return true;
-    }
-    
-    bool erase(std::string key)
-    {
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wkey = conv.from_bytes(key.data());
-        return erase(wkey);
-    }
 
-    // set json value using specific key, return false
-    // if key length is 0
-    bool add(std::wstring wkey, std::shared_ptr<JsonW> jvalue)
-    {
-        if (wkey.length() == 0)
+        Parser parser(tokens);
+        parse(parser);
+
+        // text after the value is ignored up to the first character that 
+        // cannot begin a token, but a bad token there makes the whole text BAD
+        while (tokens.type() != JsonTokenW::Type::End && 
+               tokens.type() != JsonTokenW::Type::Bad)
         {
-            return false;
+            tokens.next();
         }
 
-        if (type_ != OBJECT)
+        if (tokens.type() == JsonTokenW::Type::Bad)
         {
             clean();
-            type_ = OBJECT;
+            type_ = BAD;
         }
-        
-        auto it = jobject_.find(wkey);
-        jobject_[wkey] = jvalue;
-        return true;
     }
 
-    bool add(std::string key, std::shared_ptr<JsonW> jvalue)
+    // private help function, ucs and utf8 conversion for the wstring api,
+    // internal data are always in utf8
+    static std::string toutf8(const std::wstring& wstr)
+    {
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+        return conv.to_bytes(wstr);
+    }
+
+    static std::wstring toucs(const std::string& str)
+    {
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+        return conv.from_bytes(str);
+    }
+
+private:
+    // private member data
+    int type_ = NULLVALUE;
+    bool valid_ = false;
+    bool boolean_ = true;
+
+    // a frozen value cannot be changed, a frozen root also keeps its text,
+    // see freeze()
+    bool frozen_ = false;
+    bool cached_ = false;
+
+    // only the member of current type is alive, see become() and clean()
+    union
     {
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wkey = conv.from_bytes(key.data());
+        long long integer_;
+        long double frac_;
+        std::string string_;
+        Object jobject_;
+        Array jarray_;
+    };
 
-        return add(wkey, jvalue);
+};
+
+struct JsonW::Frozen : public JsonW
+{
+    std::string text_;
+};
+
+// JsonWriterW writes json text in utf8 straight into a growable byte 
+// buffer, a std::string or a std::vector<uint8_t>, without any temporary
+// string. Values are written one by one with begin_object(), key(), value()
+// and end(), commas are added automatically. A whole JsonW can be written
+// by value() in one line or by pretty() in the multi-line layout.
+template <typename Buffer>
+class JsonWriterW
+{
+public:
+    explicit JsonWriterW(Buffer& buffer) : buffer_(buffer)
+    {
     }
 
-    bool add(std::wstring wkey, long long integer)
+    void begin_object()
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->integer(integer);
-        return add(wkey, jvalue);
+        separate();
+        put('{');
+        scopes_.push_back('}');
+        comma_ = false;
     }
 
-    bool add(std::wstring wkey, long integer)
+    void begin_array()
     {
-        return add(wkey, (long long)integer);
+        separate();
+        put('[');
+        scopes_.push_back(']');
+        comma_ = false;
     }
 
-    bool add(std::wstring wkey, int integer)
+    // close the innermost object or array
+    void end()
     {
-        return add(wkey, (long long)integer);
+        if (scopes_.empty())
+        {
+            return;
+        }
+
+        put(scopes_.back());
+        scopes_.pop_back();
+        comma_ = true;
     }
 
-    bool add(std::wstring wkey, short integer)
+    // name of the next value inside an object
+    void key(const std::string& name)
     {
-        return add(wkey, (long long)integer);
+        key(name.data(), name.length());
     }
 
-    bool add(std::string key, long long integer)
+    void key(const char* name)
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->integer(integer);
-        return add(key, jvalue);
+        key(name, std::char_traits<char>::length(name));
     }
 
-    bool add(std::string key, long integer)
+    void key(const char* name, size_t length)
     {
-        return add(key, (long long)integer);
+        separate();
+        string(name, length);
+        put(':');
+        comma_ = false;
     }
 
-    bool add(std::string key, int integer)
+    void value(long long integer)
     {
-        return add(key, (long long)integer);
+        separate();
+        number(integer);
+        comma_ = true;
     }
 
-    bool add(std::string key, short integer)
+    void value(long integer)
     {
-        return add(key, (long long)integer);
+        value((long long)integer);
     }
 
-    bool add(std::wstring wkey, long double frac)
+    void value(int integer)
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->frac(frac);
-        return add(wkey, jvalue);
+        value((long long)integer);
     }
 
-    bool add(std::wstring wkey, double frac)
+    void value(short integer)
     {
-        return add(wkey, (long double)frac);
+        value((long long)integer);
     }
 
-    bool add(std::wstring wkey, float frac)
+    void value(long double frac)
     {
-        return add(wkey, (long double)frac);
+        separate();
+        number(frac);
+        comma_ = true;
     }
 
-    bool add(std::string key, long double frac)
+    void value(double frac)
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->frac(frac);
-        return add(key, jvalue);
+        value((long double)frac);
     }
 
-    bool add(std::string key, double frac)
+    void value(float frac)
     {
-        return add(key, (long double)frac);
+        value((long double)frac);
     }
 
-    bool add(std::string key, float frac)
+    void value(const std::string& str)
     {
-        return add(key, (long double)frac);
+        value(str.data(), str.length());
     }
 
-    bool add(std::wstring wkey, std::wstring wstr)
+    void value(const char* str)
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->wstr(wstr);
-        return add(wkey, jvalue);
+        value(str, std::char_traits<char>::length(str));
     }
 
-    bool add(std::string key, std::string str)
+    void value(const char* str, size_t length)
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->str(str);
-        return add(key, jvalue);
+        separate();
+        string(str, length);
+        comma_ = true;
     }
 
-    bool add(std::wstring wkey, bool boolean )
+    void value(bool boolean)
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->boolean(boolean);
-        return add(wkey, jvalue);
+        separate();
+        boolean ? put("true", 4) : put("false", 5);
+        comma_ = true;
     }
 
-    bool add(std::string key, bool boolean)
+    void null()
     {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->boolean(boolean);
-        return add(key, jvalue);
+        separate();
+        put("null", 4);
+        comma_ = true;
     }
 
-    //
-    // json array accessors
-    //
+    // whole json value in one line, same as JsonW::text()
+    void value(const JsonW& jvalue)
+    {
+        separate();
+        write(jvalue);
+        comma_ = true;
+    }
 
-    // retrieve the json value in array
-    std::shared_ptr<JsonW> get(size_t idx) const
+    // whole json value in multiple lines, same as JsonW::text(false). 
+    // Short array and object stay in one line.
+    void pretty(const JsonW& jvalue)
     {
-        if (idx >= jarray_.size())
+        separate();
+
+        if (jvalue.type() == JsonW::OBJECT)
         {
-            return nullptr;
+            pretty_object(jvalue, 0, false);
+        }
+        else if (jvalue.type() == JsonW::ARRAY && width(jvalue) > kWidth)
+        {
+            pretty_array(jvalue, 0, false);
+        }
+        else
+        {
+            write(jvalue);
         }
 
-        return jarray_.at(idx);
+        comma_ = true;
     }
 
-    // add one json value into array
-    bool add(std::shared_ptr<JsonW> junit)
+private:
+    // write json value in one line, stop writing once buffer size 
+    // exceeds limit_
+    void write(const JsonW& jvalue)
     {
-        if (type_ != ARRAY)
+        if (jvalue.valid() == false || buffer_.size() > limit_)
         {
-            clean();
-            type_ = ARRAY;
+            return;
         }
 
-        if (junit == nullptr)
+        if (jvalue.cached_)
         {
-            // NULLVALUE json value
-            jarray_.push_back(std::make_shared<JsonW>());
+            const std::string& text = static_cast<const JsonW::Frozen&>(jvalue).text_;
+            put(text.data(), text.length());
+            return;
         }
-        else
+
+        switch (jvalue.type())
         {
-            jarray_.push_back(junit);
-        }
-        
-        valid_ = true;        
-        return true;
-    }
+        case JsonW::INTEGER:
+            number(jvalue.integer_);
+            return;
+        case JsonW::FLOAT:
+            number(jvalue.frac_);
+            return;
+        case JsonW::BOOLEAN:
+            jvalue.boolean_ ? put("true", 4) : put("false", 5);
+            return;
+        case JsonW::NULLVALUE:
+            put("null", 4);
+            return;
+        case JsonW::STRING:
+            string(jvalue.string_.data(), jvalue.string_.length());
+            return;
+        case JsonW::OBJECT:
+        {
+            bool first = true;
+            put('{');
+            for (const auto& it : jvalue.jobject_)
+            {
+                if (!first)
+                {
+                    put(',');
+                }
+                first = false;
 
-    bool add(long long integer)
-    {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->integer(integer);
-        return add(jvalue);
-    }
+                string(it.first.data(), it.first.length());
+                put(':');
+                if (it.second != nullptr)
+                {
+                    write(*it.second);
+                }
+            }
+            put('}');
+            return;
+        }
+        case JsonW::ARRAY:
+        {
+            bool first = true;
+            put('[');
+            for (const auto& it : jvalue.jarray_)
+            {
+                if (!first)
+                {
+                    put(',');
+                }
+                first = false;
 
-    bool add(long integer)
-    {
-        return add((long long)integer);
+                write(*it);
+            }
+            put(']');
+            return;
+        }
+        case JsonW::BAD:
+        default:
+            return;
+        }
     }
 
-    bool add(int integer)
+    // write object in multiple lines, a member goes to next line if it is 
+    // an object with more than one member, or an array that is long or 
+    // contains object or array
+    void pretty_object(const JsonW& jobject, size_t level, bool addcomma)
     {
-        return add((long long)integer);
-    }
+        size_t count = 0;
 
-    bool add(short integer)
-    {
-        return add((long long)integer);
-    }
+        indent(level);
+        put("{\n", 2);
 
-    bool add(long double frac)
-    {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->frac(frac);
-        return add(jvalue);
-    }
+        for (const auto& it : jobject.jobject_)
+        {
+            const JsonW& jvalue = it.second != nullptr ? *it.second : JsonW::bad();
+            bool last = (++count == jobject.jobject_.size());
+            bool newline = false;
 
-    bool add(double frac)
-    {
-        return add((long double)frac);
-    }
+            indent(level + 1);
+            string(it.first.data(), it.first.length());
+            put(':');
 
-    bool add(float frac)
-    {
-        return add((long double)frac);
-    }
+            if (jvalue.type() == JsonW::OBJECT && jvalue.size() > 1)
+            {
+                newline = true;
+            }
+            else if (jvalue.type() == JsonW::ARRAY)
+            {
+                for (const auto& item : jvalue.jarray_)
+                {
+                    if (item->type() == JsonW::ARRAY || item->type() == JsonW::OBJECT)
+                    {
+                        newline = true;
+                        break;
+                    }
+                }
 
-    bool add(std::wstring wstr)
-    {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->wstr(wstr);
-        return add(jvalue);
-    }
+                if (!newline && width(jvalue) > kWidth)
+                {
+                    newline = true;
+                }
+            }
 
-    bool add(std::string str)
-    {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->str(str);
-        return add(jvalue);
-    }
+            if (newline)
+            {
+                put('\n');
+            }
 
-    bool add(bool boolean)
-    {
-        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>();
-        jvalue->boolean(boolean);
-        return add(jvalue);
-    }
-    
-    // delete a value inside json array by index, 
-    // return false if no such value.
-    bool erase(size_t idx)
-    {
-        if ( type_ != ARRAY )
-        {
-            return false;
+            if (newline && !last)
+            {
+                if (jvalue.type() == JsonW::OBJECT)
+                {
+                    pretty_object(jvalue, level + 1, true);
+                }
+                else
+                {
+                    pretty_array(jvalue, level + 1, true);
+                }
+            }
+            else
+            {
+                // the last one stays in one line even after a line break
+                write(jvalue);
+                if (!last)
+                {
+                    put(',');
+                }
+                put('\n');
+            }
         }
 
-        if ( size() <= idx )
+        indent(level);
+        put('}');
+        if (addcomma)
         {
-            return false;
+            put(',');
         }
-
-        jarray_.erase( jarray_.begin() + idx );
-        
-        return true;
+        put('\n');
     }
 
-public:    
-    //
-    // operator overloading
-    //
-    JsonW& operator=(short value)
+    // write array in multiple lines, an item keeps in one line unless it is
+    // a long array, or a long object or an object with more than one member
+    void pretty_array(const JsonW& jarray, size_t level, bool addcomma)
     {
-        clean();
+        size_t count = 0;
 
-        type_ = INTEGER;
-        valid_ = true;
-        integer_ = value;
-
-        return *this;
-    }
+        indent(level);
+        put("[\n", 2);
 
-    JsonW& operator=(int value)
-    {
-        clean();
+        for (const auto& it : jarray.jarray_)
+        {
+            const JsonW& jvalue = *it;
+            bool last = (++count == jarray.jarray_.size());
 
-        type_ = INTEGER;
-        valid_ = true;
-        integer_ = value;
+            if (jvalue.type() == JsonW::OBJECT &&
+                (jvalue.size() > 1 || width(jvalue) > kWidth))
+            {
+                pretty_object(jvalue, level + 1, !last);
+            }
+            else if (jvalue.type() == JsonW::ARRAY && width(jvalue) > kWidth)
+            {
+                pretty_array(jvalue, level + 1, !last);
+            }
+            else
+            {
+                indent(level + 1);
+                write(jvalue);
+                if (!last)
+                {
+                    put(',');
+                }
+                put('\n');
+            }
+        }
 
-        return *this;
+        indent(level);
+        put(']');
+        if (addcomma)
+        {
+            put(',');
+        }
+        put('\n');
     }
 
-    JsonW& operator=( long value )
+    // the number of characters of jvalue in one line, only the first few
+    // are written so it counts up to a bit more than kWidth
+    static size_t width(const JsonW& jvalue)
     {
-        clean();
+        std::string text;
+        JsonWriterW<std::string> writer(text);
+        size_t length = 0;
 
-        type_ = INTEGER;
-        valid_ = true;
-        integer_ = value;
+        // a character takes 4 bytes at most
+        writer.limit_ = (kWidth + 1) * 4;
+        writer.write(jvalue);
 
-        return *this;
+        for (char character : text)
+        {
+            if ((character & 0xC0) != 0x80)
+            {
+                length++;
+            }
+        }
+
+        return length;
     }
 
-    JsonW& operator=(long long value)
+    void string(const char* str, size_t length)
     {
-        clean();
+        const char* end = str + (length > limit_ ? limit_ + 1 : length);
 
-        type_ = INTEGER;
-        valid_ = true;
-        integer_ = value;
+        put('\"');
 
-        return *this;
-    }
-    
-    JsonW& operator=(long double value)
-    {
-        clean();
+        while (str < end)
+        {
+            // copy plain characters in one go
+            const char* plain = str;
+            while (str < end && !isescaped(*str))
+            {
+                str++;
+            }
+            put(plain, str - plain);
 
-        type_ = FLOAT;
-        valid_ = true;
-        frac_ = value;
+            if (str == end)
+            {
+                break;
+            }
 
-        return *this;
+            switch (*str++)
+            {
+            case 0x22: put("\\\"", 2); break;
+            case 0x5C: put("\\\\", 2); break;
+            case 0x2F: put("\\/", 2); break;
+            case 0x08: put("\\b", 2); break;
+            case 0x0C: put("\\f", 2); break;
+            case 0x0A: put("\\n", 2); break;
+            case 0x0D: put("\\r", 2); break;
+            case 0x09: put("\\t", 2); break;
+            }
+        }
+
+        put('\"');
     }
 
-    JsonW& operator=(double value)
+    // determine if character is written as escape sequence
+    static bool isescaped(char character)
     {
-        clean();
-
-        type_ = FLOAT;
-        valid_ = true;
-        frac_ = value;
-
-        return *this;
+        switch (character)
+        {
+        case 0x22: case 0x5C: case 0x2F: case 0x08: 
+        case 0x0C: case 0x0A: case 0x0D: case 0x09:
+            return true;
+        default:
+            return false;
+        }
     }
 
-    JsonW& operator=(float value)
+    void number(long long integer)
     {
-        clean();
+        char text[24];
+        char* ptr = text + sizeof(text);
+        unsigned long long value = integer < 0 ? 0 - (unsigned long long)integer : integer;
 
-        type_ = FLOAT;
-        valid_ = true;
-        frac_ = value;
+        do
+        {
+            *--ptr = (char)('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
 
-        return *this;
+        if (integer < 0)
+        {
+            *--ptr = '-';
+        }
+
+        put(ptr, text + sizeof(text) - ptr);
     }
 
-    JsonW& operator=(const wchar_t* value)
+    // same as std::to_string(long double)
+    void number(long double frac)
     {
-        clean();
-
-        type_ = STRING;
-        valid_ = true;
-        wstring_ = value;
+        char text[64];
+        int length = snprintf(text, sizeof(text), "%Lf", frac);
 
-        return *this;
+        if (length >= (int)sizeof(text))
+        {
+            std::string str = std::to_string(frac);
+            put(str.data(), str.length());
+        }
+        else if (length > 0)
+        {
+            put(text, length);
+        }
     }
-    
-    JsonW& operator=(const std::wstring& value)
+
+    void indent(size_t level)
     {
-        clean();
+        buffer_.insert(buffer_.end(), level * 4, ' ');
+    }
 
-        type_ = STRING;
-        valid_ = true;
-        wstring_ = value;
+    void separate()
+    {
+        if (comma_)
+        {
+            put(',');
+        }
+    }
 
-        return *this;
+    void put(char character)
+    {
+        buffer_.push_back(character);
     }
 
-    JsonW& operator=(const char* value)
+    void put(const char* data, size_t length)
     {
-        clean();
+        buffer_.insert(buffer_.end(), data, data + length);
+    }
 
-        type_ = STRING;
-        valid_ = true;
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        wstring_ = conv.from_bytes(value);
+private:
+    template <typename Other>
+    friend class JsonWriterW;
 
-        return *this;
-    }
+    // line width for short array and object in pretty()
+    const static size_t kWidth = 20;
 
-    JsonW& operator=(std::string value)
-    {
-        clean();
+    Buffer& buffer_;
+    std::string scopes_;
+    bool comma_ = false;
+    size_t limit_ = (size_t)-1;
+};
 
-        type_ = STRING;
-        valid_ = true;
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        wstring_ = conv.from_bytes(value.data());
+inline std::string JsonW::text( bool singleline ) const
+{
+    std::string text;
+    JsonWriterW<std::string> writer(text);
 
-        return *this;
+    if (singleline)
+    {
+        writer.value(*this);
     }
-   
-    JsonW& operator=(bool boolean)
+    else
     {
-        clean();
+        writer.pretty(*this);
+    }
 
-        type_ = BOOLEAN;
-        valid_ = true;
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        boolean_ = boolean;
+    return text;
+}
 
-        return *this;
-    }    
-        
-    JsonW& operator=(const JsonW& junit)
+inline std::shared_ptr<const JsonW> JsonW::freeze(const JsonW& jvalue)
+{
+    std::shared_ptr<Frozen> jfrozen = std::make_shared<Frozen>();
+
+    jfrozen->copy(jvalue);
+    jfrozen->text_ = jfrozen->text();
+    jfrozen->seal();
+    jfrozen->cached_ = true;
+
+    return jfrozen;
+}
+
+// JsonReaderW pulls a json text event by event instead of building the
+// whole JsonW tree, so a large text can be walked with memory bounded by
+// its nesting depth. next() returns the next event, a key or a scalar is
+// read by str(), integer(), frac() or boolean(). skip() jumps over the 
+// current value and value() turns the current value into a JsonW. Text
+// rules are the same as JsonW, except that a duplicate key in an object
+// is not detected. The buffer or the stream has to outlive the 
+// JsonReaderW.
+class JsonReaderW
+{
+public:
+    enum class Event
     {
-        copy(junit);
-        return *this;
-    }
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+        Key,
+        String,
+        Integer,
+        Float,
+        Boolean,
+        Null,
+        End,
+        Error
+    };
 
-    JsonW& operator[] (size_t index)
+public:
+    // read utf8 json text, text stops at the first NUL character like the
+    // c string constructor of JsonW
+    JsonReaderW(const char* utf8data, size_t size) : tokens_(utf8data, 0)
     {
-        if (type_ != ARRAY)
+        if (!JsonTokenW::utf8valid(utf8data, size))
         {
-            clean();
-            type_ = ARRAY;
-            valid_ = true;
+            event_ = Event::Error;
+            return;
         }
 
-        if (index >= size())
+        const char* nul = (const char*)memchr(utf8data, 0, size);
+        if (nul != nullptr)
         {
-            for (size_t i = size(); i <= index; i++)
-            {
-                add(std::make_shared<JsonW>());
-            }
+            size = nul - utf8data;
         }
 
-        return *(get(index));
+        tokens_ = JsonTokenW(utf8data, size);
     }
 
-    JsonW& operator[] (int index)
+    // read utf8 json text from a stream chunk by chunk, memory is bounded
+    // by the chunk size and the longest token. Invalid utf8 is found when
+    // the reading reaches it and gives Event::Error there.
+    explicit JsonReaderW(std::istream& in) : tokens_(in)
     {
-        if (index < 0)
-        {
-            return bad();
-        }
+    }
 
-        if (type_ != ARRAY)
+    // read the next event. Event::End means the top level value is done,
+    // or there is no value at all. Event::Error means the text is not 
+    // valid json. Both of them end the reading, calling next() again 
+    // returns the same event.
+    Event next()
+    {
+        if (event_ == Event::End || event_ == Event::Error)
         {
-            clean();
-            type_ = ARRAY;
-            valid_ = true;
+            return event_;
         }
 
-        if (index >= (int)size())
+        if (event_ == Event::Key)
         {
-            for (size_t i = size(); i <= (size_t)index; i++)
-            {
-                add(std::make_shared<JsonW>());
-            }
+            return event_ = start(read());
         }
 
-        return *(get(index));
-    }
-
-    JsonW& operator[] (const char* name)
-    {
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wname = conv.from_bytes(name);
-
-        if (wname.length() == 0)
+        if (scopes_.empty())
         {
-            return bad();
+            return event_ = after_ ? finish() : start(read(), true);
         }
 
-        if (type_ != OBJECT)
-        {
-            clean();
-            type_ = OBJECT;
-            valid_ = true;
-        }
+        JsonTokenW::Type type = read();
 
-        if (jobject_.find(wname) == jobject_.end())
+        if (scopes_.back() == '{')
         {
-            jobject_.insert(std::pair<std::wstring, std::shared_ptr<JsonW>>(wname, std::make_shared<JsonW>()));
-        }
+            // comma between two name-value pairs is optional
+            if (after_ && type == JsonTokenW::Type::Comma)
+            {
+                type = read();
+            }
 
-        return *(jobject_.find(wname)->second);
-    }
+            if (type == JsonTokenW::Type::RightCurlyBracket)
+            {
+                return event_ = close();
+            }
 
-    JsonW& operator[] (const std::string& name)
-    {
-        // convert to wstring
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        std::wstring wname = conv.from_bytes(name);
+            if (type == JsonTokenW::Type::String && tokens_.str().length() > 0 &&
+                read() == JsonTokenW::Type::Colon)
+            {
+                return event_ = Event::Key;
+            }
 
-        if (wname.length() == 0)
-        {
-            return bad();
+            return event_ = Event::Error;
         }
 
-        if (type_ != OBJECT)
+        // a comma right before ']' is allowed
+        if (after_ && type == JsonTokenW::Type::Comma)
         {
-            clean();
-            type_ = OBJECT;
-            valid_ = true;
+            type = read();
+            if (type != JsonTokenW::Type::RightSquareBracket)
+            {
+                return event_ = start(type);
+            }
+        }
+        else if (after_ && type != JsonTokenW::Type::RightSquareBracket)
+        {
+            return event_ = Event::Error;
         }
 
-        if (jobject_.find(wname) == jobject_.end())
+        if (type == JsonTokenW::Type::RightSquareBracket)
         {
-            jobject_.insert(std::pair<std::wstring, std::shared_ptr<JsonW>>(wname, std::make_shared<JsonW>()));
+            return event_ = close();
         }
 
-        return *(jobject_.find(wname)->second);
+        return event_ = start(type);
     }
 
-    JsonW& operator[] (const wchar_t* name)
+    // skip the current value, that is the value after Event::Key, or the
+    // rest of the object or array after Event::StartObject or 
+    // Event::StartArray. The event becomes the last event of the value.
+    Event skip()
     {
-        // convert to wstring
-        std::wstring wname(name);
-
-        if (wname.length() == 0)
-        {
-            return bad();
-        }
-
-        if (type_ != OBJECT)
+        if (event_ == Event::Key)
         {
-            clean();
-            type_ = OBJECT;
-            valid_ = true;
+            next();
         }
 
-        if (jobject_.find(wname) == jobject_.end())
+        if (event_ == Event::StartObject || event_ == Event::StartArray)
         {
-            jobject_.insert(std::pair<std::wstring, std::shared_ptr<JsonW>>(wname, std::make_shared<JsonW>()));
+            size_t depth = scopes_.size();
+            while (scopes_.size() >= depth && next() != Event::Error)
+            {
+            }
         }
 
-        return *(jobject_.find(wname)->second);
+        return event_;
     }
 
-    JsonW& operator[] (const std::wstring& wname)
+    // read the current value as a JsonW, that is the value after 
+    // Event::Key, the whole object or array after Event::StartObject or 
+    // Event::StartArray, or the scalar of the current event. Return 
+    // nullptr if there is no such value or it is invalid.
+    std::shared_ptr<JsonW> value()
     {
-        if (wname.length() == 0)
+        switch (event_)
         {
-            return bad();
+        case Event::Key:
+            read();
+            break;
+        case Event::StartObject:
+        case Event::StartArray:
+            scopes_.pop_back();
+            break;
+        case Event::String:
+        case Event::Integer:
+        case Event::Float:
+        case Event::Boolean:
+        case Event::Null:
+            break;
+        default:
+            return nullptr;
         }
 
-        if (type_ != OBJECT)
-        {
-            clean();
-            type_ = OBJECT;
-            valid_ = true;
-        }
+        // JsonW reads from the current token and stops at the token after
+        // the value, which is the next token to read
+        std::shared_ptr<JsonW> jvalue = std::make_shared<JsonW>(tokens_);
+        pending_ = true;
+        after_ = true;
 
-        if (jobject_.find(wname) == jobject_.end())
+        switch (jvalue->type())
         {
-            jobject_.insert(std::pair<std::wstring, std::shared_ptr<JsonW>>(wname, std::make_shared<JsonW>()));
+        case JsonW::OBJECT: event_ = Event::EndObject; break;
+        case JsonW::ARRAY: event_ = Event::EndArray; break;
+        case JsonW::INTEGER: event_ = Event::Integer; break;
+        case JsonW::FLOAT: event_ = Event::Float; break;
+        case JsonW::STRING: event_ = Event::String; break;
+        case JsonW::BOOLEAN: event_ = Event::Boolean; break;
+        case JsonW::NULLVALUE: event_ = Event::Null; break;
+        default: event_ = Event::Error; return nullptr;
         }
 
-        return *(jobject_.find(wname)->second);
+        return jvalue;
     }
 
-    // format json data into utf8 text in json standard
-    std::wstring wtext( bool singleline = true ) const
-    {
-        std::wstringstream wss;
-        wss_jvalue(wss, *this, singleline);
-        return wss.str();
-    }
+public:
+    Event event() const { return event_; }
+    size_t depth() const { return scopes_.size(); }
 
-    // format json data into ucs text
-    std::string text( bool singleline = true ) const
-    {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-        return conv.to_bytes(wtext( singleline ));
-    }
+    // name for Event::Key, value for Event::String
+    const std::string& str() { return tokens_.str(); }
+    long long integer() const { return tokens_.integer(); }
+    long double frac() const { return tokens_.frac(); }
+    bool boolean() const { return tokens_.boolean(); }
 
-    friend std::ostream& operator<<(std::ostream& os, const JsonW& rhs)
+private:
+    // private help function, read the next token unless the current one 
+    // is not consumed yet
+    JsonTokenW::Type read()
     {
-        os << rhs.text();
-        return os;
-    }
+        if (pending_)
+        {
+            pending_ = false;
+            return tokens_.type();
+        }
 
-    friend std::wostream& operator<<(std::wostream& wos, const JsonW& rhs)
-    {
-        wos << rhs.wtext();
-        return wos;
+        return tokens_.next();
     }
 
-public:
-    // Singleton bad JsonW instance
-    static JsonW& bad()
+    // private help function, event of the first token of a value
+    Event start(JsonTokenW::Type type, bool root = false)
     {
-        static JsonW instance;
-        instance.type_ = BAD;
-        instance.valid_ = false;
-        return instance;
-    }
+        after_ = true;
 
-private:
-    // private static help function - parse token into json object 
-    static bool jobject(std::queue<JsonTokenW>& tokens, std::map<std::wstring, std::shared_ptr<JsonW>>& jobject)
-    {
-        // Object must start with LeftCurlyBracket:'{' and minimum size is 2 '{' + '}'
-        if (tokens.size() < 2 ||
-            tokens.front().type() != JsonTokenW::Type::LeftCurlyBracket)
+        switch (type)
         {
-            return false;
+        case JsonTokenW::Type::LeftCurlyBracket:
+            scopes_.push_back('{');
+            after_ = false;
+            return Event::StartObject;
+        case JsonTokenW::Type::LeftSquareBracket:
+            scopes_.push_back('[');
+            after_ = false;
+            return Event::StartArray;
+        case JsonTokenW::Type::NumberInteger:
+            return Event::Integer;
+        case JsonTokenW::Type::NumberFloat:
+            return Event::Float;
+        case JsonTokenW::Type::String:
+            return Event::String;
+        case JsonTokenW::Type::Boolean:
+            return Event::Boolean;
+        case JsonTokenW::Type::Null:
+            return Event::Null;
+        case JsonTokenW::Type::End:
+            // no token at all is not an error, same as JsonW
+            return root ? Event::End : Event::Error;
+        default:
+            return Event::Error;
         }
-        tokens.pop();
-
-        while (!tokens.empty())
-        {
-            std::wstring key;
-            switch (tokens.front().type())
-            {
-            case JsonTokenW::Type::RightCurlyBracket:
-                tokens.pop();
-                return true;
-            case JsonTokenW::Type::String:
-                key = tokens.front().wstring();
-                if (key.length() == 0)
-                {
-                    return false;
-                }
-                else if (jobject.count(key) > 0)
-                {
-                    return false; // not allow duplicate key
-                }
-
-                tokens.pop();
-                if (tokens.empty())
-                {
-                    return false;
-                }
-                else if (tokens.front().type() != JsonTokenW::Type::Colon)
-                {
-                    return false;
-                }
+    }
 
-                tokens.pop();
-                if (tokens.empty())
-                {
-                    return false;
-                }
-                else
-                {
-                    std::shared_ptr<JsonW> junit = std::make_shared<JsonW>(tokens);
+    // private help function, close the innermost object or array
+    Event close()
+    {
+        char scope = scopes_.back();
 
-                    if (junit->valid() == false)
-                    {
-                        return false;
-                    }
-                    else
-                    {
-                        jobject[key] = junit;
-                    }
-                }
+        scopes_.pop_back();
+        after_ = true;
 
-                if (!tokens.empty() && tokens.front().type() == JsonTokenW::Type::Comma)
-                {
-                    // consume comma and expect next key-data set
-                    tokens.pop();
-                }
+        return scope == '{' ? Event::EndObject : Event::EndArray;
+    }
 
-                break;
-            case JsonTokenW::Type::LeftCurlyBracket:
-            case JsonTokenW::Type::LeftSquareBracket:
-            case JsonTokenW::Type::RightSquareBracket:
-            case JsonTokenW::Type::NumberInteger:
-            case JsonTokenW::Type::NumberFloat:
-            case JsonTokenW::Type::Boolean:
-            case JsonTokenW::Type::Null:
-            case JsonTokenW::Type::Colon:
-            case JsonTokenW::Type::Comma:
-            case JsonTokenW::Type::Bad:
-            default:
-                return false;
-            }
+    // private help function, text after the top level value is ignored,
+    // but a bad token there makes the whole text invalid like JsonW does
+    Event finish()
+    {
+        JsonTokenW::Type type = read();
+        while (type != JsonTokenW::Type::End && type != JsonTokenW::Type::Bad)
+        {
+            type = tokens_.next();
         }
 
-        return false;
+        return type == JsonTokenW::Type::End ? Event::End : Event::Error;
     }
 
-    // private static help function - parse tokens into json array
-    static bool jarray(std::queue<JsonTokenW>& tokens, std::vector<std::shared_ptr<JsonW>>& jarray)
+private:
+    JsonTokenW tokens_;
+    std::string scopes_;
+    Event event_ = Event::Null;
+    bool after_ = false;
+    bool pending_ = false;
+};
+
+// JsonFieldW binds a json name to a member of struct T. A struct is 
+// described by a constexpr array of fields and JsonBindW reads and writes
+// the struct with that array. A member can be int, uint_fast32_t, long 
+// long, bool, std::string, or uint_fast32_t[3] such as a location.
+template <typename T>
+class JsonFieldW
+{
+public:
+    enum class Kind
+    {
+        Int,
+        Unsigned,
+        Long,
+        Boolean,
+        String,
+        Triple
+    };
+
+    // a field is required and a string field may be empty unless flagged
+    enum
+    {
+        OPTIONAL = 1,
+        NONEMPTY = 2
+    };
+
+public:
+    constexpr JsonFieldW(const char* key, int T::* member, int flags = 0)
+        : key_(key), kind_(Kind::Int), flags_(flags), int_(member) {}
+    constexpr JsonFieldW(const char* key, uint_fast32_t T::* member, int flags = 0)
+        : key_(key), kind_(Kind::Unsigned), flags_(flags), unsigned_(member) {}
+    constexpr JsonFieldW(const char* key, long long T::* member, int flags = 0)
+        : key_(key), kind_(Kind::Long), flags_(flags), long_(member) {}
+    constexpr JsonFieldW(const char* key, bool T::* member, int flags = 0)
+        : key_(key), kind_(Kind::Boolean), flags_(flags), boolean_(member) {}
+    constexpr JsonFieldW(const char* key, std::string T::* member, int flags = 0)
+        : key_(key), kind_(Kind::String), flags_(flags), string_(member) {}
+    constexpr JsonFieldW(const char* key, uint_fast32_t (T::* member)[3], int flags = 0)
+        : key_(key), kind_(Kind::Triple), flags_(flags), triple_(member) {}
+
+public:
+    const char* key_;
+    Kind kind_;
+    int flags_;
+
+    // only the member of kind_ is set
+    union
+    {
+        int T::* int_;
+        uint_fast32_t T::* unsigned_;
+        long long T::* long_;
+        bool T::* boolean_;
+        std::string T::* string_;
+        uint_fast32_t (T::* triple_)[3];
+    };
+};
+
+// JsonBindW reads a json object into a struct and writes a struct as a
+// json object with an array of JsonFieldW. Each name is looked up in the
+// array once and its value goes straight into the member. Reading fails if
+// a required field is missing or empty, a value has the wrong type or does
+// not fit the member, or a name appears twice. Unknown names are skipped,
+// members of a failed read may be partly written.
+class JsonBindW
+{
+public:
+    // read the next value of the reader, it has to be an object
+    template <typename T, size_t N>
+    static bool read(JsonReaderW& reader, const JsonFieldW<T> (&fields)[N], T& record)
     {
-        // Object must start with LeftCurlyBracket:'[' and minimum size is 2 '[' + ']'
-        if (tokens.size() < 2 ||
-            tokens.front().type() != JsonTokenW::Type::LeftSquareBracket)
+        static_assert(N <= 64, "JsonBindW supports up to 64 fields");
+        uint_fast64_t seen = 0;
+
+        if (reader.next() != JsonReaderW::Event::StartObject)
         {
             return false;
         }
-        tokens.pop();
 
-        while (!tokens.empty())
+        while (reader.next() == JsonReaderW::Event::Key)
         {
-            switch (tokens.front().type())
+            size_t idx = find(fields, reader.str());
+            JsonReaderW::Event event = reader.next();
+
+            if (idx == N)
             {
-            case JsonTokenW::Type::RightSquareBracket:
-                tokens.pop();
-                return true;
-            case JsonTokenW::Type::LeftCurlyBracket:
-            case JsonTokenW::Type::LeftSquareBracket:
-            case JsonTokenW::Type::NumberInteger:
-            case JsonTokenW::Type::NumberFloat:
-            case JsonTokenW::Type::Boolean:
-            case JsonTokenW::Type::String:
-            case JsonTokenW::Type::Null:
+                reader.skip();
+                continue;
+            }
+
+            if (seen & ((uint_fast64_t)1 << idx))
+            {
+                return false;
+            }
+            seen |= (uint_fast64_t)1 << idx;
+
+            const JsonFieldW<T>& field = fields[idx];
+            if (field.kind_ == JsonFieldW<T>::Kind::Triple)
             {
-                std::shared_ptr<JsonW> junit = std::make_shared<JsonW>(tokens);
-                if (junit->valid() == false)
+                if (event != JsonReaderW::Event::StartArray)
                 {
                     return false;
                 }
 
-                jarray.push_back(junit);
-
-                // if followed by comma, continually read next JsonUnitW
-                if (!tokens.empty() && tokens.front().type() == JsonTokenW::Type::Comma)
-                {
-                    tokens.pop();
-                    continue;
-                }
-                else if (!tokens.empty() && tokens.front().type() == JsonTokenW::Type::RightSquareBracket)
+                for (int i = 0; i < 3; i++)
                 {
-                    tokens.pop();
-                    return true;
+                    if (reader.next() != JsonReaderW::Event::Integer || 
+                        !unsigned32(reader.integer()))
+                    {
+                        return false;
+                    }
+                    (record.*field.triple_)[i] = (uint_fast32_t)reader.integer();
                 }
-                else
+
+                if (reader.next() != JsonReaderW::Event::EndArray)
                 {
                     return false;
                 }
             }
-
-            // invalid
-            case JsonTokenW::Type::RightCurlyBracket:
-            case JsonTokenW::Type::Colon:
-            case JsonTokenW::Type::Comma:
-            case JsonTokenW::Type::Bad:
-            default:
+            else if (!store(field, record, type(event), reader.integer(), reader.str(), reader.boolean()))
+            {
                 return false;
             }
         }
 
-        return false;
+        return reader.event() == JsonReaderW::Event::EndObject && complete(fields, seen);
     }
-    
-    // private static help function, write value into string buffer in json format 
-    static std::wstringstream& wss_jvalue(std::wstringstream& wss, const JsonW& jvalue, bool singleline = true, size_t level = 0 )
+
+    // read a whole utf8 text, the rest of the text after the object has
+    // to be valid like JsonW
+    template <typename T, size_t N>
+    static bool read(const char* utf8data, size_t size, const JsonFieldW<T> (&fields)[N], T& record)
     {
-        if (jvalue.valid() == false)
-        {
-            return wss;
-        }
+        JsonReaderW reader(utf8data, size);
 
-        switch (jvalue.type())
-        {
-        case JsonW::INTEGER:
-            wss << std::to_wstring(jvalue.integer());
-            return wss;
-        case JsonW::FLOAT:
-            wss << std::to_wstring(jvalue.frac());
-            return wss;
-        case JsonW::BOOLEAN:
-            if (jvalue.boolean())
-            {
-                wss << L"true";
-                return wss;
-            }
-            else
-            {
-                wss << L"false";
-                return wss;
-            }
-        case JsonW::NULLVALUE:
-            wss << L"null";
-            return wss;
-        case JsonW::STRING:
-            return wss_string(wss, jvalue.wstr());
-        case JsonW::OBJECT:
-        {
-            if ( singleline )
-            {
-                return wss_jobject( wss, jvalue );
-            }
-            else
-            {
-                return wss_jobject( wss, jvalue, singleline, level );
-            }
-        }            
-        case JsonW::ARRAY:
-        {
-            std::wstringstream wsstmp;
-            wss_jarray( wsstmp, jvalue);
-            std::wstring wstr = wsstmp.str();
-            
-            if ( singleline || wstr.length() <= 20 )
-            {
-                wss << wstr;
-                return wss;
-            }
-            else
-            {
-                return wss_jarray( wss, jvalue, singleline, level );
-            }                     
-        }
-        case JsonW::BAD:
-        default:
-            return wss;
-        }
+        return read(reader, fields, record) && reader.next() == JsonReaderW::Event::End;
     }
-    
-    static std::wstringstream& wss_jobject(std::wstringstream& wss, const JsonW& jobject, 
-        bool singleline = true, size_t level = 0, bool addcomma = false )
+
+    // read a parsed object, e.g. a command kept as JsonW
+    template <typename T, size_t N>
+    static bool read(const JsonW& json, const JsonFieldW<T> (&fields)[N], T& record)
     {
-        std::vector<std::wstring> wkeys;
-        jobject.wkeys(wkeys);
-        size_t level_plus = 0;
-        
-        if ( singleline == false )
-        {            
-            level_plus = level + 1;
-        }
+        static_assert(N <= 64, "JsonBindW supports up to 64 fields");
+        uint_fast64_t seen = 0;
 
-        wss_intent(wss, level) << L"{";
-        
-        if ( singleline == false )
+        if (json.type() != JsonW::OBJECT)
         {
-            wss << std::endl;
+            return false;
         }
 
-        for (size_t i = 0; i < wkeys.size(); i++)
+        for (const auto& member : json.jobject_)
         {
-            bool newline = false;
-            bool comma_in_function = true;
-            
-            wss_intent(wss, level_plus);
-            wss_string(wss, wkeys.at(i)) << L":";
-            
-            // 'name : value'
-            // when we need to add std::endl after ':'
-            // 1. value is json object
-            // 2. value is json array and length + level*4 > 40
-            std::shared_ptr<JsonW> jvalue = jobject.get(wkeys.at(i));
-             
-            if ( singleline == false )
-            {
-                size_t estimate_size = 0;
-                std::wstringstream wsstmp;
-                wss_jvalue(wsstmp, *(jvalue.get()));
-                estimate_size = wsstmp.str().length();
-
-                if ( jvalue->type() == JsonW::OBJECT && jvalue->size() > 1 )
-                {
-                    if (jvalue->size() > 1 || estimate_size > 20)
-                    {
-                        newline = true;
-                        wss << std::endl;
-                    }
-                }
-                else if ( jvalue->type() == JsonW::ARRAY )
-                {
-                    bool has_object_array = false;
+            size_t idx = find(fields, member.first);
 
-                    for (size_t j = 0; j < jvalue->size(); j++)
-                    {
-                        if (jvalue->get(j)->type() == JsonW::ARRAY ||
-                            jvalue->get(j)->type() == JsonW::OBJECT)
-                        {
-                            has_object_array = true;
-                        }
-                    }
+            if (idx == N)
+            {
+                continue;
+            }
 
-                    if (has_object_array || wsstmp.str().length() > 20 )
-                    {
-                        newline = true;
-                        wss << std::endl;
-                    }
-                }             
+            if (member.second == nullptr)
+            {
+                return false;
             }
-            
-            if ( newline == false )
+
+            seen |= (uint_fast64_t)1 << idx;
+
+            const JsonFieldW<T>& field = fields[idx];
+            const JsonW& jvalue = *member.second;
+            if (field.kind_ == JsonFieldW<T>::Kind::Triple)
             {
-                if (i < wkeys.size() - 1)
-                {
-                    wss_jvalue(wss, *(jvalue.get())) << L",";
-                }
-                else
+                if (jvalue.type() != JsonW::ARRAY || jvalue.size() != 3)
                 {
-                    wss_jvalue(wss, *(jvalue.get()));
+                    return false;
                 }
-            }
-            else
-            {
-                if (i < wkeys.size() - 1)
+
+                for (size_t i = 0; i < 3; i++)
                 {
-                    if (jvalue->type() == JsonW::OBJECT)
-                    {
-                        comma_in_function = false;
-                        wss_jobject(wss, *(jvalue.get()), singleline, level_plus, true);
-                    }
-                    else if (jvalue->type() == JsonW::ARRAY)
-                    {
-                        comma_in_function = false;
-                        wss_jarray(wss, *(jvalue.get()), singleline, level_plus, true);
-                    }
-                    else
+                    const JsonW* jitem = jvalue.jarray_[i].get();
+                    if (jitem == nullptr || jitem->type() != JsonW::INTEGER || 
+                        !unsigned32(jitem->integer()))
                     {
-                        wss_jvalue(wss, *(jvalue.get()), singleline, level_plus) << L",";
+                        return false;
                     }
-                }
-                else
-                {
-                    wss_jvalue(wss, *(jvalue.get()));
+                    (record.*field.triple_)[i] = (uint_fast32_t)jitem->integer();
                 }
             }
-            
-            if ( singleline == false && comma_in_function )
+            else if (!store(field, record, jvalue.type(), jvalue.integer(), jvalue.str(), jvalue.boolean()))
             {
-                wss << std::endl;
+                return false;
             }
         }
 
-        if ( singleline )
-        {
-            wss << L"}";
-        }
-        else if ( addcomma )
-        {
-            wss_intent(wss, level) << L"}," << std::endl;
-        }
-        else
-        {
-            wss_intent(wss, level) << L"}" << std::endl;
-        }
-                
-        return wss;
+        return complete(fields, seen);
     }
-    
-    static std::wstringstream& wss_jarray(std::wstringstream& wss, const JsonW& jarray, 
-        bool singleline = true, size_t level = 0, bool addcomma = false )
+
+    // write the record as one json object, optional fields included
+    template <typename Buffer, typename T, size_t N>
+    static void write(JsonWriterW<Buffer>& writer, const JsonFieldW<T> (&fields)[N], const T& record)
     {
-        size_t size = jarray.size();
-        size_t level_plus = 0;
-        
-        if ( singleline == false )
-        {
-            level_plus = level + 1;
-        }
-        
-        wss_intent(wss, level) << L"[";
-        
-        if ( singleline == false )
-        {
-            wss << std::endl;
-        }
-        
-        for (size_t i = 0; i < size; i++)
+        writer.begin_object();
+
+        for (const auto& field : fields)
         {
-            std::shared_ptr<JsonW> jvalue = jarray.get(i);
-            bool newline_end = true;
+            writer.key(field.key_);
 
-            if (singleline == false)
+            switch (field.kind_)
             {
-                size_t estimate_size = 0;
-                std::wstringstream wsstmp;
-                wss_jvalue(wsstmp, *(jvalue.get()));
-                estimate_size = wsstmp.str().length();
-
-                if (jvalue->type() == JsonW::OBJECT && 
-                    ( jvalue->size() > 1 || estimate_size > 20))
-                {
-                    newline_end = false;
-                    if (i < size - 1)
-                    {
-                        wss_jobject(wss, *(jvalue.get()), singleline, level_plus, true);
-                    }
-                    else
-                    {
-                        wss_jobject(wss, *(jvalue.get()), singleline, level_plus);
-                    }
-                }
-                else if (jvalue->type() == JsonW::ARRAY && estimate_size > 20 )
-                {
-                    newline_end = false;
-                    if (i < size - 1)
-                    {  
-                        wss_jarray(wss, *(jvalue.get()), singleline, level_plus, true);
-                    }
-                    else
-                    {
-                        wss_jarray(wss, *(jvalue.get()), singleline, level_plus);
-                    }
-                }
-                else
+            case JsonFieldW<T>::Kind::Int:
+                writer.value(record.*field.int_);
+                break;
+            case JsonFieldW<T>::Kind::Unsigned:
+                writer.value((long long)(record.*field.unsigned_));
+                break;
+            case JsonFieldW<T>::Kind::Long:
+                writer.value(record.*field.long_);
+                break;
+            case JsonFieldW<T>::Kind::Boolean:
+                writer.value(record.*field.boolean_);
+                break;
+            case JsonFieldW<T>::Kind::String:
+                writer.value(record.*field.string_);
+                break;
+            case JsonFieldW<T>::Kind::Triple:
+                writer.begin_array();
+                for (int i = 0; i < 3; i++)
                 {
-                    wss_intent(wss, level_plus);
-                    wss_jvalue(wss, *(jvalue.get()));
-
-                    if (i < size - 1)
-                    {
-                        wss << L",";
-                    }
+                    writer.value((long long)((record.*field.triple_)[i]));
                 }
+                writer.end();
+                break;
             }
-            else
-            {
-                wss_jvalue(wss, *(jvalue.get()), singleline, level_plus);
+        }
 
-                if (i < size - 1)
-                {
-                    wss << L",";
-                }
-            }
-            
-            if ( singleline == false && newline_end)
+        writer.end();
+    }
+
+private:
+    // private help function, index of the name in fields, or N
+    template <typename T, size_t N>
+    static size_t find(const JsonFieldW<T> (&fields)[N], const std::string& key)
+    {
+        for (size_t idx = 0; idx < N; idx++)
+        {
+            if (key == fields[idx].key_)
             {
-                wss << std::endl;
+                return idx;
             }
         }
-        
-        if ( singleline )
-        {
-            wss <<  L"]";
-        }
-        else if ( addcomma )
-        {
-            wss_intent(wss, level) << L"]," << std::endl;
-        }
-        else
-        {
-            wss_intent(wss, level) << L"]" << std::endl;
-        }
-        
-        return wss;
+
+        return N;
     }
-    
-    static std::wstringstream& wss_intent( std::wstringstream& wss, size_t level )
+
+    // private help function, every required field is seen
+    template <typename T, size_t N>
+    static bool complete(const JsonFieldW<T> (&fields)[N], uint_fast64_t seen)
     {
-        if ( level == 0 )
+        for (size_t idx = 0; idx < N; idx++)
         {
-            return wss;
+            if ((fields[idx].flags_ & JsonFieldW<T>::OPTIONAL) == 0 && 
+                (seen & ((uint_fast64_t)1 << idx)) == 0)
+            {
+                return false;
+            }
         }
-        
-        std::wstring intent(level * 4, L' ');
-        wss << intent;
-        return wss;
+
+        return true;
     }
 
-    // private static help function, write string into string buffer in json format 
-    static std::wstringstream& wss_string(std::wstringstream& wss, const std::wstring& wstr)
+    // private help function, check and write one scalar member
+    template <typename T>
+    static bool store(const JsonFieldW<T>& field, T& record, int type, 
+        long long integer, const std::string& str, bool boolean)
     {
-        wss << L"\"";
-
-        for (size_t i = 0; i < wstr.length(); i++)
+        switch (field.kind_)
         {
-            wchar_t wchar = wstr.at(i);
-
-            switch (wchar)
+        case JsonFieldW<T>::Kind::Int:
+            if (type != JsonW::INTEGER || integer < INT_MIN || integer > INT_MAX)
+            {
+                return false;
+            }
+            record.*field.int_ = (int)integer;
+            return true;
+        case JsonFieldW<T>::Kind::Unsigned:
+            if (type != JsonW::INTEGER || !unsigned32(integer))
+            {
+                return false;
+            }
+            record.*field.unsigned_ = (uint_fast32_t)integer;
+            return true;
+        case JsonFieldW<T>::Kind::Long:
+            if (type != JsonW::INTEGER)
+            {
+                return false;
+            }
+            record.*field.long_ = integer;
+            return true;
+        case JsonFieldW<T>::Kind::Boolean:
+            if (type != JsonW::BOOLEAN)
+            {
+                return false;
+            }
+            record.*field.boolean_ = boolean;
+            return true;
+        case JsonFieldW<T>::Kind::String:
+            if (type != JsonW::STRING || 
+                ((field.flags_ & JsonFieldW<T>::NONEMPTY) != 0 && str.empty()))
             {
-            case 0x22: wss << L"\\\""; break;
-            case 0x5C: wss << L"\\\\"; break;
-            case 0x2F: wss << L"\\/"; break;
-            case 0x08: wss << L"\\b"; break;
-            case 0x0C: wss << L"\\f"; break;
-            case 0x0A: wss << L"\\n"; break;
-            case 0x0D: wss << L"\\r"; break;
-            case 0x09: wss << L"\\t"; break;
-            default: wss << wchar;
+                return false;
             }
+            record.*field.string_ = str;
+            return true;
+        default:
+            return false;
         }
-
-        wss << L"\"";
-        
-        return wss;
     }
 
-private:
-    // private help function, release all resource 
-    void clean()
+    // private help function, JsonW type of a scalar event
+    static int type(JsonReaderW::Event event)
     {
-        jobject_.clear();
-        jarray_.clear();
-
-        type_ = NULLVALUE;
-        valid_ = true;
+        switch (event)
+        {
+        case JsonReaderW::Event::Integer: return JsonW::INTEGER;
+        case JsonReaderW::Event::String: return JsonW::STRING;
+        case JsonReaderW::Event::Boolean: return JsonW::BOOLEAN;
+        default: return JsonW::BAD;
+        }
     }
 
-    // private help function, read json data from wistream   
-    void init(std::wistream& ins)
+    static bool unsigned32(long long integer)
     {
-        // set locale to utf8
-        std::queue<JsonTokenW> tokens;
-        ins.imbue(std::locale(ins.getloc(), new std::codecvt_utf8<wchar_t>));
-
-        // parse tokens
-        JsonTokenW::parse(ins, tokens);
-
-        // convert to junit
-        parse(tokens);
+        return integer >= 0 && integer <= (long long)UINT32_MAX;
     }
-
-private:
-    // private member data
-    int type_ = NULLVALUE;
-    bool valid_ = false;
-
-    long long integer_ = 0;
-    long double frac_ = 0.0;
-    std::wstring wstring_;
-    bool boolean_ = true;
-    
-    std::map<std::wstring, std::shared_ptr<JsonW>> jobject_;
-    std::vector<std::shared_ptr<JsonW>> jarray_;
-
 };
 
 #endif // OCTILLION_JSONW_HEADER
\ No newline at end of file
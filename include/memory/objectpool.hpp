@@ -0,0 +1,270 @@
+#ifndef OCTILLION_OBJECT_POOL_HEADER
+#define OCTILLION_OBJECT_POOL_HEADER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace octillion
+{
+    template<typename T> class ObjectPool;
+}
+
+// blocks of sizeof(T) with a cache per thread
+//
+// allocate() pops a block from the calling thread's cache. An empty cache
+// takes BATCH blocks from the shared depot, and only when the depot is empty
+// too a new block comes from ::operator new (a miss). release() pushes the
+// block to the cache of the calling thread, whichever thread allocated it,
+// and a cache that grows over CACHE blocks gives BATCH of them back to the
+// depot. That is the way back for objects that are created on a network
+// thread and deleted by the world tick: the depot lock is taken once per
+// BATCH objects, not per object.
+//
+// Blocks are kept for the whole program, the pool never shrinks. A class
+// uses the pool by its own operator new and delete, sizes other than
+// sizeof(T), e.g. a derived class, go to the global operator. With
+// MEMORY_DEBUG every block comes from the global operator, so that leak
+// tracking sees each object.
+template<typename T>
+class octillion::ObjectPool
+{
+public:
+    const static size_t BATCH = 32;
+    const static size_t CACHE = 2 * BATCH;
+
+    // counters since the start, threads add theirs every BATCH operations
+    // and when they exit
+    class Stats
+    {
+    public:
+        uint_fast64_t hits = 0;     // blocks from a thread cache
+        uint_fast64_t misses = 0;   // blocks from ::operator new
+        uint_fast64_t refills = 0;  // batches taken from the depot
+        uint_fast64_t returns = 0;  // batches given back to the depot
+    };
+
+public:
+    // the pool lives until the program ends, thread caches can be flushed
+    // after static objects are gone
+    static ObjectPool& instance()
+    {
+        static ObjectPool* pool = new ObjectPool();
+        return *pool;
+    }
+
+    // avoid accidentally copy
+    ObjectPool( ObjectPool const& ) = delete;
+    void operator = ( ObjectPool const& ) = delete;
+
+public:
+    void* allocate( size_t size )
+    {
+#ifndef MEMORY_DEBUG
+        if ( size == sizeof( T ))
+        {
+            Cache& cache = cache_;
+            if ( cache.head_ == nullptr )
+            {
+                refill( cache );
+            }
+
+            Block* block = cache.head_;
+            if ( block != nullptr )
+            {
+                cache.head_ = block->next_;
+                cache.size_ --;
+                cache.hits_ ++;
+            }
+            else
+            {
+                block = static_cast<Block*>( ::operator new( sizeof( Block )));
+                cache.misses_ ++;
+            }
+
+            count( cache );
+            return block;
+        }
+#endif
+        return ::operator new( size );
+    }
+
+    void release( void* ptr, size_t size )
+    {
+        if ( ptr == nullptr )
+        {
+            return;
+        }
+
+#ifndef MEMORY_DEBUG
+        if ( size == sizeof( T ))
+        {
+            Cache& cache = cache_;
+            Block* block = static_cast<Block*>( ptr );
+            block->next_ = cache.head_;
+            cache.head_ = block;
+            cache.size_ ++;
+
+            if ( cache.size_ > CACHE )
+            {
+                giveback( cache, BATCH );
+            }
+
+            count( cache );
+            return;
+        }
+#endif
+        ::operator delete( ptr );
+    }
+
+    // object from the pool, for types that do not route their own operator
+    // new to the pool
+    template<typename... Args>
+    T* create( Args&&... args )
+    {
+        void* ptr = allocate( sizeof( T ));
+        try
+        {
+            return ::new ( ptr ) T( std::forward<Args>( args )... );
+        }
+        catch ( ... )
+        {
+            release( ptr, sizeof( T ));
+            throw;
+        }
+    }
+
+    void destroy( T* obj )
+    {
+        if ( obj != nullptr )
+        {
+            obj->~T();
+            release( obj, sizeof( T ));
+        }
+    }
+
+    Stats stats() const
+    {
+        Stats stats;
+        stats.hits = hits_.load( std::memory_order_relaxed );
+        stats.misses = misses_.load( std::memory_order_relaxed );
+        stats.refills = refills_.load( std::memory_order_relaxed );
+        stats.returns = returns_.load( std::memory_order_relaxed );
+        return stats;
+    }
+
+private:
+    ObjectPool() {}
+
+    union Block
+    {
+        Block* next_;
+        alignas( T ) unsigned char data_[sizeof( T )];
+    };
+
+    class Cache
+    {
+    public:
+        ~Cache()
+        {
+            ObjectPool& pool = instance();
+            pool.giveback( *this, size_ );
+            pool.publish( *this );
+        }
+
+        Block* head_ = nullptr;
+        size_t size_ = 0;
+
+        // counted here, added to the pool by publish()
+        size_t ops_ = 0;
+        uint_fast64_t hits_ = 0;
+        uint_fast64_t misses_ = 0;
+    };
+
+    // take up to BATCH blocks from the depot
+    void refill( Cache& cache )
+    {
+        std::lock_guard<std::mutex> lock( lock_ );
+        if ( depot_ == nullptr )
+        {
+            return;
+        }
+
+        Block* head = depot_;
+        Block* tail = head;
+        size_t taken = 1;
+        while ( taken < BATCH && tail->next_ != nullptr )
+        {
+            tail = tail->next_;
+            taken ++;
+        }
+
+        depot_ = tail->next_;
+        tail->next_ = cache.head_;
+        cache.head_ = head;
+        cache.size_ += taken;
+        refills_.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    // move 'count' blocks from the cache to the depot
+    void giveback( Cache& cache, size_t count )
+    {
+        if ( count == 0 || cache.head_ == nullptr )
+        {
+            return;
+        }
+
+        Block* head = cache.head_;
+        Block* tail = head;
+        size_t given = 1;
+        while ( given < count && tail->next_ != nullptr )
+        {
+            tail = tail->next_;
+            given ++;
+        }
+
+        cache.head_ = tail->next_;
+        cache.size_ -= given;
+
+        std::lock_guard<std::mutex> lock( lock_ );
+        tail->next_ = depot_;
+        depot_ = head;
+        returns_.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    void count( Cache& cache )
+    {
+        if ( ++ cache.ops_ >= BATCH )
+        {
+            publish( cache );
+        }
+    }
+
+    void publish( Cache& cache )
+    {
+        hits_.fetch_add( cache.hits_, std::memory_order_relaxed );
+        misses_.fetch_add( cache.misses_, std::memory_order_relaxed );
+        cache.hits_ = 0;
+        cache.misses_ = 0;
+        cache.ops_ = 0;
+    }
+
+private:
+    static thread_local Cache cache_;
+
+    std::mutex lock_;
+    Block* depot_ = nullptr; // guarded by lock_
+
+    std::atomic<uint_fast64_t> hits_{ 0 };
+    std::atomic<uint_fast64_t> misses_{ 0 };
+    std::atomic<uint_fast64_t> refills_{ 0 };
+    std::atomic<uint_fast64_t> returns_{ 0 };
+};
+
+template<typename T>
+thread_local typename octillion::ObjectPool<T>::Cache octillion::ObjectPool<T>::cache_;
+
+#endif
@@ -20,7 +20,7 @@ namespace octillion
 class octillion::DataQueue
 {
     private:
-        const std::string tag_ = "DataQueue";
+        constexpr static const char* tag_ = "DataQueue";
 
     public:
         DataQueue();
@@ -0,0 +1,122 @@
+#ifndef OCTILLION_MPSC_QUEUE_HEADER
+#define OCTILLION_MPSC_QUEUE_HEADER
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "memory/objectpool.hpp"
+
+namespace octillion
+{
+    template<typename T> class MpscQueue;
+}
+
+// lock-free multi-producer single-consumer queue
+//
+// producers (network threads) push() without blocking each other or the
+// consumer, the consumer (world thread) takes everything at once by drain(),
+// which swaps the whole list out with a single atomic exchange.
+// push() never fails and drain() returns the items in push order. Nodes
+// are allocated by producers and freed by the consumer, they come from an
+// ObjectPool so that the two sides do not meet in malloc.
+template<typename T>
+class octillion::MpscQueue
+{
+private:
+    class Node
+    {
+    public:
+        Node( const T& value ) : value_( value ) {}
+        Node( T&& value ) : value_( std::move( value )) {}
+
+        T value_;
+        Node* next_ = nullptr;
+
+        static void* operator new( size_t size ) { return ObjectPool<Node>::instance().allocate( size ); }
+        static void operator delete( void* ptr, size_t size ) { ObjectPool<Node>::instance().release( ptr, size ); }
+    };
+
+public:
+    MpscQueue() {}
+
+    ~MpscQueue()
+    {
+        Node* node = head_.exchange( nullptr, std::memory_order_acquire );
+        while ( node != nullptr )
+        {
+            Node* next = node->next_;
+            delete node;
+            node = next;
+        }
+    }
+
+    // avoid accidentally copy
+    MpscQueue( MpscQueue const& ) = delete;
+    void operator = ( MpscQueue const& ) = delete;
+
+public:
+    // thread-safe, can be called by any thread
+    void push( const T& value )
+    {
+        link( new Node( value ));
+    }
+
+    void push( T&& value )
+    {
+        link( new Node( std::move( value )));
+    }
+
+    // consumer only, append all pushed items to out in push order,
+    // return the number of items appended
+    size_t drain( std::vector<T>& out )
+    {
+        Node* node = head_.exchange( nullptr, std::memory_order_acquire );
+        Node* reversed = nullptr;
+        size_t count = 0;
+
+        // head_ is a stack, reverse it to get the push order
+        while ( node != nullptr )
+        {
+            Node* next = node->next_;
+            node->next_ = reversed;
+            reversed = node;
+            node = next;
+            count++;
+        }
+
+        out.reserve( out.size() + count );
+
+        while ( reversed != nullptr )
+        {
+            Node* next = reversed->next_;
+            out.push_back( std::move( reversed->value_ ));
+            delete reversed;
+            reversed = next;
+        }
+
+        return count;
+    }
+
+    // hint only, the queue may change right after the call
+    bool empty() const
+    {
+        return head_.load( std::memory_order_relaxed ) == nullptr;
+    }
+
+private:
+    void link( Node* node )
+    {
+        node->next_ = head_.load( std::memory_order_relaxed );
+        while ( ! head_.compare_exchange_weak( node->next_, node,
+                    std::memory_order_release, std::memory_order_relaxed ))
+        {
+            // node->next_ was updated to the current head_, try again
+        }
+    }
+
+private:
+    std::atomic<Node*> head_{ nullptr };
+};
+
+#endif // OCTILLION_MPSC_QUEUE_HEADER
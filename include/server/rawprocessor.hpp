@@ -4,8 +4,11 @@
 #include <map>
 #include <cstdint>
 #include <string>
+#include <vector>
+#include <memory>
 
 #include "server/sslserver.hpp"
+#include "jsonw/jsonw.hpp"
 
 #ifdef MEMORY_DEBUG
 #include "memory/memleak.hpp"
@@ -20,7 +23,7 @@ namespace octillion
 class octillion::RawProcessorClient
 {
     private:
-        const std::string tag_ = "RawProcessorClient";
+        constexpr static const char* tag_ = "RawProcessorClient";
         
     public:
         const static size_t kRawProcessorMaxKeyPoolSize = 9;
@@ -78,7 +81,7 @@ public:
 class octillion::RawProcessor : public octillion::SslServerCallback
 {
     private:
-        const static std::string tag_; // defined in rawprocessor.cpp
+        constexpr static const char* tag_ = "RawProcessor";
         
     public:
         RawProcessor();
@@ -92,9 +95,23 @@ class octillion::RawProcessor : public octillion::SslServerCallback
         
     public:
         static std::error_code senddata( int fd, uint8_t* data, size_t datasize );
+        static std::error_code senddata( int fd, const JsonW& json );
         static std::error_code closefd(int fd);
+
+        // build the header and encrypted payload for data, the key only depends
+        // on datasize, so the same frame can be sent to any client by sendframe()
+        static std::shared_ptr<const std::vector<uint8_t>> frame( const uint8_t* data, size_t datasize );
+        static std::shared_ptr<const std::vector<uint8_t>> frame( const JsonW& json );
+
+        // seal a payload written after kRawProcessorHeaderSize reserved bytes
+        // in place, for caller that assembles the payload itself
+        static std::shared_ptr<const std::vector<uint8_t>> frame( const std::shared_ptr<std::vector<uint8_t>>& buffer );
+        static std::error_code sendframe( int fd, const std::shared_ptr<const std::vector<uint8_t>>& frame );
         
     private:        
+        // fill the header and encrypt the payload that follows it in place
+        static void seal( std::vector<uint8_t>& buffer );
+
         static void encrypt( uint8_t* data, size_t datasize, uint8_t* key, size_t keysize );
         static void decrypt( uint8_t* data, size_t datasize, uint8_t* key, size_t keysize );
 
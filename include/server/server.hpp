@@ -20,7 +20,7 @@ namespace octillion
 class octillion::ServerCallback
 {
     private:
-        const std::string tag_ = "ServerCallback";
+        constexpr static const char* tag_ = "ServerCallback";
         
     public:
         ~ServerCallback() {}
@@ -38,7 +38,7 @@ class octillion::ServerCallback
 class octillion::Server 
 {
     private:
-        const std::string tag_ = "Server";
+        constexpr static const char* tag_ = "Server";
         
     // singleton
     public:
@@ -25,7 +25,7 @@ namespace octillion
 class octillion::SslClientCallback
 {
     private:
-        const std::string tag_ = "SslClientCallback";
+        constexpr static const char* tag_ = "SslClientCallback";
 
     public:       
         virtual int recv( int id, std::error_code error, uint8_t* data, size_t datasize) = 0;
@@ -35,7 +35,7 @@ class octillion::SslClientCallback
 class octillion::SslClient 
 {
     private:
-        const std::string tag_ = "SslClient";
+        constexpr static const char* tag_ = "SslClient";
         const static long int timeout_ = 5; // connect timeout in 5 seconds
         
     // singleton
@@ -23,7 +23,7 @@ namespace octillion
 class octillion::SslServerCallback
 {
     private:
-        const std::string tag_ = "SslServerCallback";
+        constexpr static const char* tag_ = "SslServerCallback";
         
     public:
         ~SslServerCallback() {}
@@ -41,7 +41,7 @@ class octillion::SslServerCallback
 class octillion::SslServer 
 {
     private:
-        const std::string tag_ = "SslServer";
+        constexpr static const char* tag_ = "SslServer";
         
     // singleton
     public:
@@ -63,6 +63,10 @@ class octillion::SslServer
         std::error_code senddata( int fd, const void *buf, size_t len, bool disconnect = false );
         std::error_code senddata( int fd, const std::vector<uint8_t>& data, bool disconnect = false );
 
+        // same as above but the data is queued as it is without a copy, so 
+        // one frame can be sent to many clients
+        std::error_code senddata( int fd, const std::shared_ptr<const std::vector<uint8_t>>& data, bool disconnect = false );
+
         // add fd into close queue and will be closed later in core_task thread
         std::error_code requestclosefd(int fd);
 
@@ -125,7 +129,7 @@ class octillion::SslServer
         struct DataBuffer
         {
             int fd;
-            std::shared_ptr<std::vector<uint8_t>> data;
+            std::shared_ptr<const std::vector<uint8_t>> data;
             bool disconnect;
         };
 
@@ -0,0 +1,156 @@
+#ifndef OCTILLION_WORKER_POOL_HEADER
+#define OCTILLION_WORKER_POOL_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace octillion
+{
+    class WorkerPool;
+}
+
+// fixed set of threads that run one batch of jobs at a time
+//
+// run( count, job ) calls job( 0 ) ... job( count - 1 ), the workers and the
+// caller take the next index from a shared counter until none is left, and
+// run() returns after every job is done. Jobs must not touch each other's
+// data, whatever order they run in. A pool of size 1 has no worker and runs
+// everything on the caller's thread.
+//
+// run() is for one thread only, normally the world tick thread.
+class octillion::WorkerPool
+{
+public:
+    // threads including the caller, 0 picks one per hardware thread
+    WorkerPool( size_t size = 0 )
+    {
+        if ( size == 0 )
+        {
+            size = std::thread::hardware_concurrency();
+        }
+
+        for ( size_t idx = 1; idx < size; idx ++ )
+        {
+            workers_.emplace_back( &WorkerPool::work, this );
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( lock_ );
+            stopping_ = true;
+        }
+
+        wakeup_.notify_all();
+        for ( auto& worker : workers_ )
+        {
+            worker.join();
+        }
+    }
+
+    // avoid accidentally copy
+    WorkerPool( WorkerPool const& ) = delete;
+    void operator = ( WorkerPool const& ) = delete;
+
+public:
+    size_t size() const { return workers_.size() + 1; }
+
+    void run( size_t count, const std::function<void( size_t )>& job )
+    {
+        if ( count == 0 )
+        {
+            return;
+        }
+
+        if ( workers_.empty() || count == 1 )
+        {
+            for ( size_t idx = 0; idx < count; idx ++ )
+            {
+                job( idx );
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( lock_ );
+            job_ = &job;
+            count_ = count;
+            next_.store( 0, std::memory_order_relaxed );
+            busy_ = workers_.size();
+            batch_ ++;
+        }
+
+        wakeup_.notify_all();
+        take( job, count );
+
+        // job_ is owned by the caller, wait until no worker holds it
+        std::unique_lock<std::mutex> lock( lock_ );
+        done_.wait( lock, [this]() { return busy_ == 0; } );
+        job_ = nullptr;
+    }
+
+private:
+    void take( const std::function<void( size_t )>& job, size_t count )
+    {
+        size_t idx;
+        while (( idx = next_.fetch_add( 1, std::memory_order_relaxed )) < count )
+        {
+            job( idx );
+        }
+    }
+
+    void work()
+    {
+        uint_fast64_t batch = 0;
+
+        while ( true )
+        {
+            const std::function<void( size_t )>* job;
+            size_t count;
+
+            {
+                std::unique_lock<std::mutex> lock( lock_ );
+                wakeup_.wait( lock, [this, batch]() { return stopping_ || batch_ != batch; } );
+                if ( stopping_ )
+                {
+                    return;
+                }
+
+                batch = batch_;
+                job = job_;
+                count = count_;
+            }
+
+            take( *job, count );
+
+            {
+                std::lock_guard<std::mutex> lock( lock_ );
+                busy_ --;
+            }
+            done_.notify_one();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::condition_variable done_;
+
+    // following are guarded by lock_, except next_
+    const std::function<void( size_t )>* job_ = nullptr;
+    size_t count_ = 0;
+    size_t busy_ = 0;
+    uint_fast64_t batch_ = 0;
+    bool stopping_ = false;
+    std::atomic<size_t> next_{ 0 };
+};
+
+#endif
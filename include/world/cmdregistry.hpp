@@ -0,0 +1,121 @@
+#ifndef OCTILLION_CMD_REGISTRY_HEADER
+#define OCTILLION_CMD_REGISTRY_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "world/command.hpp"
+
+namespace octillion
+{
+    class CmdStats;
+    template<typename Handler> class CmdRegistry;
+}
+
+// invocation, error and latency counters of one command,
+// record() can be called by multiple threads
+class octillion::CmdStats
+{
+private:
+    constexpr static const char* tag_ = "CmdStats";
+
+public:
+    // latency bucket i counts the calls that take less than 4^i microseconds,
+    // the last bucket counts the rest
+    const static size_t LATENCY_BUCKETS = 11;
+
+public:
+    CmdStats();
+
+    void record(std::chrono::steady_clock::duration elapsed, bool error);
+
+    uint64_t invocations() const { return invocations_.load(); }
+    uint64_t errors() const { return errors_.load(); }
+    uint64_t latency(size_t bucket) const { return latency_[bucket].load(); }
+
+    // upper bound of the bucket in microseconds, 0 means no upper bound
+    static uint64_t bucket_limit(size_t bucket);
+
+    // one line summary, i.e. "calls:10 errors:0 <1us:0 <4us:3 ..."
+    std::string str() const;
+
+private:
+    std::atomic<uint64_t> invocations_;
+    std::atomic<uint64_t> errors_;
+    std::atomic<uint64_t> latency_[LATENCY_BUCKETS];
+};
+
+// binds command id to a handler and its CmdStats, lookup is a vector index
+// so the dispatch cost does not grow with the number of commands
+template<typename Handler>
+class octillion::CmdRegistry
+{
+public:
+    class Entry
+    {
+    public:
+        const CmdDesc* desc_ = nullptr;
+        Handler handler_ = nullptr;
+        CmdStats stats_;
+    };
+
+public:
+    // return false if cmd has no descriptor or is registered already
+    bool add(int cmd, Handler handler)
+    {
+        const CmdDesc* desc = Command::desc(cmd);
+
+        if (desc == nullptr || cmd < 0)
+        {
+            return false;
+        }
+
+        if ((size_t)cmd >= entries_.size())
+        {
+            entries_.resize(cmd + 1);
+        }
+
+        if (entries_[cmd] != nullptr)
+        {
+            return false;
+        }
+
+        entries_[cmd].reset(new Entry());
+        entries_[cmd]->desc_ = desc;
+        entries_[cmd]->handler_ = handler;
+        return true;
+    }
+
+    // return nullptr if cmd is not registered
+    Entry* find(int cmd) const
+    {
+        if (cmd < 0 || (size_t)cmd >= entries_.size())
+        {
+            return nullptr;
+        }
+
+        return entries_[cmd].get();
+    }
+
+    // call func(const Entry&) for each registered command
+    template<typename Func>
+    void foreach(Func func) const
+    {
+        for (const auto& entry : entries_)
+        {
+            if (entry != nullptr)
+            {
+                func(*entry);
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+#endif // OCTILLION_CMD_REGISTRY_HEADER
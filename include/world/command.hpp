@@ -1,11 +1,13 @@
 #ifndef OCTILLION_COMMAND_HEADER
 #define OCTILLION_COMMAND_HEADER
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "world/cube.hpp"
 #include "jsonw/jsonw.hpp"
+#include "memory/objectpool.hpp"
 // [reserved pcid]
 // input - fd
 // output - available pcid
@@ -28,13 +30,89 @@
 
 namespace octillion
 {
+    class CmdParms;
+    class ValidateUsernameParms;
+    class ConfirmUserParms;
+    class LoginParms;
+    class MoveParms;
+    class AreaDataParms;
+    class CmdDesc;
     class Command;
 }
 
+// decoded parameters of a command, each command that has parameters has its
+// own struct and its handler gets that struct instead of json values
+class octillion::CmdParms
+{
+public:
+    virtual ~CmdParms() {}
+};
+
+// s1: username, at least 5 chars
+class octillion::ValidateUsernameParms : public CmdParms
+{
+public:
+    static CmdParms* decode(const JsonW& json);
+
+    std::string username_;
+};
+
+// s1: username, s2: password, i1: gender, i2: class
+class octillion::ConfirmUserParms : public CmdParms
+{
+public:
+    static CmdParms* decode(const JsonW& json);
+
+    std::string username_;
+    std::string password_;
+    uint_fast32_t gender_ = 0;
+    uint_fast32_t cls_ = 0;
+};
+
+// s1: username, s2: password
+class octillion::LoginParms : public CmdParms
+{
+public:
+    static CmdParms* decode(const JsonW& json);
+
+    std::string username_;
+    std::string password_;
+};
+
+// i1: direction, one of Cube::X_INC ... Cube::Z_DEC
+class octillion::MoveParms : public CmdParms
+{
+public:
+    static CmdParms* decode(const JsonW& json);
+
+    uint_fast32_t dir_ = 0;
+};
+
+// i1: area id
+class octillion::AreaDataParms : public CmdParms
+{
+public:
+    static CmdParms* decode(const JsonW& json);
+
+    uint_fast32_t areaid_ = 0;
+};
+
+// compile-time descriptor of a command that client can send, decode_ reads
+// the command object into the parameter struct of the command, it returns
+// nullptr if a parameter is missing or invalid, decode_ is nullptr if the
+// command has no parameters
+class octillion::CmdDesc
+{
+public:
+    int cmd_;
+    const char* name_;
+    CmdParms* (*decode_)(const JsonW& json);
+};
+
 class octillion::Command
 {
 private:
-    const std::string tag_ = "Command";
+    constexpr static const char* tag_ = "Command";
     
 public:
     // create player and login
@@ -65,10 +143,11 @@ public:
     const static int E_CMD_TOO_COMMON_NAME = 102;
     const static int E_CMD_WRONG_USERNAME_PASSWORD = 103;
 	const static int E_CMD_FILE_IO_ERROR = 104;
+	const static int E_CMD_TOO_MANY_COMMANDS = 105;
         
 public:  
     Command( int fd, int cmd );
-    Command( int fd, std::vector<uint8_t>& data );
+    Command( int fd, uint8_t* data, size_t datasize );
 
     //destructor
     ~Command();
@@ -76,17 +155,28 @@ public:
     int fd() { return fd_; }
     int cmd() { return cmd_; }
     bool valid() { return valid_; }
+
+    // return the descriptor of cmd, nullptr if cmd cannot be sent by client
+    static const CmdDesc* desc(int cmd);
+
+    // parameters of a valid command, T is the struct of cmd() in its CmdDesc
+    template<typename T>
+    const T& parms() const { return *static_cast<const T*>( parms_.get() ); }
     
 private:
     int fd_;
     int cmd_;    
     JsonW json_;
+    std::unique_ptr<CmdParms> parms_;
 
 public:
-    std::vector<std::string> strparms_;
-    std::vector<uint_fast32_t> uiparms_;
-
     bool valid_;
+
+public:
+    // created by network threads and deleted by the world tick, see
+    // ObjectPool for the way back
+    static void* operator new( size_t size ) { return ObjectPool<Command>::instance().allocate( size ); }
+    static void operator delete( void* ptr, size_t size ) { ObjectPool<Command>::instance().release( ptr, size ); }
 };
 
 #endif
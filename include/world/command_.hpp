@@ -41,7 +41,7 @@ namespace octillion
 class octillion::Command
 {
 private:
-    const std::string tag_ = "Command";
+    constexpr static const char* tag_ = "Command";
     
 public:
     // create player and login
@@ -72,6 +72,7 @@ public:
     const static int E_CMD_TOO_COMMON_NAME = 102;
     const static int E_CMD_WRONG_USERNAME_PASSWORD = 103;
 	const static int E_CMD_FILE_IO_ERROR = 104;
+	const static int E_CMD_TOO_MANY_COMMANDS = 105;
         
 public:  
     Command( int fd, int cmd );
@@ -2,13 +2,17 @@
 #define OCTILLION_CREATURE_HEADER
 
 #include "world/cube.hpp"
+#include "world/cubestore.hpp"
 
 namespace octillion
 {
 	class Creature;
 }
 
-class octillion::Creature
+// a creature is linked into the occupant lists of its cube and its area
+class octillion::Creature : 
+	public octillion::OccupantHook<octillion::CubeOccupant>,
+	public octillion::OccupantHook<octillion::AreaOccupant>
 {
 public:
 	int_fast32_t hp() { return hp_; }
@@ -21,7 +25,7 @@ protected:
 	int_fast32_t maxhp_ = 10;
     
 public:
-    std::shared_ptr<Cube> loc_;
+    CubeId loc_ = CubeStore::NO_CUBE;
 };
 
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <string>
 #include <system_error>
+#include <list>
 #include <map>
 #include <set>
 #include <memory>
@@ -13,17 +14,23 @@
 #include "world/stringtable.hpp"
 #include "world/script.hpp"
 #include "world/interactive.hpp"
+#include "world/occupantlist.hpp"
 
 namespace octillion
 {
     class Cube;
     class Area;
+    class Creature;
+    class CubeStore;
+
+    // index of a cube in the CubeStore of the map
+    typedef uint32_t CubeId;
 }
 
 class octillion::Cube
 {
 private:
-    const std::string tag_ = "Cube";
+    constexpr static const char* tag_ = "Cube";
 
 public:
     const static int X_INC = octillion::CubePosition::X_INC;
@@ -50,46 +57,77 @@ public:
 
 public:
     Cube(const CubePosition& loc);
-    Cube(const CubePosition& loc, std::shared_ptr<octillion::StringData> title, int areaid, uint_fast32_t attr );
+    Cube(const CubePosition& loc, int areaid, uint_fast32_t attr );
     Cube( const Cube& rhs );
     ~Cube();
 
 public:
     CubePosition loc() { return loc_; }
     uint_fast32_t area() { return areaid_; }
-	bool addlink(std::shared_ptr<Cube> dest, uint_fast32_t attr);
-    bool addlink(std::shared_ptr<Cube> dest);
+
+    // area that creates this cube, NULL if the cube is not read from an area
+    Area* owner() { return owner_; }
+	bool addlink(Cube* dest, uint_fast32_t attr);
+    bool addlink(Cube* dest);
+
+    // title and exit descriptions are kept by the owner area, since most
+    // cubes have none of them
     std::string title();
     std::wstring wtitle();
+    std::shared_ptr<octillion::StringData> exitdesc(int dir);
 
     // convert cube information into json
     // 1 - Event::TYPE_JSON_SIMPLE, for login/logout/arrive/leave event usage
     // 2 - Event::TYPE_JSON_DETAIL, for detail event usage
     std::shared_ptr<JsonW> json(int type);
 
-	// help function, randomly pick one exit | exit_mask > 0.
-	// and cube arribute | attr_mask > 0.
-	// return -1 if no allowed enter
+	// bit 'dir' is set if the cube has an exit in direction 'dir'
+	uint_fast32_t exitmask() { return exitmask_; }
+	bool exit(int dir) { return dir >= 0 && dir < 6 && ((exitmask_ >> dir) & 1) != 0; }
+
+	// there is a cube in direction 'dir', for a diagonal 'dir' the cube 
+	// must also have exits back on both axis, needs findneighbors()
+	bool adjacent(int dir) { return dir >= 0 && dir < TOTAL_EXIT && ((adjacent_ >> dir) & 1) != 0; }
+
+	// cube next to this one in straight direction 'dir', NULL if there is
+	// none or findneighbors() is not called yet
+	Cube* neighbor(int dir) { return dir >= 0 && dir < 6 ? neighbor_[dir] : NULL; }
+
+	// resolve neighbor() and adjacent() from all cubes of the map, called
+	// once after all links of the map are added and 'cubes' is sealed
+	void findneighbors(CubeStore& cubes);
+
+	// help function, randomly pick one exit | exit_mask > 0 that leads to 
+	// a cube, return -1 if no allowed exit
 	int random_exit(uint8_t exit_mask)
 	{
-		std::vector<int> candidate;
-		for (int idx = 0; idx < 6; idx++)
-		{
-			if ((exits_[idx] & exit_mask) > 0 )
-			{
-				candidate.push_back(idx);
-			}
-		}
+		auto rng = []() { return rand(); };
+		return random_exit(exit_mask, rng);
+	}
+
+	// same as above, but draw from 'rng' so that the caller's sequence
+	// does not depend on other threads calling rand()
+	template<typename Rng>
+	int random_exit(uint8_t exit_mask, Rng& rng)
+	{
+		// exits that allow any attribute in exit_mask and lead to a cube
+		unsigned int bits = 
+			((exit_mask & MOB_CUBE) != 0 ? mobexits_ : 0) |
+			((exit_mask & NPC_CUBE) != 0 ? npcexits_ : 0);
+		bits &= exitmask_ & adjacent_;
 
-		if (candidate.size() == 0)
+		if (bits == 0)
 		{
 			return -1;
 		}
-		else
+
+		// drop a random number of lower bits, the lowest left is the pick
+		for (int skip = rng() % __builtin_popcount(bits); skip > 0; skip--)
 		{
-			int idx = rand() % candidate.size();
-			return candidate.at(idx);
+			bits &= bits - 1;
 		}
+
+		return __builtin_ctz(bits);
 	}
 
 public:
@@ -110,36 +148,25 @@ public:
         }
     }
 
-	inline static int dir(std::shared_ptr<Cube> from, std::shared_ptr<Cube> to)
+	// direction from 'from' to its neighbor 'to', -1 if they are not next
+	// to each other, needs findneighbors()
+	inline static int dir(const Cube* from, const Cube* to)
 	{
-		if (from->loc_.x() == to->loc_.x() && from->loc_.y() == to->loc_.y())
+		for (int dir = 0; dir < 6; dir++)
 		{
-			if (from->loc_.z() + 1 == to->loc_.z())
-				return Z_INC;
-			else if (from->loc_.z() - 1 == to->loc_.z())
-				return Z_DEC;
-		}
-		else if (from->loc_.x() == to->loc_.x() && from->loc_.z() == to->loc_.z())
-		{
-			if (from->loc_.y() + 1 == to->loc_.y())
-				return Y_INC;
-			else if (from->loc_.y() - 1 == to->loc_.y())
-				return Y_DEC;
-		}
-		else if (from->loc_.y() == to->loc_.y() && from->loc_.z() == to->loc_.z())
-		{
-			if (from->loc_.x() + 1 == to->loc_.x())
-				return X_INC;
-			else if (from->loc_.x() - 1 == to->loc_.x())
-				return X_DEC;
+			if (from->neighbor_[dir] == to)
+			{
+				return dir;
+			}
 		}
 
 		return -1;
 	}
 
-	inline std::shared_ptr<Cube> find(std::map<CubePosition, std::shared_ptr<Cube>>& cubes_, int dir) 
+private:
+	// position of the cube in direction 'dir', false if 'dir' is invalid
+	inline bool locate(int dir, CubePosition& cbloc)
 	{
-		CubePosition cbloc;
 		switch (dir)
 		{
 		case X_INC: cbloc.set(loc_.x() + 1, loc_.y(), loc_.z()); break;
@@ -153,80 +180,140 @@ public:
         case X_DEC_Y_INC: cbloc.set(loc_.x() - 1, loc_.y() + 1, loc_.z()); break;
         case X_DEC_Y_DEC: cbloc.set(loc_.x() - 1, loc_.y() - 1, loc_.z()); break;
 		default:
-			return nullptr;
+			return false;
 		}
 
-		auto it = cubes_.find(cbloc);
-		if (it == cubes_.end())
-		{
-			return nullptr;
-		}
-		return it->second;
+		return true;
+	}
+
+	// open or close the exit in straight direction 'dir', attr 0 closes 
+	// it, only MOB_CUBE and NPC_CUBE of attr are kept
+	void setexit(int dir, uint_fast32_t attr)
+	{
+		uint16_t bit = (uint16_t)(1 << dir);
+
+		exitmask_ = attr != 0 ? (exitmask_ | bit) : (exitmask_ & ~bit);
+		mobexits_ = (attr & MOB_CUBE) != 0 ? (mobexits_ | bit) : (mobexits_ & ~bit);
+		npcexits_ = (attr & NPC_CUBE) != 0 ? (npcexits_ | bit) : (npcexits_ & ~bit);
 	}
 
 protected:
     int areaid_ = 0;
+    Area* owner_ = NULL;
 
 private:
-	uint_fast32_t attr_ = 0xFFFFFFFF;
+	uint32_t attr_ = 0xFFFFFFFF;
+
+	// one bit per direction, see exit(), adjacent() and random_exit()
+	uint16_t exitmask_ = 0;
+	uint16_t mobexits_ = 0;
+	uint16_t npcexits_ = 0;
+	uint16_t adjacent_ = 0;
+
     CubePosition loc_;
-    std::shared_ptr<octillion::StringData> title_ptr_;
+
+	// resolved at map load, see neighbor()
+	Cube* neighbor_[6] = {};
 
 public:
-	uint_fast32_t exits_[TOTAL_EXIT];
-    uint_fast32_t adjacent_cubes_[TOTAL_EXIT];
-    uint_fast32_t adjacent_exits_[TOTAL_EXIT][TOTAL_EXIT]; 
-    std::shared_ptr<octillion::StringData> desc_exits_[TOTAL_EXIT];
+    // creatures standing in this cube, a copied cube starts empty
+    OccupantList<Creature, CubeOccupant> players_;
+    OccupantList<Creature, CubeOccupant> mobs_;
 
 	friend class WorldMap;
+	friend class Area;
 
 };
 
 class octillion::Area
 {
 private:
-    const std::string tag_ = "Area";
+    constexpr static const char* tag_ = "Area";
 
 public:
-    Area(std::shared_ptr<JsonW> json);
+    // field of desc() for the cube title, otherwise it is an exit direction
+    const static int TITLE = -1;
+
+public:
+    // cubes are added to 'cubes', which must outlive the area
+    Area(std::shared_ptr<JsonW> json, CubeStore& cubes);
+
+    // read area by pulling json events, cubes are created one by one 
+    // without keeping the whole "cubes" array. 'json' gets the other 
+    // fields like "mobs".
+    Area(JsonReaderW& reader, std::shared_ptr<JsonW>& json, CubeStore& cubes);
     ~Area();
 
     bool valid() { return valid_; }
     int id() { return id_; }
     std::string title() { return title_; }
     std::wstring wtitle() { return wtitle_; }
-    std::shared_ptr<Cube> cube(CubePosition loc);
+
+    // cube of this area at 'loc', NULL if there is none
+    Cube* cube(CubePosition loc);
 
     int offset_x() { return offset_x_; }
     int offset_y() { return offset_y_; }
     int offset_z() { return offset_z_; }
 
+    // title or exit description of a cube of this area, nullptr if none
+    std::shared_ptr<octillion::StringData> desc(const Cube* cube, int field);
+
 public:
     // read the mark string and cube in "cubes" in json
     static bool getmark(
         const std::shared_ptr<JsonW> json, 
-        std::map<std::string, std::shared_ptr<Cube>> &marks,
-        const std::map<CubePosition, std::shared_ptr<Cube>>& cubes);
+        std::map<std::string, CubeId> &marks,
+        CubeStore& cubes);
+
+    // add the marks of the cubes in this area to 'marks' as areaid@mark
+    bool getmark(std::map<std::string, CubeId>& marks);
 
 public:
     std::vector<octillion::Script> scripts_;
     octillion::StringTable string_table_;
-    std::map<CubePosition, std::shared_ptr<Cube>> cubes_;
+    std::vector<CubeId> cubes_; // cubes of this area in the store
     std::list<std::shared_ptr<Interactive>> interactives_;
 
+    // creatures standing in the cubes of this area
+    OccupantList<Creature, AreaOccupant> players_;
+    OccupantList<Creature, AreaOccupant> mobs_;
+
 public:
     static bool readloc( const std::shared_ptr<JsonW> jvalue, CubePosition& pos, uint_fast32_t offset_x, uint_fast32_t offset_y, uint_fast32_t offset_z );
-	static bool addlink( bool is_2way, std::shared_ptr<Cube> from, std::shared_ptr<Cube> to, uint_fast32_t attr );
-    static bool addlink( bool is_2way, std::shared_ptr<Cube> from, std::shared_ptr<Cube> to);
+	static bool addlink( bool is_2way, Cube* from, Cube* to, uint_fast32_t attr );
+    static bool addlink( bool is_2way, Cube* from, Cube* to);
 
 private:
     bool valid_ = false;
+    CubeStore* store_;
     int id_;
     uint_fast32_t offset_x_, offset_y_, offset_z_;
     std::string title_;
     std::wstring wtitle_;
 
+    // cube marks in this area and their position
+    std::map<std::string, CubePosition> marks_;
+
+    // cube title or exit desc string id, looked up after "strings" is read
+    struct CubeString
+    {
+        CubeId cube;
+        int field; // TITLE or exit direction
+        int strid;
+    };
+    std::vector<CubeString> cube_strings_;
+
+    // cube titles and exit descriptions by cube id and field, kept here
+    // instead of in every cube
+    std::map<std::pair<CubeId, int>, std::shared_ptr<octillion::StringData>> descs_;
+
 private:
+    bool init(std::shared_ptr<JsonW> json, bool streamed);
+    bool readid(std::shared_ptr<JsonW> json);
+    bool readoffset(std::shared_ptr<JsonW> json);
+    bool readcube(std::shared_ptr<JsonW> jcube);
+    void findstrings();
 
 	friend class WorldMap;
 };
@@ -0,0 +1,198 @@
+#ifndef OCTILLION_CUBE_GRID_HEADER
+#define OCTILLION_CUBE_GRID_HEADER
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "world/cubekey.hpp"
+#include "world/cubeposition.hpp"
+
+namespace octillion
+{
+    class CubeGrid;
+}
+
+// position to cube id index, sparse chunks of dense arrays
+//
+// Space is cut into chunks of CHUNK x CHUNK x CHUNK cubes, a chunk is only
+// allocated when a cube is put in it and holds the id of every position
+// inside as a flat array. find() is one hash of the chunk position and one
+// array index, and box() walks the chunks that overlap the box instead of
+// the whole index. Areas are small and dense boxes far from 0, so most
+// chunks are well filled. Chunks are keyed by the CubeKey of the chunk
+// position, which limits positions to MAX_AXIS on every axis.
+//
+// Not thread-safe for insert(), find() and box() can run concurrently.
+class octillion::CubeGrid
+{
+public:
+    const static uint_fast32_t CHUNK = 16;
+    const static uint32_t NONE = 0xFFFFFFFF;
+    const static uint_fast32_t MAX_AXIS = ( CubeKey::MAX_AXIS + 1 ) * CHUNK - 1;
+
+public:
+    CubeGrid() {}
+
+    // avoid accidentally copy
+    CubeGrid( CubeGrid const& ) = delete;
+    void operator = ( CubeGrid const& ) = delete;
+
+public:
+    static bool valid( const CubePosition& loc )
+    {
+        return loc.x() <= MAX_AXIS && loc.y() <= MAX_AXIS && loc.z() <= MAX_AXIS;
+    }
+
+    size_t size() const { return size_; }
+    size_t chunks() const { return chunks_.size(); }
+
+    // heap used by the chunks and the chunk table, roughly
+    size_t bytes() const
+    {
+        return chunks_.size() * ( sizeof( Chunk ) + sizeof( std::unique_ptr<Chunk> )) +
+            lookup_.size() * ( sizeof( std::pair<CubeKey, size_t> ) + 2 * sizeof( void* )) +
+            lookup_.bucket_count() * sizeof( void* );
+    }
+
+    // put id at loc, false if loc already has an id or is not valid()
+    bool insert( const CubePosition& loc, uint32_t id )
+    {
+        if ( ! valid( loc ))
+        {
+            return false;
+        }
+
+        CubeKey key = chunkkey( loc );
+        auto it = lookup_.find( key );
+
+        Chunk* chunk;
+        if ( it == lookup_.end() )
+        {
+            chunks_.emplace_back( new Chunk );
+            chunk = chunks_.back().get();
+            uint32_t none = NONE; // std::fill() takes it by reference
+            std::fill( chunk->ids_, chunk->ids_ + CELLS, none );
+            lookup_[key] = chunks_.size() - 1;
+        }
+        else
+        {
+            chunk = chunks_[it->second].get();
+        }
+
+        uint32_t& slot = chunk->ids_[cell( loc )];
+        if ( slot != NONE )
+        {
+            return false;
+        }
+
+        slot = id;
+        size_ ++;
+        return true;
+    }
+
+    // id at loc, NONE if there is none
+    uint32_t find( const CubePosition& loc ) const
+    {
+        if ( ! valid( loc ))
+        {
+            return NONE;
+        }
+
+        auto it = lookup_.find( chunkkey( loc ));
+        if ( it == lookup_.end() )
+        {
+            return NONE;
+        }
+
+        return chunks_[it->second]->ids_[cell( loc )];
+    }
+
+    // call f( CubePosition, id ) for every id in the box between lo and hi,
+    // both included, in x, y, z order inside a chunk and chunk by chunk
+    template<typename F>
+    void box( const CubePosition& lo, const CubePosition& hi, F f ) const
+    {
+        uint_fast32_t max = MAX_AXIS;
+        CubePosition top( std::min( hi.x(), max ), std::min( hi.y(), max ), std::min( hi.z(), max ));
+
+        if ( lo.x() > top.x() || lo.y() > top.y() || lo.z() > top.z() )
+        {
+            return;
+        }
+
+        for ( uint_fast32_t cx = lo.x() / CHUNK; cx <= top.x() / CHUNK; cx ++ )
+        {
+            for ( uint_fast32_t cy = lo.y() / CHUNK; cy <= top.y() / CHUNK; cy ++ )
+            {
+                for ( uint_fast32_t cz = lo.z() / CHUNK; cz <= top.z() / CHUNK; cz ++ )
+                {
+                    auto it = lookup_.find( CubeKey( cx, cy, cz ));
+                    if ( it != lookup_.end() )
+                    {
+                        scan( *chunks_[it->second], CubePosition( cx, cy, cz ), lo, top, f );
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const static uint_fast32_t CELLS = CHUNK * CHUNK * CHUNK;
+
+    class Chunk
+    {
+    public:
+        uint32_t ids_[CELLS];
+    };
+
+    static CubeKey chunkkey( const CubePosition& loc )
+    {
+        return CubeKey( loc.x() / CHUNK, loc.y() / CHUNK, loc.z() / CHUNK );
+    }
+
+    static uint_fast32_t cell( const CubePosition& loc )
+    {
+        return (( loc.x() % CHUNK ) * CHUNK + loc.y() % CHUNK ) * CHUNK + loc.z() % CHUNK;
+    }
+
+    // part of the box inside one chunk
+    template<typename F>
+    static void scan( const Chunk& chunk, const CubePosition& key,
+        const CubePosition& lo, const CubePosition& hi, F& f )
+    {
+        uint_fast32_t base[3] = { key.x() * CHUNK, key.y() * CHUNK, key.z() * CHUNK };
+        uint_fast32_t from[3] = { lo.x(), lo.y(), lo.z() };
+        uint_fast32_t to[3] = { hi.x(), hi.y(), hi.z() };
+
+        for ( int idx = 0; idx < 3; idx ++ )
+        {
+            from[idx] = std::max( from[idx], base[idx] ) - base[idx];
+            to[idx] = std::min( to[idx], base[idx] + CHUNK - 1 ) - base[idx];
+        }
+
+        for ( uint_fast32_t x = from[0]; x <= to[0]; x ++ )
+        {
+            for ( uint_fast32_t y = from[1]; y <= to[1]; y ++ )
+            {
+                const uint32_t* row = chunk.ids_ + ( x * CHUNK + y ) * CHUNK;
+                for ( uint_fast32_t z = from[2]; z <= to[2]; z ++ )
+                {
+                    if ( row[z] != NONE )
+                    {
+                        f( CubePosition( base[0] + x, base[1] + y, base[2] + z ), row[z] );
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    size_t size_ = 0;
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    std::unordered_map<CubeKey, size_t> lookup_; // chunk position to chunks_ index
+};
+
+#endif
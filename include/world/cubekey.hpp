@@ -0,0 +1,96 @@
+#ifndef OCTILLION_CUBE_KEY_HEADER
+#define OCTILLION_CUBE_KEY_HEADER
+
+#include <cstdint>
+#include <functional>
+
+#include "world/cubeposition.hpp"
+
+namespace octillion
+{
+    class CubeKey;
+}
+
+// cube position packed into 64 bits, 21 bits per axis in Z-order (Morton)
+//
+// The bits of x, y and z are interleaved, so keys sort by octree: cubes
+// that are close in space are mostly close in a sorted array or an ordered
+// map, and a box of 2^n cubes on every axis is one run of keys. Bits above
+// MAX_AXIS are dropped, valid() tells whether a position fits.
+class octillion::CubeKey
+{
+public:
+    const static uint_fast32_t AXIS_BITS = 21;
+    const static uint_fast32_t MAX_AXIS = ( 1 << AXIS_BITS ) - 1;
+
+public:
+    CubeKey() : code_( 0 ) {}
+    explicit CubeKey( uint64_t code ) : code_( code ) {}
+    CubeKey( uint_fast32_t x, uint_fast32_t y, uint_fast32_t z ) :
+        code_( spread( x ) | ( spread( y ) << 1 ) | ( spread( z ) << 2 )) {}
+    CubeKey( const CubePosition& loc ) : CubeKey( loc.x(), loc.y(), loc.z() ) {}
+
+    static bool valid( const CubePosition& loc )
+    {
+        return loc.x() <= MAX_AXIS && loc.y() <= MAX_AXIS && loc.z() <= MAX_AXIS;
+    }
+
+public:
+    uint64_t code() const { return code_; }
+
+    uint_fast32_t x() const { return compact( code_ ); }
+    uint_fast32_t y() const { return compact( code_ >> 1 ); }
+    uint_fast32_t z() const { return compact( code_ >> 2 ); }
+
+    CubePosition pos() const { return CubePosition( x(), y(), z() ); }
+
+    bool operator < ( const CubeKey& rhs ) const { return code_ < rhs.code_; }
+    bool operator == ( const CubeKey& rhs ) const { return code_ == rhs.code_; }
+    bool operator != ( const CubeKey& rhs ) const { return code_ != rhs.code_; }
+
+private:
+    // put the low 21 bits of v at every third bit
+    static uint64_t spread( uint64_t v )
+    {
+        v &= MAX_AXIS;
+        v = ( v | ( v << 32 )) & 0x001F00000000FFFFULL;
+        v = ( v | ( v << 16 )) & 0x001F0000FF0000FFULL;
+        v = ( v | ( v << 8 )) & 0x100F00F00F00F00FULL;
+        v = ( v | ( v << 4 )) & 0x10C30C30C30C30C3ULL;
+        v = ( v | ( v << 2 )) & 0x1249249249249249ULL;
+        return v;
+    }
+
+    // reverse of spread()
+    static uint_fast32_t compact( uint64_t v )
+    {
+        v &= 0x1249249249249249ULL;
+        v = ( v ^ ( v >> 2 )) & 0x10C30C30C30C30C3ULL;
+        v = ( v ^ ( v >> 4 )) & 0x100F00F00F00F00FULL;
+        v = ( v ^ ( v >> 8 )) & 0x001F0000FF0000FFULL;
+        v = ( v ^ ( v >> 16 )) & 0x001F00000000FFFFULL;
+        v = ( v ^ ( v >> 32 )) & MAX_AXIS;
+        return (uint_fast32_t)v;
+    }
+
+private:
+    uint64_t code_;
+};
+
+// near keys differ in the low bits only, mix them before they pick a bucket
+namespace std {
+
+    template <>
+    struct hash<octillion::CubeKey>
+    {
+        std::size_t operator()(const octillion::CubeKey& key) const
+        {
+            uint64_t h = key.code();
+            h = ( h ^ ( h >> 30 )) * 0xBF58476D1CE4E5B9ULL;
+            h = ( h ^ ( h >> 27 )) * 0x94D049BB133111EBULL;
+            return (std::size_t)( h ^ ( h >> 31 ));
+        }
+    };
+}
+
+#endif
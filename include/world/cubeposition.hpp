@@ -1,6 +1,7 @@
 #ifndef OCTILLION_CUBEPOSITION_HEADER
 #define OCTILLION_CUBEPOSITION_HEADER
 
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -13,9 +14,6 @@ namespace octillion
 
 class octillion::CubePosition
 {
-private:
-    const std::string tag_ = "CubePosition";
-
 public:
     const static int X_INC = 1;
     const static int Y_INC = 2;
@@ -80,9 +78,10 @@ public:
     }
 
 private:
-    uint_fast32_t x_axis_;
-    uint_fast32_t y_axis_;
-    uint_fast32_t z_axis_;
+    // 32 bits per axis whatever uint_fast32_t is, a position is 12 bytes
+    uint32_t x_axis_;
+    uint32_t y_axis_;
+    uint32_t z_axis_;
 };
 
 // add a hash function for CubePosition for unordered_map usage
@@ -93,14 +92,13 @@ namespace std {
     {
         std::size_t operator()(const octillion::CubePosition& key) const
         {
-            // we don't care about the overflow
-            std::size_t a = (std::size_t)key.x();
-            std::size_t b = (std::size_t)key.y();
-            std::size_t c = (std::size_t)key.z();
-
-            // cantor pairing function x 2
-            std::size_t d = 5 * (a + b) * (a + b + 1) + b;
-            return 5 * (c + d) * (c + d + 1) + d;
+            // multiply each axis by a different odd constant and mix, near
+            // positions land in far buckets
+            uint64_t h = (uint64_t)key.x() * 0x9E3779B97F4A7C15ULL;
+            h ^= (uint64_t)key.y() * 0xC2B2AE3D27D4EB4FULL;
+            h ^= (uint64_t)key.z() * 0x165667B19E3779F9ULL;
+            h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+            return (std::size_t)(h ^ (h >> 32));
         }
     };
 }
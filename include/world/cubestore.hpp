@@ -0,0 +1,102 @@
+#ifndef OCTILLION_CUBE_STORE_HEADER
+#define OCTILLION_CUBE_STORE_HEADER
+
+#include <cstdint>
+#include <vector>
+
+#include "world/cube.hpp"
+#include "world/cubegrid.hpp"
+
+namespace octillion
+{
+    class CubeStore;
+}
+
+// all cubes of the map in one array, a cube is referred by its CubeId,
+// the index in the array
+//
+// Areas add their cubes while the map is loading, then seal() fixes the
+// array so that Cube* and CubeId stay valid for the rest of the program.
+// Before seal() the array may move, keep CubeId instead of Cube*.
+// Position lookup is a CubeGrid, a position that is added twice keeps the
+// first cube and is reported by duplicate().
+class octillion::CubeStore
+{
+public:
+    const static CubeId NO_CUBE = CubeGrid::NONE;
+
+public:
+    CubeStore() {}
+
+    // cubes refer to each other by address, avoid accidentally copy
+    CubeStore( CubeStore const& ) = delete;
+    void operator = ( CubeStore const& ) = delete;
+
+public:
+    // add a cube, NO_CUBE if the store is sealed or loc is out of the
+    // grid. A duplicate position does not fail here, see duplicate().
+    CubeId add( const CubePosition& loc, int areaid, uint_fast32_t attr )
+    {
+        if ( sealed_ || cubes_.size() >= NO_CUBE || ! CubeGrid::valid( loc ))
+        {
+            return NO_CUBE;
+        }
+
+        CubeId id = (CubeId)cubes_.size();
+        cubes_.emplace_back( loc, areaid, attr );
+        if ( ! grid_.insert( loc, id ) && duplicate_ == NO_CUBE )
+        {
+            duplicate_ = id;
+        }
+        return id;
+    }
+
+    // stop adding cubes, release the spare capacity
+    void seal()
+    {
+        cubes_.shrink_to_fit();
+        sealed_ = true;
+    }
+
+    bool sealed() const { return sealed_; }
+    size_t size() const { return cubes_.size(); }
+
+    Cube& operator [] ( CubeId id ) { return cubes_[id]; }
+
+    // NULL if 'id' is not in the store
+    Cube* at( CubeId id ) { return id < cubes_.size() ? &cubes_[id] : NULL; }
+
+    // id of a cube in this store
+    CubeId id( const Cube* cube ) const { return (CubeId)( cube - cubes_.data() ); }
+
+    // id of the cube at 'loc', NO_CUBE if there is none
+    CubeId find( const CubePosition& loc ) const { return grid_.find( loc ); }
+
+    // the first cube that shares its position with an earlier one, NO_CUBE
+    // if all positions are unique
+    CubeId duplicate() const { return duplicate_; }
+
+    // cube at 'loc', NULL if there is none
+    Cube* cube( const CubePosition& loc ) { return at( find( loc )); }
+
+    // call f( Cube& ) for every cube in the box between lo and hi, both
+    // included
+    template<typename F>
+    void box( const CubePosition& lo, const CubePosition& hi, F f )
+    {
+        grid_.box( lo, hi, [this, &f]( const CubePosition&, CubeId id ) { f( cubes_[id] ); } );
+    }
+
+    const CubeGrid& grid() const { return grid_; }
+
+    std::vector<Cube>::iterator begin() { return cubes_.begin(); }
+    std::vector<Cube>::iterator end() { return cubes_.end(); }
+
+private:
+    bool sealed_ = false;
+    CubeId duplicate_ = NO_CUBE;
+    std::vector<Cube> cubes_;
+    CubeGrid grid_;
+};
+
+#endif
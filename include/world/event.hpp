@@ -6,6 +6,7 @@
 #include <string>
 
 #include "jsonw/jsonw.hpp"
+#include "memory/objectpool.hpp"
 #include "world/player.hpp"
 
 namespace octillion
@@ -16,7 +17,7 @@ namespace octillion
 class octillion::Event
 {
 public:
-    const std::string tag_ = "Event";
+    constexpr static const char* tag_ = "Event";
 public:
 	const static int RANGE_NONE = 0;
 	const static int RANGE_PRIVATE = 1;
@@ -79,8 +80,11 @@ public:
     // empty event
     Event();
     
-    // operator overriding
-    Event& operator=(const Event& event);
+    // copied into and moved out of World::equeue_, member by member
+    Event(const Event& event) = default;
+    Event(Event&& event) = default;
+    Event& operator=(const Event& event) = default;
+    Event& operator=(Event&& event) = default;
         
     Event( int type ) { type_ = type; }
     
@@ -100,6 +104,11 @@ public:
     bool valid_ = false;
     int  fd_ = 0;
     int  id_ = 0;
+
+public:
+    // a tick creates and deletes many, see ObjectPool
+    static void* operator new( size_t size ) { return ObjectPool<Event>::instance().allocate( size ); }
+    static void operator delete( void* ptr, size_t size ) { ObjectPool<Event>::instance().release( ptr, size ); }
 };
 
 #endif
\ No newline at end of file
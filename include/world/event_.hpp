@@ -23,6 +23,7 @@ public:
 	const static int RANGE_CUBE = 2;
 	const static int RANGE_AREA = 3;
 	const static int RANGE_WORLD = 4;
+	const static int RANGE_NEARBY = 5; // cubes around eventcube_ except player_, see World::nearbyradius()
 
 	const static int TYPE_UNKNOWN = 0;
 
@@ -38,6 +39,10 @@ public:
 
 	const static int TYPE_PLAYER_ATTACK = 16;
 
+	// private, other_ comes into or goes out of the nearby cubes of player_
+	const static int TYPE_PLAYER_APPEAR = 17;
+	const static int TYPE_PLAYER_DISAPPEAR = 18;
+
 	const static int TYPE_MOB_REBORN = 20;
 	const static int TYPE_MOB_DEAD = 21;
 	const static int TYPE_MOB_ARRIVE = 22;
@@ -56,7 +61,8 @@ public:
 public:
     int range_ = RANGE_NONE;
     int type_ = TYPE_UNKNOWN;
-    Player* player_;
+    Player* player_ = NULL;
+    Player* other_ = NULL;
     int areaid_;
     Cube* eventcube_ = NULL;
     Cube* subcube_ = NULL;
@@ -18,7 +18,7 @@ namespace octillion
 class octillion::GameServer : public octillion::ServerCallback, public octillion::SslClientCallback
 {
     private:
-        const std::string tag_ = "GameServer";
+        constexpr static const char* tag_ = "GameServer";
         constexpr static const char* loginserver_addr = "127.0.0.1";
         constexpr static const char* loginserver_port = "8888";
         
@@ -13,7 +13,7 @@ namespace octillion
 class octillion::Interactive
 {
 public:
-    const std::string tag_ = "Interactive";
+    constexpr static const char* tag_ = "Interactive";
 
 public:
     Interactive();
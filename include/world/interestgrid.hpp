@@ -0,0 +1,219 @@
+#ifndef OCTILLION_INTEREST_GRID_HEADER
+#define OCTILLION_INTEREST_GRID_HEADER
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include "world/cubekey.hpp"
+#include "world/cubeposition.hpp"
+
+namespace octillion
+{
+    template<typename T> class InterestGrid;
+}
+
+// area of interest index over cube positions
+//
+// Items (players) are bucketed into cells of CELL x CELL x CELL cubes, so
+// "items within r cubes of a position" only looks at the cells that
+// overlap the (2r+1)^3 box around it instead of a whole area or world.
+// Distance is counted in cubes along the worst axis, so r = 1 is the cube
+// itself and the 26 cubes around it. The relation is symmetric, an item
+// that enters someone's range also has that one in its own range.
+//
+// Not thread-safe, World keeps it on the tick thread.
+template<typename T>
+class octillion::InterestGrid
+{
+public:
+    const static uint_fast32_t CELL = 8;
+    const static uint_fast32_t DEFAULT_RADIUS = 2;
+
+public:
+    InterestGrid( uint_fast32_t radius = DEFAULT_RADIUS ) : radius_( radius ) {}
+
+    // avoid accidentally copy
+    InterestGrid( InterestGrid const& ) = delete;
+    void operator = ( InterestGrid const& ) = delete;
+
+public:
+    // default range of nearby() and move()
+    void radius( uint_fast32_t radius ) { radius_ = radius; }
+    uint_fast32_t radius() const { return radius_; }
+
+    size_t size() const { return items_.size(); }
+
+    // add item at loc, return false if item is already in the grid
+    bool insert( T item, const CubePosition& loc )
+    {
+        CubeKey cellkey = key( loc );
+        if ( ! items_.insert( std::make_pair( item, cellkey )).second )
+        {
+            return false;
+        }
+
+        cells_[cellkey].push_back( Entry( item, loc ));
+        return true;
+    }
+
+    // remove item, return false if item is not in the grid
+    bool erase( T item )
+    {
+        auto it = items_.find( item );
+        if ( it == items_.end() )
+        {
+            return false;
+        }
+
+        unlink( item, it->second );
+        items_.erase( it );
+        return true;
+    }
+
+    // move item to loc, return false if item is not in the grid
+    bool move( T item, const CubePosition& loc )
+    {
+        auto it = items_.find( item );
+        if ( it == items_.end() )
+        {
+            return false;
+        }
+
+        CubeKey to = key( loc );
+        if ( it->second != to )
+        {
+            unlink( item, it->second );
+            cells_[to].push_back( Entry( item, loc ));
+            it->second = to;
+        }
+        else
+        {
+            *find( cells_[to], item ) = Entry( item, loc );
+        }
+
+        return true;
+    }
+
+    // same as above, and tell the items that come into or go out of
+    // radius() of item by this move, both sorted, item itself excluded
+    bool move( T item, const CubePosition& loc, std::vector<T>& entered, std::vector<T>& left )
+    {
+        auto it = items_.find( item );
+        if ( it == items_.end() )
+        {
+            return false;
+        }
+
+        std::vector<T> before, after;
+        const Entry& from = *find( cells_[it->second], item );
+        query( from.loc_, radius_, before );
+        move( item, loc );
+        query( loc, radius_, after );
+
+        std::sort( before.begin(), before.end() );
+        std::sort( after.begin(), after.end() );
+
+        std::set_difference( after.begin(), after.end(), before.begin(), before.end(), std::back_inserter( entered ));
+        std::set_difference( before.begin(), before.end(), after.begin(), after.end(), std::back_inserter( left ));
+
+        entered.erase( std::remove( entered.begin(), entered.end(), item ), entered.end() );
+        left.erase( std::remove( left.begin(), left.end(), item ), left.end() );
+        return true;
+    }
+
+    // items within radius() of loc
+    void nearby( const CubePosition& loc, std::vector<T>& out ) const
+    {
+        query( loc, radius_, out );
+    }
+
+    // items within 'radius' cubes of loc are appended to out, in no
+    // particular order
+    void query( const CubePosition& loc, uint_fast32_t radius, std::vector<T>& out ) const
+    {
+        uint_fast64_t lo[3], hi[3];
+        uint_fast64_t axis[3] = { loc.x(), loc.y(), loc.z() };
+
+        for ( int idx = 0; idx < 3; idx ++ )
+        {
+            lo[idx] = axis[idx] > radius ? axis[idx] - radius : 0;
+            hi[idx] = axis[idx] + radius;
+        }
+
+        for ( uint_fast64_t cx = lo[0] / CELL; cx <= hi[0] / CELL; cx ++ )
+        {
+            for ( uint_fast64_t cy = lo[1] / CELL; cy <= hi[1] / CELL; cy ++ )
+            {
+                for ( uint_fast64_t cz = lo[2] / CELL; cz <= hi[2] / CELL; cz ++ )
+                {
+                    auto itcell = cells_.find( CubeKey( cx, cy, cz ));
+                    if ( itcell == cells_.end() )
+                    {
+                        continue;
+                    }
+
+                    for ( const Entry& entry : itcell->second )
+                    {
+                        const CubePosition& at = entry.loc_;
+                        if ( at.x() >= lo[0] && at.x() <= hi[0] &&
+                             at.y() >= lo[1] && at.y() <= hi[1] &&
+                             at.z() >= lo[2] && at.z() <= hi[2] )
+                        {
+                            out.push_back( entry.item_ );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // item and its position, kept in the cell so that query() does not
+    // look up every item
+    class Entry
+    {
+    public:
+        Entry( T item, const CubePosition& loc ) : item_( item ), loc_( loc ) {}
+
+        T item_;
+        CubePosition loc_;
+    };
+
+    // CubeKey keeps 21 bits per axis, cells far apart may share a key,
+    // query() checks the position of every entry anyway
+    static CubeKey key( const CubePosition& loc )
+    {
+        return CubeKey( loc.x() / CELL, loc.y() / CELL, loc.z() / CELL );
+    }
+
+    static typename std::vector<Entry>::iterator find( std::vector<Entry>& cell, T item )
+    {
+        return std::find_if( cell.begin(), cell.end(), 
+            [&item]( const Entry& entry ) { return entry.item_ == item; } );
+    }
+
+    void unlink( T item, const CubeKey& cellkey )
+    {
+        auto itcell = cells_.find( cellkey );
+        std::vector<Entry>& cell = itcell->second;
+
+        // order inside a cell does not matter, swap with the last one
+        *find( cell, item ) = cell.back();
+        cell.pop_back();
+
+        if ( cell.empty() )
+        {
+            cells_.erase( itcell );
+        }
+    }
+
+private:
+    uint_fast32_t radius_;
+    std::unordered_map<T, CubeKey> items_; // item and its cell key
+    std::unordered_map<CubeKey, std::vector<Entry>> cells_;
+};
+
+#endif
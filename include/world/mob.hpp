@@ -17,7 +17,7 @@ public:
     const static int_fast32_t MAX_MOB_COUNT_IN_AREA = 1000;  
 
 private:
-	const std::string tag_ = "Mob";
+	constexpr static const char* tag_ = "Mob";
 
 public:
     Mob();
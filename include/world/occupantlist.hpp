@@ -0,0 +1,151 @@
+#ifndef OCTILLION_OCCUPANT_LIST_HEADER
+#define OCTILLION_OCCUPANT_LIST_HEADER
+
+#include <cstddef>
+#include <iterator>
+
+namespace octillion
+{
+    // tags of the lists a creature can be in at the same time
+    class CubeOccupant;
+    class AreaOccupant;
+
+    template<typename Tag> class OccupantHook;
+    template<typename T, typename Tag> class OccupantList;
+}
+
+// links of one intrusive list, a creature inherits one hook per tag and
+// is in at most one list of that tag, e.g. the players or the mobs of the
+// cube it stands in
+template<typename Tag>
+class octillion::OccupantHook
+{
+public:
+    OccupantHook() {}
+
+    // a copy is not in any list
+    OccupantHook( const OccupantHook& ) {}
+    OccupantHook& operator = ( const OccupantHook& ) { return *this; }
+
+    bool linked() const { return owner_ != nullptr; }
+
+private:
+    OccupantHook* prev_ = nullptr;
+    OccupantHook* next_ = nullptr;
+    const void* owner_ = nullptr;
+
+    template<typename T, typename ListTag> friend class OccupantList;
+};
+
+// intrusive doubly linked list of the creatures in a cube or an area
+//
+// push() and erase() only relink the hooks inside the creatures, so moving
+// a creature between cubes never allocates and never looks up a map. The
+// list does not own the creatures, a creature must be erased before it is
+// deleted. The order is the order of push(), newest last.
+template<typename T, typename Tag>
+class octillion::OccupantList
+{
+private:
+    typedef OccupantHook<Tag> Hook;
+
+public:
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T* const* pointer;
+        typedef T* reference;
+
+        iterator( Hook* hook ) : hook_( hook ) {}
+
+        T* operator * () const { return static_cast<T*>( hook_ ); }
+        iterator& operator ++ () { hook_ = hook_->next_; return *this; }
+        iterator operator ++ ( int ) { iterator old = *this; hook_ = hook_->next_; return old; }
+        bool operator == ( const iterator& rhs ) const { return hook_ == rhs.hook_; }
+        bool operator != ( const iterator& rhs ) const { return hook_ != rhs.hook_; }
+
+    private:
+        Hook* hook_;
+    };
+
+public:
+    OccupantList() {}
+
+    // a list belongs to its cube or area, avoid accidentally copy
+    OccupantList( OccupantList const& ) = delete;
+    void operator = ( OccupantList const& ) = delete;
+
+public:
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    iterator begin() const { return iterator( head_ ); }
+    iterator end() const { return iterator( nullptr ); }
+
+    bool contains( const T* item ) const
+    {
+        return static_cast<const Hook*>( item )->owner_ == this;
+    }
+
+    // append item, return false if it is already in a list of this tag
+    bool push( T* item )
+    {
+        Hook* hook = static_cast<Hook*>( item );
+        if ( hook->owner_ != nullptr )
+        {
+            return false;
+        }
+
+        hook->owner_ = this;
+        hook->prev_ = tail_;
+        hook->next_ = nullptr;
+
+        if ( tail_ == nullptr )
+        {
+            head_ = hook;
+        }
+        else
+        {
+            tail_->next_ = hook;
+        }
+
+        tail_ = hook;
+        size_ ++;
+        return true;
+    }
+
+    // unlink item, return false if it is not in this list
+    bool erase( T* item )
+    {
+        Hook* hook = static_cast<Hook*>( item );
+        if ( hook->owner_ != this )
+        {
+            return false;
+        }
+
+        ( hook->prev_ == nullptr ? head_ : hook->prev_->next_ ) = hook->next_;
+        ( hook->next_ == nullptr ? tail_ : hook->next_->prev_ ) = hook->prev_;
+
+        hook->prev_ = nullptr;
+        hook->next_ = nullptr;
+        hook->owner_ = nullptr;
+        size_ --;
+        return true;
+    }
+
+    // move item from this list to 'to'
+    bool move( T* item, OccupantList& to )
+    {
+        return erase( item ) && to.push( item );
+    }
+
+private:
+    Hook* head_ = nullptr;
+    Hook* tail_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif
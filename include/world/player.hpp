@@ -13,7 +13,7 @@ namespace octillion
 class octillion::Player : public octillion::Creature
 {
 private:
-	const std::string tag_ = "Player";
+	constexpr static const char* tag_ = "Player";
     
 public:
     int_fast32_t id_;
@@ -17,7 +17,7 @@ namespace octillion
 class octillion::Action
 {
 private:
-    const std::string tag_ = "Action";
+    constexpr static const char* tag_ = "Action";
 
 public:
     const static int ACTION_TYPE_UNKNOWN = 0;
@@ -50,7 +50,7 @@ public:
 class octillion::Condition
 {
 private:
-    const std::string tag_ = "Condition";
+    constexpr static const char* tag_ = "Condition";
 
 public:
     const static int CONDITION_TYPE_UNKNOWN = 0;
@@ -112,7 +112,7 @@ public:
 class octillion::Script
 {
 private:
-    const std::string tag_ = "Script";
+    constexpr static const char* tag_ = "Script";
 
 public:
     const static int TYPE_CONDITION_NONE = 0;
@@ -32,7 +32,7 @@ public:
     const static int SELECT_RANDOMLY = 1;
     const static int SELECT_ORDERLY = 2;
 private:
-    const std::string tag_ = "WorldMap";
+    constexpr static const char* tag_ = "WorldMap";
 
 public:
     StringTable();
@@ -0,0 +1,158 @@
+#ifndef OCTILLION_TICK_SCHEDULER_HEADER
+#define OCTILLION_TICK_SCHEDULER_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace octillion
+{
+    class TickScheduler;
+}
+
+// fixed-timestep tick loop on the steady clock
+//
+// run() sleeps until the next tick is due instead of polling the clock, so
+// an idle server does not burn a core. Ticks are due on a fixed grid of
+// 'period' from the start, the time a tick takes does not push the grid.
+// When a tick runs long and the loop falls behind by whole periods, up to
+// catchup() missed ticks run back to back and the rest are skipped, which
+// keeps the grid phase. catchup(0) skips every missed tick.
+//
+// run(), stats() and the setters are for the tick thread only, stop() can
+// be called from anywhere.
+class octillion::TickScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    const static unsigned int DEFAULT_HZ = 1;
+    const static unsigned int MAX_HZ = 1000;
+    const static unsigned int DEFAULT_CATCHUP = 4;
+
+    // counters since run() starts, durations in microseconds
+    class Stats
+    {
+    public:
+        uint_fast64_t ticks = 0;     // ticks run
+        uint_fast64_t overruns = 0;  // ticks that took longer than a period
+        uint_fast64_t skipped = 0;   // due ticks dropped when behind
+        int_fast64_t last_us = 0;    // duration of the last tick
+        int_fast64_t max_us = 0;     // longest tick
+        int_fast64_t total_us = 0;   // time spent in ticks
+        int_fast64_t lag_us = 0;     // how late the last tick started
+        int_fast64_t max_lag_us = 0; // latest start
+    };
+
+public:
+    TickScheduler( unsigned int hz = DEFAULT_HZ, unsigned int catchup = DEFAULT_CATCHUP )
+    {
+        this->hz( hz );
+        this->catchup( catchup );
+    }
+
+    // ticks per second, clamped into [1, MAX_HZ]
+    void hz( unsigned int hz )
+    {
+        if ( hz == 0 )
+        {
+            hz = 1;
+        }
+        else if ( hz > MAX_HZ )
+        {
+            hz = MAX_HZ;
+        }
+
+        hz_ = hz;
+        period_ = std::chrono::duration_cast<Clock::duration>( std::chrono::seconds( 1 )) / hz;
+    }
+
+    unsigned int hz() const { return hz_; }
+    Clock::duration period() const { return period_; }
+
+    // max missed ticks that run back to back when behind
+    void catchup( unsigned int ticks ) { catchup_ = ticks; }
+    unsigned int catchup() const { return catchup_; }
+
+    // call tick() once every period until it returns false or stop() is
+    // called, the first tick is one period after the start
+    template<typename F>
+    void run( F tick )
+    {
+        Clock::time_point next = Clock::now() + period_;
+        unsigned int behind = 0;
+
+        stats_ = Stats();
+        running_.store( true, std::memory_order_relaxed );
+
+        while ( running_.load( std::memory_order_relaxed ))
+        {
+            std::this_thread::sleep_until( next );
+
+            Clock::time_point start = Clock::now();
+            if ( ! tick() )
+            {
+                break;
+            }
+            Clock::time_point end = Clock::now();
+
+            stats_.ticks ++;
+            stats_.last_us = us( end - start );
+            stats_.total_us += stats_.last_us;
+            stats_.max_us = stats_.last_us > stats_.max_us ? stats_.last_us : stats_.max_us;
+            stats_.lag_us = us( start - next );
+            stats_.max_lag_us = stats_.lag_us > stats_.max_lag_us ? stats_.lag_us : stats_.max_lag_us;
+
+            if ( end - start > period_ )
+            {
+                stats_.overruns ++;
+            }
+
+            next += period_;
+            if ( end < next )
+            {
+                behind = 0;
+                continue;
+            }
+
+            // 'due' ticks are already due, run what the catch up budget
+            // allows back to back and skip the rest on the grid
+            uint_fast64_t due = ( end - next ) / period_ + 1;
+            uint_fast64_t run = catchup_ > behind ? catchup_ - behind : 0;
+
+            if ( due > run )
+            {
+                next += period_ * ( due - run );
+                stats_.skipped += due - run;
+                behind = run > 0 ? behind + 1 : 0;
+            }
+            else
+            {
+                behind ++;
+            }
+        }
+
+        running_.store( false, std::memory_order_relaxed );
+    }
+
+    // run() returns after the current tick
+    void stop() { running_.store( false, std::memory_order_relaxed ); }
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    static int_fast64_t us( Clock::duration duration )
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>( duration ).count();
+    }
+
+private:
+    unsigned int hz_;
+    unsigned int catchup_;
+    Clock::duration period_;
+    Stats stats_;
+    std::atomic<bool> running_{ false };
+};
+
+#endif
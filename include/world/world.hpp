@@ -3,8 +3,9 @@
 
 #include <string>
 #include <map>
-#include <mutex>
+#include <vector>
 
+#include "server/mpscqueue.hpp"
 #include "world/worldmap.hpp"
 #include "world/player.hpp"
 #include "world/event.hpp"
@@ -19,7 +20,7 @@ namespace octillion
 class octillion::World
 {
 private:
-    const std::string tag_ = "World";
+    constexpr static const char* tag_ = "World";
 
 public:
     //Singleton
@@ -37,10 +38,10 @@ public:
     // return true if World can handle this type of event
     bool valid_event( int type );
     
-    // add an event into World's event queue
+    // add an event into World's event queue, never blocks by tick()
     bool add_event( const octillion::Event& event );
 
-    // run one tick    
+    // run one tick, must be called by one thread only
     void tick();
    
 protected:
@@ -59,11 +60,8 @@ private:
     
 private:
     octillion::WorldMap map_;
-    std::queue<octillion::Event> equeue_;
+    octillion::MpscQueue<octillion::Event> equeue_;
     std::map<int_fast32_t,std::shared_ptr<octillion::Player>> players_;
-    
-private:
-    std::mutex mutex_;
 };
 
 #endif
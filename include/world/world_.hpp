@@ -5,15 +5,26 @@
 #include <set>
 #include <list>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <random>
+#include <cstdint>
 
 #include "error/macrolog.hpp"
 #include "error/ocerror.hpp"
 
+#include "server/mpscqueue.hpp"
+#include "server/workerpool.hpp"
+
 #include "world/cube.hpp"
+#include "world/cubestore.hpp"
+#include "world/interestgrid.hpp"
 #include "world/creature.hpp"
 #include "world/player.hpp"
 #include "world/mob.hpp"
 #include "world/command.hpp"
+#include "world/cmdregistry.hpp"
 #include "world/event.hpp"
 
 #include "database/database.hpp"
@@ -37,7 +48,20 @@ private:
 	const std::string global_config_file_ = "data/_global.json";
 
 private:
-    const static std::string tag_;
+    constexpr static const char* tag_ = "World";
+
+public:
+    // max commands waiting in one fd's queue, more than that are rejected
+    // with E_CMD_TOO_MANY_COMMANDS, by addcmd() for incoming_ and by 
+    // fetchcmds() for cmds_
+    const static size_t MAX_QUEUED_CMDS = 16;
+
+    // fds counted in incoming_, commands of larger fds are only bounded by
+    // fetchcmds()
+    const static int MAX_COUNTED_FD = 65536;
+
+    // default max commands handled for one fd in one tick
+    const static size_t DEFAULT_CMDS_PER_TICK = 4;
 
 public:
     //Singleton
@@ -58,33 +82,116 @@ private:
 public:    
     void addcmd(Command* cmd);
 
+    // set max commands handled for one fd in one tick
+    void cmdspertick(size_t count);
+
+    // set the range in cubes of Event::RANGE_NEARBY, called by tick() thread
+    void nearbyradius(uint_fast32_t radius);
+
+    // set threads that tick the areas, 0 is one per hardware thread,
+    // call before the first tick()
+    void tickthreads(size_t count);
+
+    // log invocation, error and latency counters of every handled command
+    void dumpstats();
+
+    // rebuild the serialized global/area data replies from data files,
+    // replies whose stamp is unchanged are kept as they are. Safe to call
+    // from any thread while the world runs, the replies and the stamp of
+    // GET_GLOBAL_DATA_STAMP are swapped at once.
+    std::error_code reloadblobs();
+
 public:
     std::error_code tick();
-	std::error_code tick(Mob* mob, std::list<Event*>& events);
-	std::error_code tick(Player* player, std::list<Event*>& events);
 
 private:
+    // players and mobs of one area, ticked by one thread of tickpool_.
+    // tick(Player*) and tick(Mob*) only change the creatures of their
+    // own partition, everything that touches shared lists or sets is recorded
+    // here and applied by handoff() after all partitions are done
+    class TickPartition
+    {
+    public:
+        uint_fast32_t areaid_ = 0;
+        std::vector<Player*> players_; // in player id order
+        std::vector<Mob*> mobs_; // in mob id order
+        std::list<Event*> events_;
+
+        // handoff, applied in this order
+        std::vector<std::pair<Mob*, Player*>> combats_; // enter combat
+        std::vector<std::pair<Mob*, Player*>> kills_; // leave combat and reborn the player
+        std::vector<std::pair<Mob*, Cube*>> moves_; // mob moves to cube
+
+        // mob's random path, seeded from the world seed, tick and area
+        std::minstd_rand rng_;
+    };
+
+	std::error_code tick(Mob* mob, TickPartition& partition);
+	std::error_code tick(Player* player, TickPartition& partition);
+
+    // split world_players_ and world_mobs_ into partitions_ by area
+    void partition();
+
+    // apply what a partition recorded and move its events into 'events'
+    void handoff(TickPartition& partition, std::list<Event*>& events);
+
+private:
+    // handler of the command that may change the world, called by tick()
+    typedef std::error_code (World::*CmdHandler)(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events);
+
+    // handler of the read-only command, frame is set if reply is precomputed
+    typedef std::error_code (World::*QuickCmdHandler)(int fd, Command* cmd, JsonW* jsonobject, std::shared_ptr<const std::vector<uint8_t>>& frame);
+
+    CmdRegistry<CmdHandler> cmdhandlers_;
+    CmdRegistry<QuickCmdHandler> quickcmdhandlers_;
+
+    // registered in place of a handler that takes the parameter struct of
+    // its command, see CmdDesc
+    template<typename Parms, std::error_code (World::*handler)(int, const Parms&, JsonW*, std::list<Event*>&)>
+    std::error_code withparms(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events)
+    {
+        return (this->*handler)(fd, cmd->parms<Parms>(), jsonobject, events);
+    }
+
+    template<typename Parms, std::error_code (World::*handler)(int, const Parms&, JsonW*, std::shared_ptr<const std::vector<uint8_t>>&)>
+    std::error_code withparms(int fd, Command* cmd, JsonW* jsonobject, std::shared_ptr<const std::vector<uint8_t>>& frame)
+    {
+        return (this->*handler)(fd, cmd->parms<Parms>(), jsonobject, frame);
+    }
+
+private:
+    // answer read-only command on caller's (network) thread, return false
+    // if cmd changes the world state and has to wait for tick()
+    bool quickcmd(Command* cmd);
+
     std::error_code cmdUnknown(int fd, Command *cmd, JsonW* jsonobject);
 
 	// server version query and data update
-	std::error_code cmdGetServerVersion(int fd, Command *cmd, JsonW* jsonobject);
-	std::error_code cmdGetGlobalDataStamp(int fd, Command *cmd, JsonW* jsonobject);
-	std::error_code cmdGetGlobalData(int fd, Command *cmd, JsonW* jsonobject);
-	std::error_code cmdGetAreaData(int fd, Command *cmd, JsonW* jsonobject);
+	std::error_code cmdGetServerVersion(int fd, Command *cmd, JsonW* jsonobject, std::shared_ptr<const std::vector<uint8_t>>& frame);
+	std::error_code cmdGetGlobalDataStamp(int fd, Command *cmd, JsonW* jsonobject, std::shared_ptr<const std::vector<uint8_t>>& frame);
+	std::error_code cmdGetGlobalData(int fd, Command *cmd, JsonW* jsonobject, std::shared_ptr<const std::vector<uint8_t>>& frame);
+	std::error_code cmdGetAreaData(int fd, const AreaDataParms& parms, JsonW* jsonobject, std::shared_ptr<const std::vector<uint8_t>>& frame);
 
     // create and login
 	// there is no logout function, it is stored cmds_out_ and handled by disconnect()
-    std::error_code cmdValidateUsername(int fd, Command *cmd, JsonW* jsonobject);
-    std::error_code cmdConfirmUser(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events);
-    std::error_code cmdLogin(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events );
+    std::error_code cmdValidateUsername(int fd, const ValidateUsernameParms& parms, JsonW* jsonobject, std::list<Event*>& events);
+    std::error_code cmdConfirmUser(int fd, const ConfirmUserParms& parms, JsonW* jsonobject, std::list<Event*>& events);
+    std::error_code cmdLogin(int fd, const LoginParms& parms, JsonW* jsonobject, std::list<Event*>& events );
 
     // move
-    std::error_code cmdMove(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events);
+    std::error_code cmdMove(int fd, const MoveParms& parms, JsonW* jsonobject, std::list<Event*>& events);
 
     // god's command
-    std::error_code cmdFreezeWorld(int fd, Command* cmd, JsonW* jsonobject);
+    std::error_code cmdFreezeWorld(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events);
 
 private:
+    // move all the commands added by addcmd() into cmds_in_, cmds_out_ and cmds_,
+    // called by tick() only
+    void fetchcmds();
+
+    // answer a dropped cmd with E_CMD_TOO_MANY_COMMANDS and delete it
+    void rejectcmd(Command* cmd);
+
     std::error_code connect(int fd);
     std::error_code disconnect(int fd);
 
@@ -93,142 +200,94 @@ private:
     // players enters the world after login
     std::error_code enter(Player* player, std::list<Event*>& events);
 
-    // help function, create/add json object based on event
-    inline void addjsons(Event* event, std::set<Creature*>* players, std::map<int, JsonW*>& jsons);
-	inline void addjsons(Event* event, Player* players, std::map<int, JsonW*>& jsons);
+    // one fd's output of a tick, the last command reply and the events.
+    // Each event is frozen once and shared by all of its recipients.
+    class Outgoing
+    {
+    public:
+        JsonW* cmdback_ = NULL;
+        std::vector<const JsonW*> events_;
+    };
 
-    // help function, move player location and change cube_players_, and area_players_
-    // function WILL NOT check the newloc's existence
-    inline void move(Player* player, Cube* cube_to);
+    // help function, add a frozen event to the recipient's output
+	inline void addevent(const JsonW* jevent, Player* player, std::map<int, Outgoing>& outgoing);
 
-	// help function, reborn the player
-	inline void reborn(Player* player, std::list<Event*>& events);
+    // help function, write {"cmd":cmdback,"events":[...]} into a frame, 
+    // the events are copied from their frozen text
+    static std::shared_ptr<const std::vector<uint8_t>> makeframe(const Outgoing& out);
 
-	// help function, add creature into a cube/area creature map
-	inline static std::set<Creature*>* add(Cube* cube, std::map<Cube*, std::set<Creature*>*>& map, Creature* creature)
-	{
-		auto it = map.find(cube);
-		if (it == map.end())
-		{
-			std::set<Creature*>* cset = new std::set<Creature*>();
-#ifdef MEMORY_DEBUG
-			MemleakRecorder::instance().alloc(__FILE__, __LINE__, cset);
-#endif
-			cset->insert(creature);
-			map[cube] = cset;
-			return cset;
-		}
-		else
-		{
-			std::set<Creature*>* cset = it->second;
-			cset->insert(creature);
-			return cset;
-		}
-	}
-
-	// help function, add creature into a cube/area creature map
-	inline static std::set<Creature*>* erase(Cube* cube, std::map<Cube*, std::set<Creature*>*>& map, Creature* creature)
-	{
-		auto it = map.find(cube);
-		if (it == map.end())
-		{
-			return NULL;
-		}
-		else
-		{
-			std::set<Creature*>* cset = it->second;
-			cset->erase(creature);
-
-			if (cset->size() == 0)
-			{				
-#ifdef MEMORY_DEBUG
-				MemleakRecorder::instance().release(cset);
-#endif
-				delete cset;
-				map.erase(it);
-				return NULL;
-			}
+    // help function, move player location and change the players of the 
+    // cubes and areas, function WILL NOT check the newloc's existence
+    inline void move(Player* player, Cube* cube_to, std::list<Event*>& events);
 
-			return cset;
-		}
-	}
+    // help function, private event of 'type' to player about other, i.e.
+    // Event::TYPE_PLAYER_APPEAR
+    void viewevent(Player* player, Player* other, int type, std::list<Event*>& events);
 
-	inline static std::set<Creature*>* add(int areaid, std::map<int, std::set<Creature*>*>& map, Creature* creature)
-	{
-		auto it = map.find(areaid);
-		if (it == map.end())
-		{
-			std::set<Creature*>* cset = new std::set<Creature*>();
-#ifdef MEMORY_DEBUG
-			MemleakRecorder::instance().alloc(__FILE__, __LINE__, cset);
-#endif
-			cset->insert(creature);
-			map[areaid] = cset;
-			return cset;
-		}
-		else
-		{
-			std::set<Creature*>* cset = it->second;
-			cset->insert(creature);
-			return cset;
-		}
-	}
-
-	inline static std::set<Creature*>* erase(int areaid, std::map<int, std::set<Creature*>*>& map, Creature* creature)
-	{
-		auto it = map.find(areaid);
-		if (it == map.end())
-		{
-			return NULL;
-		}
-		else
-		{
-			std::set<Creature*>* cset = it->second;
-			cset->erase(creature);
-
-			if (cset->size() == 0)
-			{
-#ifdef MEMORY_DEBUG
-				MemleakRecorder::instance().release(cset);
-#endif
-				delete cset;
-				map.erase(it);
-				return NULL;
-			}
+    // help function, area by id, NULL if not found
+    Area* findarea(int areaid);
 
-			return cset;
-		}
-	}
+	// help function, reborn the player
+	inline void reborn(Player* player, std::list<Event*>& events);
+
+    // help function, serialize {"cmd":{"cmd":cmd,"err":0,"data":jdata}} into
+    // a ready-to-send frame, jdata is owned by the frame builder
+    static std::shared_ptr<const std::vector<uint8_t>> makeblob(int cmd, JsonW* jdata);
 
     // read a Cube pointer from global json
     static Cube* readloc(
         JsonW* json,
-        const std::map<int, std::map<std::string, Cube*>*>& area_marks,
-        const std::map<CubePosition, Cube*>& cubes
+        const std::map<int, std::map<std::string, CubeId>*>& area_marks,
+        CubeStore& cubes
     );
 
 private:
     bool initialized_ = false;
-    std::mutex cmds_lock_;
-    std::map<int, Command*> cmds_; // fd and standard cmd
+    MpscQueue<Command*> incoming_; // all cmds from network threads, drained by tick()
+    std::atomic<uint16_t> queued_[MAX_COUNTED_FD] = {}; // standard cmds of each fd in incoming_
+    std::atomic<size_t> cmds_per_tick_{ DEFAULT_CMDS_PER_TICK };
+
+    // per-area tick, partitions_ keeps its capacity between ticks
+    std::unique_ptr<WorkerPool> tickpool_;
+    std::vector<TickPartition> partitions_;
+    TickPartition strays_; // players whose combat target is in another area
+    uint_fast32_t seed_ = 0;
+    uint_fast64_t ticks_ = 0;
+
+    // following containers are accessed by tick() thread only
+    std::map<int, std::list<Command*>> cmds_; // fd and standard cmds in arrival order
 	std::set<Command*> cmds_in_; // connect cmd
 	std::map<int, Command*> cmds_out_; // fd and logout / disconnect cmd
 	std::string global_config_stamp_;
 
 private:
 	std::map<int, std::string> area_files_;
+	std::map<int, std::string> area_stamps_;
+
+private:
+	// precomputed GET_GLOBAL_DATA / GET_AREA_DATA replies, keyed by stamp
+	class Blob
+	{
+	public:
+		std::string stamp_;
+		std::shared_ptr<const std::vector<uint8_t>> frame_;
+	};
+
+	std::mutex reload_lock_; // one reloadblobs() at a time
+	std::mutex blobs_lock_; // global_blob_, area_blobs_ and global_config_stamp_
+	Blob global_blob_;
+	std::map<int, Blob> area_blobs_;
     std::set<Area*> areas_;
-    std::map<CubePosition, Cube*> cubes_; // shortcut to all cubes, DO NOT release the cube.
+    CubeStore cubes_; // all cubes of all areas, sealed after the areas are read
 	Cube* global_reborn_cube_ = NULL;
     
     std::map<int, Creature*> players_;
     std::set<Creature*> world_players_; // shortcut to the players in the world, DO NOT release the player.
-    std::map<Cube*, std::set<Creature*>*> cube_players_; // shortcut to the players in specific cube, DO NOT release the player.
-    std::map<int, std::set<Creature*>*> area_players_; // shortcut to the players in specific area, DO NOT release the player.
+    // players and mobs in a cube or an area are in Cube::players_, Cube::mobs_,
+    // Area::players_ and Area::mobs_
+    InterestGrid<Creature*> nearby_players_; // players by position for RANGE_NEARBY, DO NOT release the player.
 
 	std::map<uint_fast32_t, Creature*> world_mobs_;
-	std::map<Cube*, std::set<Creature*>*> cube_mobs_; // shortcut to the mobs in specific cube, DO NOT release the mobs.
-	std::map<int, std::set<Creature*>*> area_mobs_; // shortcut to the mobs in specific area, DO NOT release the mobs.
 
 	std::set<Creature*> combat_players_;
 	std::set<Creature*> combat_mobs_;
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "world/cube.hpp"
+#include "world/cubestore.hpp"
 #include "world/mob.hpp"
 
 namespace octillion
@@ -19,7 +20,7 @@ private:
     const std::string global_config_filename_ = "_global.json";
 
 private:
-    const std::string tag_ = "WorldMap";
+    constexpr static const char* tag_ = "WorldMap";
 
 public:
     WorldMap();
@@ -33,11 +34,11 @@ public:
     void dump();
 
 private:
-    // read a Cube pointer from global json
-    static std::shared_ptr<octillion::Cube> readloc(
+    // read a cube from global json, CubeStore::NO_CUBE if not found
+    static octillion::CubeId readloc(
         std::shared_ptr<JsonW> json,
-        std::map<std::string, std::shared_ptr<octillion::Cube>>& marks,
-        std::map<octillion::CubePosition, std::shared_ptr<octillion::Cube>> cubes
+        std::map<std::string, octillion::CubeId>& marks,
+        octillion::CubeStore& cubes
     );
 
 private:
@@ -48,13 +49,10 @@ public:
     // std::vector<std::shared_ptr<octillion::Area>> areas_;
     std::map<int,std::shared_ptr<octillion::Area>> areas_;
     
-    // shortcut to all cubes, it might cause cycle reference,
-    // but it is not a problem since we will never have to release
-    // the memory of cubes in the program lifecycle.
-    std::map<CubePosition, std::shared_ptr<Cube>> cubes_;
+    // all cubes of all areas, sealed after the map is loaded
+    CubeStore cubes_;
     
-    // octillion::CubePosition reborn_;
-    std::shared_ptr<Cube> reborn_;
+    CubeId reborn_ = CubeStore::NO_CUBE;
     
     // mobs
     std::map<int_fast32_t,octillion::Mob> mobs_;
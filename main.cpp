@@ -2,14 +2,14 @@
 #include <iostream>
 #include <string>
 #include <system_error>
-#include <thread>
-#include <chrono>
+#include <cstdlib>
 
 #include <signal.h>
 
 #include "error/ocerror.hpp"
 #include "server/coreserver.hpp"
 #include "world/world.hpp"
+#include "world/tickscheduler.hpp"
 #include "server/rawprocessor.hpp"
 #include "error/macrolog.hpp"
 
@@ -22,10 +22,17 @@ void my_function(int sig)
     
 }
 
-int main ()
+int main( int argc, char* argv[] )
 {    
     std::error_code err;
     
+    // optional argv[1], world ticks per second
+    octillion::TickScheduler scheduler;
+    if ( argc > 1 )
+    {
+        scheduler.hz( (unsigned int)std::strtoul( argv[1], NULL, 10 ) );
+    }
+    
     LOG_I() << "main start";
 
     signal(SIGINT, my_function); 
@@ -49,27 +56,27 @@ int main ()
     }
     
     flag = 0;
-    uint64_t lastms = (std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::system_clock::now().time_since_epoch())).count();
-    while( 1 )
+    LOG_I() << "world tick at " << scheduler.hz() << " hz";
+    
+    // SIGINT sets the flag, the next tick sees it and stops the loop
+    scheduler.run( [&err]() 
     {
-        uint64_t nowms = (std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::system_clock::now().time_since_epoch())).count();
-        
-        if ( nowms - lastms > 1000 )
-        {
-            err = octillion::World::get_instance().tick(); 
-            lastms = nowms;
-        }
-
-        if ( err == OcError::E_WORLD_FREEZED )
-        {
-            break;
-        }
-        
         if ( flag == 1 )
         {
-            break;
+            return false;
         }
-    }
+        
+        err = octillion::World::get_instance().tick();
+        return err != OcError::E_WORLD_FREEZED;
+    });
+    
+    const octillion::TickScheduler::Stats& stats = scheduler.stats();
+    LOG_I() << "world stop, ticks:" << stats.ticks 
+            << " overruns:" << stats.overruns 
+            << " skipped:" << stats.skipped
+            << " max tick:" << stats.max_us << "us"
+            << " avg tick:" << ( stats.ticks > 0 ? stats.total_us / (int_fast64_t)stats.ticks : 0 ) << "us"
+            << " max lag:" << stats.max_lag_us << "us";
     
     if ( octillion::CoreServer::get_instance().is_running() )
     {
@@ -60,21 +60,61 @@ void octillion::LoginServer::serialize_guest_data()
 
 void octillion::LoginServer::deserialize_guest_data()
 {
+    auto start = std::chrono::steady_clock::now();
+    
     std::ifstream fin( "userdata" );
-    JsonW jarray( fin );
     
-    for (size_t i = 0; i < jarray.size(); i++)
+    // pull the users one by one straight from the file instead of building
+    // the whole json tree, the file grows with every guest ever created
+    JsonReaderW reader( fin );
+    
+    if ( reader.next() == JsonReaderW::Event::StartArray )
     {
-        octillion::LoginServer::User user;
-        user.serial_id_ = jarray[i][u8"id"].integer();
-        user.bcrypt_ = jarray[i][u8"crypt"].str();
-        user.salt_ = jarray[i][u8"salt"].str();
-        user.create_time_ = jarray[i][u8"create"].str();
-        
-        guest_data_.insert( std::pair<uint32_t, octillion::LoginServer::User>( user.serial_id_, user ));
+        while ( reader.next() == JsonReaderW::Event::StartObject )
+        {
+            octillion::LoginServer::User user;
+            user.serial_id_ = 0;
+            
+            while ( reader.next() == JsonReaderW::Event::Key )
+            {
+                std::string key = reader.str();
+                JsonReaderW::Event event = reader.next();
+                
+                if ( key == u8"id" && event == JsonReaderW::Event::Integer )
+                {
+                    user.serial_id_ = reader.integer();
+                }
+                else if ( key == u8"crypt" && event == JsonReaderW::Event::String )
+                {
+                    user.bcrypt_ = reader.str();
+                }
+                else if ( key == u8"salt" && event == JsonReaderW::Event::String )
+                {
+                    user.salt_ = reader.str();
+                }
+                else if ( key == u8"create" && event == JsonReaderW::Event::String )
+                {
+                    user.create_time_ = reader.str();
+                }
+                else
+                {
+                    reader.skip();
+                }
+            }
+            
+            guest_data_.insert( std::pair<uint32_t, octillion::LoginServer::User>( user.serial_id_, user ));
+        }
     }
     
-    LOG_D(tag_) << "deserialize_guest_data() read " << guest_data_.size() << " data(s).";
+    if ( reader.event() == JsonReaderW::Event::Error )
+    {
+        LOG_E(tag_) << "deserialize_guest_data() bad json in userdata, stop at " << guest_data_.size() << " data(s).";
+    }
+    
+    std::chrono::duration<double, std::milli> elapsed = 
+        std::chrono::steady_clock::now() - start;
+    
+    LOG_I(tag_) << "deserialize_guest_data() read " << guest_data_.size() << " data(s) in " << elapsed.count() << " ms.";
 }
 
 // get max_guest_serial_id_ and put all unused serial id into unused_guest_serial_ids_
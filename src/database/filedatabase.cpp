@@ -19,6 +19,39 @@
 #include "error/ocerror.hpp"
 #include "database/filedatabase.hpp"
 
+namespace
+{
+    // one player file, see FileDatabase::load() and FileDatabase::save()
+    struct PlayerRecord
+    {
+        uint_fast32_t id;
+        std::string username;
+        std::string password;
+        uint_fast32_t gender;
+        uint_fast32_t cls;
+        uint_fast32_t con;
+        uint_fast32_t men;
+        uint_fast32_t luc;
+        uint_fast32_t cha;
+        uint_fast32_t loc[3];
+        uint_fast32_t reborn[3];
+    };
+
+    constexpr JsonFieldW<PlayerRecord> kPlayerFields[] = {
+        { u8"id", &PlayerRecord::id },
+        { u8"username", &PlayerRecord::username },
+        { u8"password", &PlayerRecord::password },
+        { u8"gender", &PlayerRecord::gender },
+        { u8"cls", &PlayerRecord::cls },
+        { u8"con", &PlayerRecord::con },
+        { u8"men", &PlayerRecord::men },
+        { u8"luc", &PlayerRecord::luc },
+        { u8"cha", &PlayerRecord::cha },
+        { u8"loc", &PlayerRecord::loc },
+        { u8"reborn", &PlayerRecord::reborn }
+    };
+}
+
 const std::string octillion::FileDatabase::idxfile_ = "idxdb";
 const std::string octillion::FileDatabase::pplprefix_ = "ppl";
 
@@ -282,70 +315,32 @@ std::error_code octillion::FileDatabase::load(
     std::ifstream fin(filename);
     if (fin.good())
     {
-        JsonW json(fin);
-
-        if (json.valid() == false || json.type() != JsonW::OBJECT )
-        {
-            LOG_E(tag_) << "fatal error, player file:" << filename << " contains invalid json data";
-            return OcError::E_DB_BAD_RECORD;
-        }
-
-        // check if json is valid
-        if (json.get(u8"id") == NULL || json.get(u8"id")->type() != JsonW::INTEGER ||
-            json.get(u8"username") == NULL || json.get(u8"username")->type() != JsonW::STRING ||
-            json.get(u8"password") == NULL || json.get(u8"password")->type() != JsonW::STRING ||
-            json.get(u8"gender") == NULL || json.get(u8"gender")->type() != JsonW::INTEGER ||
-            json.get(u8"cls") == NULL || json.get(u8"cls")->type() != JsonW::INTEGER ||
-            json.get(u8"con") == NULL || json.get(u8"con")->type() != JsonW::INTEGER ||
-            json.get(u8"men") == NULL || json.get(u8"men")->type() != JsonW::INTEGER ||
-            json.get(u8"luc") == NULL || json.get(u8"luc")->type() != JsonW::INTEGER ||
-            json.get(u8"cha") == NULL || json.get(u8"cha")->type() != JsonW::INTEGER ||
-            json.get(u8"loc") == NULL || json.get(u8"loc")->type() != JsonW::ARRAY)
+        std::string text(
+            (std::istreambuf_iterator<char>(fin)),
+            (std::istreambuf_iterator<char>()));
+
+        // one pass over the text, every member is checked and filled on
+        // the way
+        PlayerRecord record;
+        if (JsonBindW::read(text.data(), text.length(), kPlayerFields, record) == false)
         {
-            LOG_E(tag_) << "fatal error, player file:" << filename << " missing json members";
+            LOG_E(tag_) << "fatal error, player file:" << filename << " contains bad or missing json members";
             return OcError::E_DB_BAD_RECORD;
         }
 
         // retrieve data
-        player->id((uint_fast32_t)(json.get(u8"id")->integer()));
-        player->username(json.get(u8"username")->str());
-        player->password(json.get(u8"password")->str());
-        player->gender((uint_fast32_t)json.get(u8"gender")->integer());
-        player->cls((uint_fast32_t)json.get(u8"cls")->integer());
-        player->con((uint_fast32_t)json.get(u8"con")->integer());
-        player->men((uint_fast32_t)json.get(u8"men")->integer());
-        player->luc((uint_fast32_t)json.get(u8"luc")->integer());
-        player->cha((uint_fast32_t)json.get(u8"cha")->integer());
-
-        JsonW* jloc = json.get(u8"loc");
-        if (jloc->size() != 3 ||
-            jloc->get(0)->type() != JsonW::INTEGER ||
-            jloc->get(1)->type() != JsonW::INTEGER ||
-            jloc->get(2)->type() != JsonW::INTEGER)
-        {
-            LOG_E(tag_) << "fatal error, player file:" << filename << " json has bad loc field";
-            return OcError::E_DB_BAD_RECORD;
-        }
-
-        loc.set(
-            (uint_fast32_t) jloc->get(0)->integer(),
-            (uint_fast32_t) jloc->get(1)->integer(),
-            (uint_fast32_t) jloc->get(2)->integer());
-
-		JsonW* jloc_reborn = json.get(u8"reborn");
-		if (jloc_reborn->size() != 3 ||
-			jloc_reborn->get(0)->type() != JsonW::INTEGER ||
-			jloc_reborn->get(1)->type() != JsonW::INTEGER ||
-			jloc_reborn->get(2)->type() != JsonW::INTEGER)
-		{
-			LOG_E(tag_) << "fatal error, player file:" << filename << " json has bad reborn field";
-			return OcError::E_DB_BAD_RECORD;
-		}
-
-		loc_reborn.set(
-			(uint_fast32_t)jloc_reborn->get(0)->integer(),
-			(uint_fast32_t)jloc_reborn->get(1)->integer(),
-			(uint_fast32_t)jloc_reborn->get(2)->integer());
+        player->id(record.id);
+        player->username(record.username);
+        player->password(record.password);
+        player->gender(record.gender);
+        player->cls(record.cls);
+        player->con(record.con);
+        player->men(record.men);
+        player->luc(record.luc);
+        player->cha(record.cha);
+
+        loc.set(record.loc[0], record.loc[1], record.loc[2]);
+        loc_reborn.set(record.reborn[0], record.reborn[1], record.reborn[2]);
 
         return OcError::E_SUCCESS;
     }
@@ -365,33 +360,31 @@ std::error_code octillion::FileDatabase::save( Player* player )
 
     std::string filename = pcfilename(player->id() );
 
-    JsonW* jobject = new JsonW();
-    jobject->add(u8"username", player->username());
-    jobject->add(u8"password", player->password());
-    jobject->add(u8"id", (int)player->id());
-    jobject->add(u8"gender", (int)player->gender());
-    jobject->add(u8"cls", (int)player->cls());
-    jobject->add(u8"con", (int)player->con());
-    jobject->add(u8"men", (int)player->men());
-    jobject->add(u8"luc", (int)player->luc());
-    jobject->add(u8"cha", (int)player->cha());
-
-    JsonW* jloc = new JsonW();
-    jloc->add((long long)(player->cube()->loc().x()));
-    jloc->add((long long)(player->cube()->loc().y()));
-    jloc->add((long long)(player->cube()->loc().z()));
-    jobject->add(u8"loc", jloc);
-
-	JsonW* jloc_reborn = new JsonW();
-	jloc_reborn->add((long long)(player->cube_reborn()->loc().x()));
-	jloc_reborn->add((long long)(player->cube_reborn()->loc().y()));
-	jloc_reborn->add((long long)(player->cube_reborn()->loc().z()));
-	jobject->add(u8"reborn", jloc_reborn);
+    PlayerRecord record;
+    record.id = player->id();
+    record.username = player->username();
+    record.password = player->password();
+    record.gender = player->gender();
+    record.cls = player->cls();
+    record.con = player->con();
+    record.men = player->men();
+    record.luc = player->luc();
+    record.cha = player->cha();
+
+    record.loc[0] = player->cube()->loc().x();
+    record.loc[1] = player->cube()->loc().y();
+    record.loc[2] = player->cube()->loc().z();
+
+    record.reborn[0] = player->cube_reborn()->loc().x();
+    record.reborn[1] = player->cube_reborn()->loc().y();
+    record.reborn[2] = player->cube_reborn()->loc().z();
+
+    std::string text;
+    JsonWriterW<std::string> writer(text);
+    JsonBindW::write(writer, kPlayerFields, record);
 
     std::ofstream pcfile(filename, std::ofstream::out | std::ofstream::trunc);
-    pcfile << (jobject->text(false));
-
-    delete jobject;
+    pcfile << text;
 
     return OcError::E_SUCCESS;
 }
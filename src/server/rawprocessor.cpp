@@ -14,8 +14,6 @@
 #include "world/world.hpp"
 #include "world/command.hpp"
 
-const std::string octillion::RawProcessor::tag_ = "RawProcessor";
-
 octillion::RawProcessorClient::RawProcessorClient()
 {
     LOG_D(tag_) << "RawProcessorClient()";
@@ -67,32 +65,75 @@ void octillion::RawProcessor::connect( int fd )
 
 std::error_code octillion::RawProcessor::senddata( int fd, uint8_t* data, size_t datasize )
 {
+    return sendframe( fd, frame( data, datasize ));
+}
+
+std::error_code octillion::RawProcessor::senddata( int fd, const JsonW& json )
+{
+    return sendframe( fd, frame( json ));
+}
+
+std::shared_ptr<const std::vector<uint8_t>> octillion::RawProcessor::frame( const uint8_t* data, size_t datasize )
+{
+    std::shared_ptr<std::vector<uint8_t>> buffer = 
+        std::make_shared<std::vector<uint8_t>>( sizeof(uint32_t) + datasize );
+    
+    memcpy( (void*) ( buffer->data() + sizeof(uint32_t)),
+            (const void*) data, datasize );
+
+    seal( *buffer );
+
+    return buffer;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> octillion::RawProcessor::frame( const JsonW& json )
+{
+    std::shared_ptr<std::vector<uint8_t>> buffer = 
+        std::make_shared<std::vector<uint8_t>>( sizeof(uint32_t) );
+    
+    // serialize the json text right after the header
+    JsonWriterW<std::vector<uint8_t>> writer( *buffer );
+    writer.value( json );
+
+    seal( *buffer );
+
+    return buffer;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> octillion::RawProcessor::frame( const std::shared_ptr<std::vector<uint8_t>>& buffer )
+{
+    seal( *buffer );
+
+    return buffer;
+}
+
+void octillion::RawProcessor::seal( std::vector<uint8_t>& buffer )
+{
+    size_t datasize = buffer.size() - sizeof(uint32_t);
     uint_fast32_t header = htonl( datasize );
     uint8_t key[RawProcessorClient::kRawProcessorMaxKeyPoolSize];
     size_t keysize = (datasize % ( RawProcessorClient::kRawProcessorMaxKeyPoolSize - 1 )) + 1;
-    uint8_t* buffer = new uint8_t[sizeof(uint32_t) + datasize];
-    std::error_code error;
     
-    memcpy( (void*) buffer, (const void*)&header, sizeof(uint32_t));
-    memcpy( (void*) ( buffer + sizeof(uint32_t)),
-            (const void*) data, datasize );
+    memcpy( (void*) buffer.data(), (const void*)&header, sizeof(uint32_t));
 
     for ( size_t i = 0; i < keysize; i ++ )
     {
         key[i] = kRawProcessorKeyPool[ (datasize + i) % kRawProcessorKeyPoolSize];
     }
     
-    encrypt( (uint8_t*)(buffer + sizeof(uint32_t)), datasize, key, keysize );
-    
-    LOG_D(tag_) << "senddata, fd:" << fd << " size:" << sizeof(uint32_t) + datasize;
-    error = SslServer::get_instance().senddata( fd, (const void*)buffer, sizeof(uint32_t) + datasize );
+    encrypt( (uint8_t*)(buffer.data() + sizeof(uint32_t)), datasize, key, keysize );
+}
+
+std::error_code octillion::RawProcessor::sendframe( int fd, const std::shared_ptr<const std::vector<uint8_t>>& frame )
+{
+    std::error_code error;
 
-    // to suuport memleak.h
-    delete [] buffer;
+    LOG_D(tag_) << "sendframe, fd:" << fd << " size:" << frame->size();
+    error = SslServer::get_instance().senddata( fd, frame );
     
     if ( error != OcError::E_SUCCESS )
     {
-        LOG_E( tag_ ) << "senddata, failed to send data, fd:" << fd << " datasize:" << datasize << " error:" << error;
+        LOG_E( tag_ ) << "sendframe, failed to send data, fd:" << fd << " framesize:" << frame->size() << " error:" << error;
     }
 
     return error;
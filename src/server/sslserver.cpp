@@ -694,6 +694,23 @@ std::error_code octillion::SslServer::senddata( int fd, const std::vector<uint8_
     return OcError::E_SUCCESS;
 }
 
+std::error_code octillion::SslServer::senddata( int fd, const std::shared_ptr<const std::vector<uint8_t>>& data, bool disconnect )
+{
+    LOG_D( tag_ ) << "senddata_ts, add fd:" << fd << " shared datasize:" << data->size() << " into out_data_";
+    
+    out_data_lock_.lock();   
+    
+    DataBuffer buffer;
+    buffer.fd = fd;
+    buffer.disconnect = disconnect;
+    buffer.data = data;
+    
+    out_data_.push_back( buffer );    
+    out_data_lock_.unlock();
+    
+    return OcError::E_SUCCESS;
+}
+
 void octillion::SslServer::closesocket( int fd )
 {
     LOG_D(tag_) << "closesocket() enter, fd: " << fd;
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "world/cmdregistry.hpp"
+
+octillion::CmdStats::CmdStats()
+{
+    invocations_ = 0;
+    errors_ = 0;
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        latency_[i] = 0;
+    }
+}
+
+void octillion::CmdStats::record(std::chrono::steady_clock::duration elapsed, bool error)
+{
+    uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    size_t bucket = 0;
+
+    // find the first bucket that us < 4^bucket
+    while (bucket < LATENCY_BUCKETS - 1 && us >= bucket_limit(bucket))
+    {
+        bucket++;
+    }
+
+    invocations_++;
+    latency_[bucket]++;
+
+    if (error)
+    {
+        errors_++;
+    }
+}
+
+uint64_t octillion::CmdStats::bucket_limit(size_t bucket)
+{
+    if (bucket >= LATENCY_BUCKETS - 1)
+    {
+        return 0;
+    }
+
+    return ((uint64_t)1) << (2 * bucket);
+}
+
+std::string octillion::CmdStats::str() const
+{
+    std::ostringstream oss;
+
+    oss << "calls:" << invocations() << " errors:" << errors();
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        if (bucket_limit(i) == 0)
+        {
+            oss << " >=" << bucket_limit(i - 1) << "us:" << latency(i);
+        }
+        else
+        {
+            oss << " <" << bucket_limit(i) << "us:" << latency(i);
+        }
+    }
+
+    return oss.str();
+}
@@ -12,6 +12,136 @@
 #include "world/command.hpp"
 #include "jsonw/jsonw.hpp"
 
+namespace
+{
+    using octillion::CmdParms;
+    using octillion::CmdDesc;
+    using octillion::Command;
+    using octillion::ValidateUsernameParms;
+    using octillion::ConfirmUserParms;
+    using octillion::LoginParms;
+    using octillion::MoveParms;
+    using octillion::AreaDataParms;
+
+    constexpr JsonFieldW<ValidateUsernameParms> kValidateUsernameFields[] = {
+        { u8"s1", &ValidateUsernameParms::username_ }
+    };
+
+    constexpr JsonFieldW<ConfirmUserParms> kConfirmUserFields[] = {
+        { u8"s1", &ConfirmUserParms::username_ },
+        { u8"s2", &ConfirmUserParms::password_ },
+        { u8"i1", &ConfirmUserParms::gender_ },
+        { u8"i2", &ConfirmUserParms::cls_ }
+    };
+
+    constexpr JsonFieldW<LoginParms> kLoginFields[] = {
+        { u8"s1", &LoginParms::username_ },
+        { u8"s2", &LoginParms::password_ }
+    };
+
+    constexpr JsonFieldW<MoveParms> kMoveFields[] = {
+        { u8"i1", &MoveParms::dir_ }
+    };
+
+    constexpr JsonFieldW<AreaDataParms> kAreaDataFields[] = {
+        { u8"i1", &AreaDataParms::areaid_ }
+    };
+
+    // checks that JsonFieldW cannot express
+    bool check(const ValidateUsernameParms& parms)
+    {
+        return parms.username_.length() >= 5;
+    }
+
+    bool check(const ConfirmUserParms& parms)
+    {
+        return parms.username_.length() >= 5 && parms.password_.length() >= 5;
+    }
+
+    bool check(const LoginParms& parms)
+    {
+        return parms.username_.length() >= 5 && parms.password_.length() >= 5;
+    }
+
+    bool check(const MoveParms& parms)
+    {
+        return parms.dir_ == octillion::Cube::X_INC || parms.dir_ == octillion::Cube::Y_INC || 
+            parms.dir_ == octillion::Cube::Z_INC || parms.dir_ == octillion::Cube::X_DEC || 
+            parms.dir_ == octillion::Cube::Y_DEC || parms.dir_ == octillion::Cube::Z_DEC;
+    }
+
+    bool check(const AreaDataParms&)
+    {
+        return true;
+    }
+
+    // read the command object into a new T, nullptr if it does not fit
+    template<typename T, size_t N>
+    CmdParms* bind(const JsonW& json, const JsonFieldW<T> (&fields)[N])
+    {
+        std::unique_ptr<T> parms(new T());
+
+        if (JsonBindW::read(json, fields, *parms) == false || check(*parms) == false)
+        {
+            return nullptr;
+        }
+
+        return parms.release();
+    }
+
+    // all the commands that client can send
+    constexpr CmdDesc kCmdDescs[] = {
+        { Command::VALIDATE_USERNAME, "VALIDATE_USERNAME", &ValidateUsernameParms::decode },
+        { Command::CONFIRM_USER, "CONFIRM_USER", &ConfirmUserParms::decode },
+        { Command::LOGIN, "LOGIN", &LoginParms::decode },
+        { Command::LOGOUT, "LOGOUT", nullptr },
+        { Command::MOVE_NORMAL, "MOVE_NORMAL", &MoveParms::decode },
+        { Command::FREEZE_WORLD, "FREEZE_WORLD", nullptr },
+        { Command::GET_SERVER_VERSION, "GET_SERVER_VERSION", nullptr },
+        { Command::GET_GLOBAL_DATA_STAMP, "GET_GLOBAL_DATA_STAMP", nullptr },
+        { Command::GET_GLOBAL_DATA, "GET_GLOBAL_DATA", nullptr },
+        { Command::GET_AREA_DATA, "GET_AREA_DATA", &AreaDataParms::decode }
+    };
+}
+
+octillion::CmdParms* octillion::ValidateUsernameParms::decode(const JsonW& json)
+{
+    return bind(json, kValidateUsernameFields);
+}
+
+octillion::CmdParms* octillion::ConfirmUserParms::decode(const JsonW& json)
+{
+    return bind(json, kConfirmUserFields);
+}
+
+octillion::CmdParms* octillion::LoginParms::decode(const JsonW& json)
+{
+    return bind(json, kLoginFields);
+}
+
+octillion::CmdParms* octillion::MoveParms::decode(const JsonW& json)
+{
+    return bind(json, kMoveFields);
+}
+
+octillion::CmdParms* octillion::AreaDataParms::decode(const JsonW& json)
+{
+    return bind(json, kAreaDataFields);
+}
+
+const octillion::CmdDesc* octillion::Command::desc(int cmd)
+{
+    for (const auto& desc : kCmdDescs)
+    {
+        if (desc.cmd_ == cmd)
+        {
+            return &desc;
+        }
+    }
+
+    return nullptr;
+}
+
 octillion::Command::Command(int fd, int cmd)
 {
     switch (cmd)
@@ -30,8 +160,7 @@ octillion::Command::Command(int fd, int cmd)
 
 octillion::Command::Command( int fd, uint8_t* data, size_t datasize )
 {
-    uint_fast32_t uiparm;
-    std::string strparm;
+    const CmdDesc* cmddesc;
 
     LOG_D( tag_ ) << "constructor, datasize:" << datasize;
     fd_ = fd;
@@ -56,7 +185,6 @@ octillion::Command::Command( int fd, uint8_t* data, size_t datasize )
 
     // valid command must contains "cmd" name-value pair as integer
     std::shared_ptr<JsonW> jcmd = json_.get(u8"cmd");
-    std::shared_ptr<JsonW> jvalue;
     if (jcmd == nullptr || jcmd->type() != JsonW::INTEGER )
     {
         LOG_E(tag_) << "cons, json's object has no cmd: " << json_;
@@ -64,107 +192,26 @@ octillion::Command::Command( int fd, uint8_t* data, size_t datasize )
     }
 
     cmd_ = (int)(jcmd->integer());
-    
-    switch( cmd_ )
-    {
-    case LOGIN:
-        // username
-        jvalue = json_.get(u8"s1");
-        
-        if (jvalue == NULL || jvalue->type() != JsonW::STRING)
-        {
-            LOG_E(tag_) << "cons, cmd LOGIN has no s1" << json_;
-            return;
-        }
-
-        strparm = jvalue->str();
-
-        if (strparm.length() < 5)
-        {
-            LOG_E(tag_) << "cons, cmd LOGIN contains s1 that too short" << json_;
-            return;
-        }
-
-        strparms_.push_back(jvalue->str());
-
-        // password
-        jvalue = json_.get(u8"s2");
-        if (jvalue == NULL || jvalue->type() != JsonW::STRING)
-        {
-            LOG_E(tag_) << "cons, cmd LOGIN has no s2" << json_;
-            return;
-        }
-
-        strparm = jvalue->str();
-
-        if (strparm.length() < 5)
-        {
-            LOG_E(tag_) << "cons, cmd LOGIN contains s2 that too short" << json_;
-            return;
-        }
-
-        strparms_.push_back(strparm);
-        valid_ = true;
-        break;       
-
-    case LOGOUT:
-        valid_ = true;
-        break;
 
-    case MOVE_NORMAL:
-        // direction
-        jvalue = json_.get(u8"i1");
-        if (jvalue == NULL || jvalue->type() != JsonW::INTEGER)
-        {
-            LOG_E(tag_) << "cons, cmd MOVE_NORMAL has no i1" << json_;
-            return;
-        }
+    cmddesc = desc(cmd_);
+    if (cmddesc == nullptr)
+    {
+        // unknown cmd
+        return;
+    }
 
-        uiparm = (uint_fast32_t)(jvalue->integer());
-        if (uiparm != Cube::X_INC && uiparm != Cube::Y_INC && uiparm != Cube::Z_INC &&
-            uiparm != Cube::X_DEC && uiparm != Cube::Y_DEC && uiparm != Cube::Z_DEC )
+    // parameters go to the struct of the command
+    if (cmddesc->decode_ != nullptr)
+    {
+        parms_.reset(cmddesc->decode_(json_));
+        if (parms_ == nullptr)
         {
-            LOG_E(tag_) << "cons, cmd MOVE_NORMAL contain invalid direction:" << uiparm;
+            LOG_E(tag_) << "cons, cmd " << cmddesc->name_ << " has missing or invalid parameters: " << json_;
             return;
         }
-
-        uiparms_.push_back(uiparm);
-        valid_ = true;
-        break;
-
-    case FREEZE_WORLD:
-        valid_ = true;
-        break;
-
-	case GET_SERVER_VERSION:
-		valid_ = true;
-		break;
-
-	case GET_GLOBAL_DATA_STAMP:
-		valid_ = true;
-		break;
-
-	case GET_GLOBAL_DATA:
-		valid_ = true;
-		break;
-
-	case GET_AREA_DATA:
-		jvalue = json_.get(u8"i1");
-		if (jvalue == NULL || jvalue->type() != JsonW::INTEGER)
-		{
-			LOG_E(tag_) << "cons, cmd DOWNLOAD_AREA_JSON has no i1" << json_;
-			return;
-		}
-
-		uiparm = (uint_fast32_t)(jvalue->integer());
-		uiparms_.push_back(uiparm);
-		valid_ = true;
-		break;
-
-    default:
-        // unknown cmd
-        return;
     }
+
+    valid_ = true;
 }
 
 octillion::Command::~Command()
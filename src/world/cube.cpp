@@ -1,5 +1,4 @@
 #include <sstream>
-#include <cstring> // memset
 #include <system_error>
 #include <map>
 #include <set>
@@ -7,6 +6,7 @@
 #include <cstdlib> // rand()
 
 #include "world/cube.hpp"
+#include "world/cubestore.hpp"
 #include "world/event.hpp"
 #include "world/script.hpp"
 #include "world/interactive.hpp"
@@ -19,60 +19,56 @@ octillion::Cube::Cube(const CubePosition& loc)
 {
     loc_ = loc;
     areaid_ = 0;
-    std::memset( exits_, 0, sizeof exits_);
-    std::memset(adjacent_cubes_, 0, sizeof adjacent_cubes_);
 }
 
-octillion::Cube::Cube(const CubePosition& loc, std::shared_ptr<octillion::StringData> title_ptr, int areaid, uint_fast32_t attr)
+octillion::Cube::Cube(const CubePosition& loc, int areaid, uint_fast32_t attr)
 {
     loc_ = loc;
     areaid_ = areaid;
-	attr_ = attr;
-    title_ptr_ = title_ptr;
-    std::memset( exits_, 0, sizeof exits_);
-    std::memset(adjacent_cubes_, 0, sizeof adjacent_cubes_);
+	attr_ = (uint32_t)attr;
 }
 
 octillion::Cube::Cube( const Cube& rhs )
 {
     loc_ = rhs.loc_;
     areaid_ = rhs.areaid_;
+    owner_ = rhs.owner_;
 	attr_ = rhs.attr_; 
-    title_ptr_ = rhs.title_ptr_;
-    std::memcpy( exits_, rhs.exits_, sizeof exits_);
-    std::memset(adjacent_cubes_, 0, sizeof adjacent_cubes_);
+    exitmask_ = rhs.exitmask_;
+    mobexits_ = rhs.mobexits_;
+    npcexits_ = rhs.npcexits_;
 }
 
 octillion::Cube::~Cube()
 {
 }
 
-bool octillion::Cube::addlink(std::shared_ptr<Cube> dest, uint_fast32_t attr)
+bool octillion::Cube::addlink(Cube* dest, uint_fast32_t attr)
 {
 	CubePosition to = dest->loc();
 	if (to.x() == loc_.x() + 1 && to.y() == loc_.y() && to.z() == loc_.z())
 	{
-		exits_[X_INC] = attr;
+		setexit(X_INC, attr);
 	}
 	else if (to.x() == loc_.x() - 1 && to.y() == loc_.y() && to.z() == loc_.z())
 	{
-		exits_[X_DEC] = attr;
+		setexit(X_DEC, attr);
 	}
 	else if (to.x() == loc_.x() && to.y() == loc_.y() + 1 && to.z() == loc_.z())
 	{
-		exits_[Y_INC] = attr;
+		setexit(Y_INC, attr);
 	}
 	else if (to.x() == loc_.x() && to.y() == loc_.y() - 1 && to.z() == loc_.z())
 	{
-		exits_[Y_DEC] = attr;
+		setexit(Y_DEC, attr);
 	}
 	else if (to.x() == loc_.x() && to.y() == loc_.y() && to.z() == loc_.z() + 1)
 	{
-		exits_[Z_INC] = attr;
+		setexit(Z_INC, attr);
 	}
 	else if (to.x() == loc_.x() && to.y() == loc_.y() && to.z() == loc_.z() - 1)
 	{
-		exits_[Z_DEC] = attr;
+		setexit(Z_DEC, attr);
 	}
 	else
 	{
@@ -82,25 +78,70 @@ bool octillion::Cube::addlink(std::shared_ptr<Cube> dest, uint_fast32_t attr)
 	return true;
 }
 
-bool octillion::Cube::addlink(std::shared_ptr<Cube> dest)
+bool octillion::Cube::addlink(Cube* dest)
 {
 	return addlink(dest, EXIT_NORMAL);
 }
 
 std::string octillion::Cube::title()
 {
-    if (title_ptr_ == nullptr)
+    std::shared_ptr<octillion::StringData> title = 
+        owner_ == NULL ? nullptr : owner_->desc(this, Area::TITLE);
+
+    if (title == nullptr)
         return std::string();
 
-    return title_ptr_->str_.at(0);
+    return title->str_.at(0);
 }
 
 std::wstring octillion::Cube::wtitle()
 {
-    if (title_ptr_ == nullptr)
+    std::shared_ptr<octillion::StringData> title = 
+        owner_ == NULL ? nullptr : owner_->desc(this, Area::TITLE);
+
+    if (title == nullptr)
         return std::wstring();
 
-    return title_ptr_->wstr_.at(0);
+    return title->wstr_.at(0);
+}
+
+std::shared_ptr<octillion::StringData> octillion::Cube::exitdesc(int dir)
+{
+    if (owner_ == NULL)
+        return nullptr;
+
+    return owner_->desc(this, dir);
+}
+
+void octillion::Cube::findneighbors(CubeStore& cubes)
+{
+    const static struct { int dir; int xback; int yback; } diagonals[] = {
+        { X_INC_Y_INC, X_DEC, Y_DEC },
+        { X_DEC_Y_INC, X_INC, Y_DEC },
+        { X_INC_Y_DEC, X_DEC, Y_INC },
+        { X_DEC_Y_DEC, X_INC, Y_INC } };
+
+    adjacent_ = 0;
+    for (int dir = 0; dir < 6; dir++)
+    {
+        CubePosition cbloc;
+        neighbor_[dir] = locate(dir, cbloc) ? cubes.cube(cbloc) : NULL;
+        if (neighbor_[dir] != NULL)
+        {
+            adjacent_ |= 1 << dir;
+        }
+    }
+
+    // diagonal cube is adjacent if it has exits back on both axis
+    for (const auto& diagonal : diagonals)
+    {
+        CubePosition cbloc;
+        Cube* cube = locate(diagonal.dir, cbloc) ? cubes.cube(cbloc) : NULL;
+        if (cube != NULL && cube->exit(diagonal.xback) && cube->exit(diagonal.yback))
+        {
+            adjacent_ |= 1 << diagonal.dir;
+        }
+    }
 }
 
 // parameter type
@@ -115,9 +156,92 @@ std::shared_ptr<JsonW> octillion::Cube::json(int type)
     return jobject;
 }
 
-octillion::Area::Area( std::shared_ptr<JsonW> json )
+octillion::Area::Area( std::shared_ptr<JsonW> json, CubeStore& cubes )
+{
+    store_ = &cubes;
+    valid_ = init( json, false );
+}
+
+octillion::Area::Area( JsonReaderW& reader, std::shared_ptr<JsonW>& json, CubeStore& cubes )
+{
+    bool streamed = false;
+
+    store_ = &cubes;
+
+    // everything but cubes is kept in json for init() and the caller
+    json = std::make_shared<JsonW>();
+
+    // valid area json is an object
+    if ( reader.next() != JsonReaderW::Event::StartObject )
+    {
+        LOG_D(tag_) << "Area init failed, top json is not a object";
+        return;
+    }
+
+    while ( reader.next() == JsonReaderW::Event::Key )
+    {
+        std::string key = reader.str();
+
+        if ( json->get( key ) != nullptr || ( streamed && key == u8"cubes" ) )
+        {
+            LOG_D(tag_) << "Area init failed, json has duplicate field " << key;
+            return;
+        }
+
+        // cubes are read one by one and dropped once they are created, as
+        // long as id and offset come first. Otherwise the whole array is 
+        // kept for init() like any other field.
+        if ( key == u8"cubes" && readid( json ) && readoffset( json ) )
+        {
+            if ( reader.next() != JsonReaderW::Event::StartArray )
+            {
+                LOG_D(tag_) << "Area init failed, json has no cube field";
+                return;
+            }
+
+            while ( reader.next() == JsonReaderW::Event::StartObject )
+            {
+                if ( readcube( reader.value() ) == false )
+                {
+                    return;
+                }
+            }
+
+            if ( reader.event() != JsonReaderW::Event::EndArray )
+            {
+                LOG_D(tag_) << "Area init failed, json has a cube that is not an object";
+                return;
+            }
+
+            streamed = true;
+        }
+        else
+        {
+            std::shared_ptr<JsonW> jvalue = reader.value();
+            if ( jvalue == nullptr )
+            {
+                LOG_D(tag_) << "Area init failed, json is not valid";
+                return;
+            }
+
+            json->add( key, jvalue );
+        }
+    }
+
+    if ( reader.event() != JsonReaderW::Event::EndObject || 
+         reader.next() != JsonReaderW::Event::End )
+    {
+        LOG_D(tag_) << "Area init failed, json is not valid";
+        return;
+    }
+
+    valid_ = init( json, streamed );
+}
+
+// read area from json, cubes are skipped if they are already read by 
+// readcube() while streaming
+bool octillion::Area::init( std::shared_ptr<JsonW> json, bool streamed )
 {
-    std::map<std::string, CubePosition> markmap;
     std::shared_ptr<JsonW> jvalue;
     std::shared_ptr<JsonW> jstable;
     std::shared_ptr<JsonW> jscripts;
@@ -126,26 +250,21 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
     if ( json == NULL || json->valid() == false )
     {
         LOG_D(tag_) << "Area init failed, json is not valid";
-        return;
+        return false;
     }
     
     // valid area json is an object
     if ( json->type() != JsonW::OBJECT )
     {
         LOG_D(tag_) << "Area init failed, top json is a object";
-        return;
+        return false;
     }
 
     // area json must have id  
-    jvalue = json->get( u8"id" );
-    if (jvalue == NULL || jvalue->type() != JsonW::INTEGER )
+    if ( readid( json ) == false )
     {
         LOG_D(tag_) << "Area init failed, json has no id field";
-        return;     
-    }
-    else
-    {
-        id_ = (int)(jvalue->integer());
+        return false;
     }
 
     // check string table
@@ -168,7 +287,7 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
         if (string_table_.find(strid)->str_.size() == 0 || string_table_.find(strid)->wstr_.size() == 0)
         {
             LOG_D(tag_) << "Area init failed, area title does not have good string table id:" << strid;
-            return;
+            return false;
         }
 
         title_ = string_table_.find(strid)->str_[0];
@@ -177,26 +296,14 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
     else
     {
         LOG_D(tag_) << "Area init failed, json has no valid title field";
-        return;
+        return false;
     }
 
     // area json must have offset array
-    jvalue = json->get( u8"offset" );
-    if (jvalue == NULL || jvalue->type() != JsonW::ARRAY )
+    if ( readoffset( json ) == false )
     {
         LOG_D(tag_) << "Area init failed, json has no offset field";
-        return;     
-    }
-    else
-    {
-        if (jvalue->size() != 3 )
-        {
-            return;
-        }
-        
-        offset_x_ = (int)(jvalue->get(0)->integer());
-        offset_y_ = (int)(jvalue->get(1)->integer());
-        offset_z_ = (int)(jvalue->get(2)->integer());
+        return false;
     }
 
     // read the script
@@ -206,7 +313,7 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
         for (size_t i = 0; i < jscripts->size(); i++)
         {
             octillion::Script script;
-            bool success = script.init(jscripts->get(i), markmap, offset_x_, offset_y_, offset_z_);
+            bool success = script.init(jscripts->get(i), marks_, offset_x_, offset_y_, offset_z_);
             if (!success)
             {
                 LOG_W(tag_) << "Area " << title_ << " has corrupted script data";
@@ -227,11 +334,11 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
             std::shared_ptr<octillion::Interactive> interactive
                 = std::make_shared<octillion::Interactive>();
 
-            bool ret = interactive->init(id(), jvalue->get(i), markmap, offset_x_, offset_y_, offset_z_, string_table_);
+            bool ret = interactive->init(id(), jvalue->get(i), marks_, offset_x_, offset_y_, offset_z_, string_table_);
             if (ret == false)
             {
                 LOG_E(tag_) << "Area " << title_ << " detect bad interactive " << jvalue->text();
-                return;
+                return false;
             }
             interactives_.push_back(interactive);
         }
@@ -240,148 +347,34 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
     }
     
     // area json must have cubes
-    jvalue = json->get(u8"cubes");
-    if (jvalue == nullptr || jvalue->type() != JsonW::ARRAY )
+    if ( streamed == false )
     {
-        LOG_D(tag_) << "Area init failed, json has no cube field";
-        return;
-    }
-    
-    for ( size_t i = 0; i < jvalue->size(); i ++ )
-    {
-        bool ret;
-        std::shared_ptr<octillion::StringData> title_ptr;
-        
-        // "cubes" array must contains only object
-        std::shared_ptr<JsonW> jcube = jvalue->get(i);
-
-        if (jcube == NULL ) // not possible
+        jvalue = json->get(u8"cubes");
+        if (jvalue == nullptr || jvalue->type() != JsonW::ARRAY )
         {
-            LOG_D(tag_) << "Area init failed, json has a cube that is not an object";
-            return;
-        }
-        
-        // get loc and store in pos
-        CubePosition pos;
-        ret = readloc(jcube->get( u8"loc" ), pos, offset_x_, offset_y_, offset_z_ );
-        if ( ret == false )
-        {
-            LOG_D(tag_) << "Area init failed, json has a cube with bad loc";
-            return;
-        }
-        
-        // check if duplicate cube
-        if ( cubes_.find( pos ) != cubes_.end() )
-        {
-            LOG_E(tag_) << "err: duplicate cube, pos x:" << pos.x() << " y:" << pos.y() << " z:" << pos.z();
-            return;
-        }
-        
-        // get title
-        std::shared_ptr<JsonW> jtitle = jcube->get( u8"title" );
-        if (jtitle != nullptr && jtitle->type() == JsonW::INTEGER )        
-        {
-            int strid = (int)(jtitle->integer());
-            title_ptr = string_table_.find(strid);
+            LOG_D(tag_) << "Area init failed, json has no cube field";
+            return false;
         }
-        
-        // get mark if exist (optional)        
-        std::shared_ptr<JsonW> jmark = jcube->get( u8"mark" );
-        if (jmark != NULL && jmark->type() == JsonW::STRING )
-        {
-            std::string markstr = jmark->str();
-
-            if (markstr.length() == 0)
-            {
-                return;
-            }
 
-            // duplicate mark
-            if ( markmap.find(markstr) != markmap.end() )
-            {
-                LOG_E(tag_) << "err: duplicate cube mark " << markstr;
-                return;
-            }
-            else
+        for ( size_t i = 0; i < jvalue->size(); i ++ )
+        {
+            if ( readcube( jvalue->get(i) ) == false )
             {
-                markmap[markstr] = pos;
+                return false;
             }
         }
+    }
 
-		// get attr if exist (optional)
-		std::shared_ptr<JsonW> jattrs = jcube->get(u8"attr");
-		uint_fast32_t attr;
-		if (Cube::json2attr(jattrs, attr) != OcError::E_SUCCESS)
-		{
-			attr = 0xFFFFFFFF;
-		}
-                
-        // create cube and store in cubes_
-        std::shared_ptr<Cube> cube = std::make_shared<Cube>( pos, title_ptr, id_, attr);
-        cubes_[pos] = cube;
-
-        // read exits
-        std::shared_ptr<JsonW> jexits = jcube->get(u8"exits");
-        if (jexits != nullptr && jexits->type() == JsonW::STRING)
-        {
-            std::string exits = jexits->str();
-            if (exits.find('n') != std::string::npos)
-                cube->exits_[octillion::Cube::Y_INC] = octillion::Cube::EXIT_NORMAL;
-            if (exits.find('e') != std::string::npos)
-                cube->exits_[octillion::Cube::X_INC] = octillion::Cube::EXIT_NORMAL;
-            if (exits.find('s') != std::string::npos)
-                cube->exits_[octillion::Cube::Y_DEC] = octillion::Cube::EXIT_NORMAL;
-            if (exits.find('w') != std::string::npos)
-                cube->exits_[octillion::Cube::X_DEC] = octillion::Cube::EXIT_NORMAL;
-            if (exits.find('u') != std::string::npos)
-                cube->exits_[octillion::Cube::Z_INC] = octillion::Cube::EXIT_NORMAL;
-            if (exits.find('d') != std::string::npos)
-                cube->exits_[octillion::Cube::Z_DEC] = octillion::Cube::EXIT_NORMAL;
-        }
-
-        // read exits' desc (options)
-        std::shared_ptr<JsonW> jdesc = jcube->get(u8"nstr");
-        if (jdesc != nullptr && jdesc->type() == JsonW::INTEGER)
-        {
-            int strid = (int)(jdesc->integer());
-            cube->desc_exits_[octillion::Cube::Y_INC] = string_table_.find(strid);
-        }
-
-        jdesc = jcube->get(u8"estr");
-        if (jdesc != nullptr && jdesc->type() == JsonW::INTEGER)
-        {
-            int strid = (int)(jdesc->integer());
-            cube->desc_exits_[octillion::Cube::X_INC] = string_table_.find(strid);
-        }
-
-        jdesc = jcube->get(u8"wstr");
-        if (jdesc != nullptr && jdesc->type() == JsonW::INTEGER)
-        {
-            int strid = (int)(jdesc->integer());
-            cube->desc_exits_[octillion::Cube::X_DEC] = string_table_.find(strid);
-        }
-
-        jdesc = jcube->get(u8"sstr");
-        if (jdesc != nullptr && jdesc->type() == JsonW::INTEGER)
-        {
-            int strid = (int)(jdesc->integer());
-            cube->desc_exits_[octillion::Cube::Y_DEC] = string_table_.find(strid);
-        }
-
-        jdesc = jcube->get(u8"ustr");
-        if (jdesc != nullptr && jdesc->type() == JsonW::INTEGER)
-        {
-            int strid = (int)(jdesc->integer());
-            cube->desc_exits_[octillion::Cube::Z_INC] = string_table_.find(strid);
-        }
-
-        jdesc = jcube->get(u8"dstr");
-        if (jdesc != nullptr && jdesc->type() == JsonW::INTEGER)
-        {
-            int strid = (int)(jdesc->integer());
-            cube->desc_exits_[octillion::Cube::Z_DEC] = string_table_.find(strid);
-        }
+    // CubeStore::add() notes the first position that is added twice
+    CubeId dupid = store_->duplicate();
+    if ( dupid != CubeStore::NO_CUBE )
+    {
+        CubePosition pos = (*store_)[dupid].loc();
+        LOG_E(tag_) << "err: duplicate cube, pos x:" << pos.x() << " y:" << pos.y() << " z:" << pos.z();
+        return false;
     }
+
+    findstrings();
     
     // links is optional in area, although it does not make sense to create area without it
     jvalue = json->get(u8"links");
@@ -396,7 +389,7 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
 			if (jlink == NULL || jlink->type() != JsonW::OBJECT)
 			{
                 LOG_D(tag_) << "Area init failed, json has a link which is not an object";
-				return;
+				return false;
 			}
 
 			bool twoway = true;
@@ -416,16 +409,16 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
 			if (jlinkvalue == NULL)
 			{
                 LOG_E(tag_) << "Area init failed, json has a link with bad from field";
-				return;
+				return false;
 			}
 			else if (jlinkvalue->type() == JsonW::STRING)
 			{
 				std::string str = jlinkvalue->str();
-				auto it = markmap.find(str);
-				if (it == markmap.end())
+				auto it = marks_.find(str);
+				if (it == marks_.end())
 				{
                     LOG_E(tag_) << "Area init failed, json has a link with bad type field";
-					return;
+					return false;
 				}
 				else
 				{
@@ -438,13 +431,13 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
 				if (ret == false)
 				{
                     LOG_E(tag_) << "Area init failed, json has a link with bad array field";
-					return;
+					return false;
 				}
 			}
 			else
 			{
                 LOG_E(tag_) << "Area init failed, json has a link with unknwon represenation";
-				return;
+				return false;
 			}
 
 			// get 'to'
@@ -452,16 +445,16 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
 			if (jlinkvalue == NULL)
 			{
                 LOG_E(tag_) << "Area init failed, json has a link with bad to field";
-				return;
+				return false;
 			}
 			else if (jlinkvalue->type() == JsonW::STRING)
 			{
 				std::string str = jlinkvalue->str();
-				auto it = markmap.find(str);
-				if (it == markmap.end())
+				auto it = marks_.find(str);
+				if (it == marks_.end())
 				{
                     LOG_E(tag_) << "Area init failed, json has a link-to field with undefined mark";
-					return;
+					return false;
 				}
 				else
 				{
@@ -474,26 +467,28 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
 				if (ret == false)
 				{
                     LOG_E(tag_) << "Area init failed, json has a link-to field with loc array";
-					return;
+					return false;
 				}
 			}
 			else
 			{
                 LOG_E(tag_) << "Area init failed, json has a link-to field with unknwon representation";
-				return;
+				return false;
 			}
 
 			// check if from and to both exists
-			if (cubes_.find(from) == cubes_.end())
+			Cube* cubefrom = cube(from);
+			if (cubefrom == NULL)
 			{
                 LOG_E(tag_) << "Area init failed, json has a from field has no cube";
-				return;
+				return false;
 			}
 
-			if (cubes_.find(to) == cubes_.end())
+			Cube* cubeto = cube(to);
+			if (cubeto == NULL)
 			{
                 LOG_E(tag_) << "Area init failed, json has a to field has no cube";
-				return;
+				return false;
 			}
 
 			// get attr if exist (optional)
@@ -506,9 +501,6 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
 			}
 
 			// add link for each cube
-			std::shared_ptr<Cube> cubefrom = cubes_[from];
-			std::shared_ptr<Cube> cubeto = cubes_[to];
-
 			if (hasattrs)
 			{
 				addlink(twoway, cubefrom, cubeto, attr);
@@ -520,8 +512,166 @@ octillion::Area::Area( std::shared_ptr<JsonW> json )
         }
     }
     
-    valid_ = true;
-    return;
+    return true;
+}
+
+bool octillion::Area::readid( std::shared_ptr<JsonW> json )
+{
+    std::shared_ptr<JsonW> jvalue = json->get( u8"id" );
+    if (jvalue == NULL || jvalue->type() != JsonW::INTEGER )
+    {
+        return false;
+    }
+
+    id_ = (int)(jvalue->integer());
+    return true;
+}
+
+bool octillion::Area::readoffset( std::shared_ptr<JsonW> json )
+{
+    std::shared_ptr<JsonW> jvalue = json->get( u8"offset" );
+    if (jvalue == NULL || jvalue->type() != JsonW::ARRAY || jvalue->size() != 3 )
+    {
+        return false;
+    }
+
+    offset_x_ = (int)(jvalue->get(0)->integer());
+    offset_y_ = (int)(jvalue->get(1)->integer());
+    offset_z_ = (int)(jvalue->get(2)->integer());
+    return true;
+}
+
+// create one cube in "cubes" value, id and offset must be ready. Strings
+// are looked up later in findstrings() since "strings" may come after 
+// "cubes" in area json.
+bool octillion::Area::readcube( std::shared_ptr<JsonW> jcube )
+{
+    bool ret;
+
+    // "cubes" array must contains only object
+    if (jcube == NULL )
+    {
+        LOG_D(tag_) << "Area init failed, json has a cube that is not an object";
+        return false;
+    }
+    
+    // get loc and store in pos
+    CubePosition pos;
+    ret = readloc(jcube->get( u8"loc" ), pos, offset_x_, offset_y_, offset_z_ );
+    if ( ret == false )
+    {
+        LOG_D(tag_) << "Area init failed, json has a cube with bad loc";
+        return false;
+    }
+    
+    // get mark if exist (optional)        
+    std::shared_ptr<JsonW> jmark = jcube->get( u8"mark" );
+    if (jmark != NULL && jmark->type() == JsonW::STRING )
+    {
+        std::string markstr = jmark->str();
+
+        if (markstr.length() == 0)
+        {
+            return false;
+        }
+
+        // duplicate mark
+        if ( marks_.find(markstr) != marks_.end() )
+        {
+            LOG_E(tag_) << "err: duplicate cube mark " << markstr;
+            return false;
+        }
+        else
+        {
+            marks_[markstr] = pos;
+        }
+    }
+
+    // get attr if exist (optional)
+    std::shared_ptr<JsonW> jattrs = jcube->get(u8"attr");
+    uint_fast32_t attr;
+    if (Cube::json2attr(jattrs, attr) != OcError::E_SUCCESS)
+    {
+        attr = 0xFFFFFFFF;
+    }
+            
+    // create cube in the store, duplicate position is checked by init()
+    CubeId cubeid = store_->add( pos, id_, attr );
+    if ( cubeid == CubeStore::NO_CUBE )
+    {
+        LOG_E(tag_) << "Area init failed, cube store is sealed or full, or bad cube position";
+        return false;
+    }
+
+    Cube* cube = &(*store_)[cubeid];
+    cube->owner_ = this;
+    cubes_.push_back( cubeid );
+
+    // read exits
+    std::shared_ptr<JsonW> jexits = jcube->get(u8"exits");
+    if (jexits != nullptr && jexits->type() == JsonW::STRING)
+    {
+        std::string exits = jexits->str();
+        if (exits.find('n') != std::string::npos)
+            cube->setexit(octillion::Cube::Y_INC, octillion::Cube::EXIT_NORMAL);
+        if (exits.find('e') != std::string::npos)
+            cube->setexit(octillion::Cube::X_INC, octillion::Cube::EXIT_NORMAL);
+        if (exits.find('s') != std::string::npos)
+            cube->setexit(octillion::Cube::Y_DEC, octillion::Cube::EXIT_NORMAL);
+        if (exits.find('w') != std::string::npos)
+            cube->setexit(octillion::Cube::X_DEC, octillion::Cube::EXIT_NORMAL);
+        if (exits.find('u') != std::string::npos)
+            cube->setexit(octillion::Cube::Z_INC, octillion::Cube::EXIT_NORMAL);
+        if (exits.find('d') != std::string::npos)
+            cube->setexit(octillion::Cube::Z_DEC, octillion::Cube::EXIT_NORMAL);
+    }
+
+    // get title and exits' desc (options)
+    const static struct { const char* key; int field; } strfields[] = {
+        { u8"title", TITLE },
+        { u8"nstr", octillion::Cube::Y_INC },
+        { u8"estr", octillion::Cube::X_INC },
+        { u8"wstr", octillion::Cube::X_DEC },
+        { u8"sstr", octillion::Cube::Y_DEC },
+        { u8"ustr", octillion::Cube::Z_INC },
+        { u8"dstr", octillion::Cube::Z_DEC } };
+
+    for (const auto& field : strfields)
+    {
+        std::shared_ptr<JsonW> jstr = jcube->get(field.key);
+        if (jstr != nullptr && jstr->type() == JsonW::INTEGER)
+        {
+            cube_strings_.push_back({ cubeid, field.field, (int)(jstr->integer()) });
+        }
+    }
+
+    return true;
+}
+
+// look up the cube titles and exits' desc read by readcube()
+void octillion::Area::findstrings()
+{
+    for (const auto& it : cube_strings_)
+    {
+        std::shared_ptr<octillion::StringData> str = string_table_.find(it.strid);
+        if (str != nullptr)
+        {
+            descs_[std::pair<CubeId, int>(it.cube, it.field)] = str;
+        }
+    }
+
+    std::vector<CubeString>().swap(cube_strings_);
+}
+
+std::shared_ptr<octillion::StringData> octillion::Area::desc(const Cube* cube, int field)
+{
+    auto it = descs_.find(std::pair<CubeId, int>(store_->id(cube), field));
+    if (it == descs_.end())
+    {
+        return nullptr;
+    }
+
+    return it->second;
 }
 
 std::error_code octillion::Cube::json2attr(std::shared_ptr<JsonW> jattrs, uint_fast32_t& attr)
@@ -531,6 +681,9 @@ std::error_code octillion::Cube::json2attr(std::shared_ptr<JsonW> jattrs, uint_f
 		return OcError::E_FATAL;
 	}
 
+	// every attribute is on unless the json turns it off
+	attr = 0xFFFFFFFF;
+
 	for (size_t idx = 0; idx < jattrs->size(); idx++)
 	{
 		std::shared_ptr<JsonW> jattr = jattrs->get(idx);
@@ -548,17 +701,17 @@ std::error_code octillion::Cube::json2attr(std::shared_ptr<JsonW> jattrs, uint_f
 	return OcError::E_SUCCESS;
 }
 
-std::shared_ptr<octillion::Cube> octillion::Area::cube(CubePosition loc)
+octillion::Cube* octillion::Area::cube(CubePosition loc)
 {
-    auto it = cubes_.find(loc);
+    Cube* cube = store_->cube(loc);
 
-    if (it == cubes_.end())
+    if (cube == NULL || cube->owner_ != this)
     {
         return NULL;
     }
     else
     {
-        return it->second;
+        return cube;
     }
 }
 
@@ -590,7 +743,7 @@ bool octillion::Area::readloc( const std::shared_ptr<JsonW> jvalue, CubePosition
     return true;
 }
 
-bool octillion::Area::addlink(bool is_2way, std::shared_ptr<Cube> from, std::shared_ptr<Cube> to, uint_fast32_t attr )
+bool octillion::Area::addlink(bool is_2way, Cube* from, Cube* to, uint_fast32_t attr )
 {
 	// 2-way link
 	if (is_2way)
@@ -613,7 +766,7 @@ bool octillion::Area::addlink(bool is_2way, std::shared_ptr<Cube> from, std::sha
 	}
 }
 
-bool octillion::Area::addlink(bool is_2way, std::shared_ptr<Cube> from, std::shared_ptr<Cube> to)
+bool octillion::Area::addlink(bool is_2way, Cube* from, Cube* to)
 {
     // 2-way link
     if (is_2way)
@@ -643,12 +796,9 @@ octillion::Area::~Area()
 // read the mark string and cube position in "cubes" value
 bool octillion::Area::getmark(
         const std::shared_ptr<JsonW> json, 
-        std::map<std::string, std::shared_ptr<Cube>>& marks,
-        const std::map<CubePosition, std::shared_ptr<Cube>>& cubes)
+        std::map<std::string, CubeId>& marks,
+        CubeStore& cubes)
 { 
-    // static func cannot access area::tag_, create a fake one
-    std::string tag_ = "Area";
-    
     int offset_x, offset_y, offset_z;
     size_t size;
     
@@ -697,8 +847,8 @@ bool octillion::Area::getmark(
             continue;
         }
 
-        auto itcube = cubes.find(pos);
-        if (itcube == cubes.end())
+        CubeId cubeid = cubes.find(pos);
+        if (cubeid == CubeStore::NO_CUBE)
         {
             continue;
         }
@@ -715,23 +865,47 @@ bool octillion::Area::getmark(
             // format 'mark' as areaid@mark
             mark = areaid + std::string( "@" ) + jmark->str();
             
-            std::shared_ptr<Cube> cube = itcube->second;
-            
-            if ( cube == nullptr )
-            {
-                octillion::CubePosition pos = itcube->first;
-                LOG_E("Area") << "Fatal error, cube is nullptr for " << pos.json()->text();
-                return false;
-            }
-            
             if ( marks.find( mark ) != marks.end())
             {
                 LOG_E("Area") << "Fatal error, duplicate mark " << mark;
                 return false;
             }
             
-            marks.insert(std::pair<std::string, std::shared_ptr<Cube>>(mark, cube));
+            marks.insert(std::pair<std::string, CubeId>(mark, cubeid));
+        }
+    }
+
+    return true;
+}
+
+// add the marks of the cubes in this area to 'marks' as areaid@mark
+bool octillion::Area::getmark( std::map<std::string, CubeId>& marks )
+{
+    std::string areaid = std::to_string( id_ );
+
+    for (const auto& it : marks_)
+    {
+        if ( it.first.find( '@' ) != std::string::npos )
+        {
+            LOG_E(tag_) << "Invalid area data, id " << areaid << ", mark must not contain '@'";
+            return false;
         }
+
+        Cube* markcube = cube( it.second );
+        if ( markcube == NULL )
+        {
+            continue;
+        }
+
+        std::string mark = areaid + std::string( "@" ) + it.first;
+
+        if ( marks.find( mark ) != marks.end() )
+        {
+            LOG_E(tag_) << "Fatal error, duplicate mark " << mark;
+            return false;
+        }
+
+        marks.insert(std::pair<std::string, CubeId>(mark, store_->id(markcube)));
     }
 
     return true;
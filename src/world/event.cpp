@@ -4,27 +4,47 @@
 #include "jsonw/jsonw.hpp"
 #include "world/event.hpp"
 
-octillion::Event::Event()
+namespace
 {
+    // TYPE_PLAYER_LOGIN
+    struct LoginPayload
+    {
+        std::string user;
+        std::string passwd;
+    };
+
+    constexpr JsonFieldW<LoginPayload> kLoginFields[] = {
+        { u8"user", &LoginPayload::user, JsonFieldW<LoginPayload>::NONEMPTY },
+        { u8"passwd", &LoginPayload::passwd, JsonFieldW<LoginPayload>::NONEMPTY }
+    };
+
+    // TYPE_SERVER_VERIFY_TOKEN and TYPE_PLAYER_VERIFY_TOKEN, the player
+    // does not send ip
+    struct TokenPayload
+    {
+        std::string user;
+        std::string token;
+        std::string ip;
+    };
+
+    constexpr JsonFieldW<TokenPayload> kServerTokenFields[] = {
+        { u8"user", &TokenPayload::user, JsonFieldW<TokenPayload>::NONEMPTY },
+        { u8"token", &TokenPayload::token, JsonFieldW<TokenPayload>::NONEMPTY },
+        { u8"ip", &TokenPayload::ip, JsonFieldW<TokenPayload>::NONEMPTY }
+    };
+
+    constexpr JsonFieldW<TokenPayload> kPlayerTokenFields[] = {
+        { u8"user", &TokenPayload::user, JsonFieldW<TokenPayload>::NONEMPTY },
+        { u8"token", &TokenPayload::token, JsonFieldW<TokenPayload>::NONEMPTY }
+    };
 }
 
-octillion::Event::~Event()
+octillion::Event::Event()
 {
 }
 
-// operator overriding
-octillion::Event& octillion::Event::operator=(const octillion::Event& event)
+octillion::Event::~Event()
 {
-    if ( this != &event )
-    {
-        type_ = event.type_;
-        strparms_ = event.strparms_;
-        valid_ = event.valid_;
-        fd_ = event.fd_;
-        id_ = event.id_;
-    }
-    
-    return *this;
 }
 
 // external event from network with fd and raw data
@@ -67,23 +87,16 @@ octillion::Event::Event( int fd, std::vector<uint8_t>& data )
     
     if ( type_ == TYPE_PLAYER_LOGIN )
     {
-        std::shared_ptr<JsonW> juser = json.get(u8"user");
-        std::shared_ptr<JsonW> jpass = json.get(u8"passwd");
+        LoginPayload login;
         
-        if ( juser == nullptr || juser->type() != JsonW::STRING || juser->str().length() == 0 )
+        if ( JsonBindW::read( json, kLoginFields, login ) == false )
         {
-            LOG_E(tag_) << "invalid login json with no user " << json;
+            LOG_E(tag_) << "invalid login json with no user or passwd " << json;
             return;
         }
         
-        if ( jpass == nullptr || jpass->type() != JsonW::STRING || jpass->str().length() == 0 )
-        {
-            LOG_E(tag_) << "invalid login json with no passwd " << json;
-            return;
-        }
-        
-        strparms_.push_back( juser->str() );
-        strparms_.push_back( jpass->str() );
+        strparms_.push_back( login.user );
+        strparms_.push_back( login.passwd );
         
         valid_ = true;
         
@@ -92,31 +105,17 @@ octillion::Event::Event( int fd, std::vector<uint8_t>& data )
     
     if ( type_ == TYPE_SERVER_VERIFY_TOKEN )
     {
-        std::shared_ptr<JsonW> juser = json.get(u8"user");
-        std::shared_ptr<JsonW> jtoken = json.get(u8"token");
-        std::shared_ptr<JsonW> jip = json.get(u8"ip");
-        
-        if ( juser == nullptr || juser->type() != JsonW::STRING || juser->str().length() == 0 )
-        {
-            LOG_E(tag_) << "invalid login json with no user " << json;
-            return;
-        }
-        
-        if ( jtoken == nullptr || jtoken->type() != JsonW::STRING || jtoken->str().length() == 0 )
-        {
-            LOG_E(tag_) << "invalid login json with no token " << json;
-            return;
-        }
+        TokenPayload token;
         
-        if ( jip == nullptr || jip->type() != JsonW::STRING || jip->str().length() == 0 )
+        if ( JsonBindW::read( json, kServerTokenFields, token ) == false )
         {
-            LOG_E(tag_) << "invalid login json with no ip " << json;
+            LOG_E(tag_) << "invalid login json with no user, token or ip " << json;
             return;
         }
         
-        strparms_.push_back( juser->str() );
-        strparms_.push_back( jtoken->str() );
-        strparms_.push_back( jip->str() );
+        strparms_.push_back( token.user );
+        strparms_.push_back( token.token );
+        strparms_.push_back( token.ip );
         
         valid_ = true;
         
@@ -125,23 +124,16 @@ octillion::Event::Event( int fd, std::vector<uint8_t>& data )
     
     if ( type_ == TYPE_PLAYER_VERIFY_TOKEN )
     {
-        std::shared_ptr<JsonW> juser = json.get(u8"user");
-        std::shared_ptr<JsonW> jtoken = json.get(u8"token");
-        
-        if ( juser == nullptr || juser->type() != JsonW::STRING || juser->str().length() == 0 )
-        {
-            LOG_E(tag_) << "invalid login json with no user " << json;
-            return;
-        }
+        TokenPayload token;
         
-        if ( jtoken == nullptr || jtoken->type() != JsonW::STRING || jtoken->str().length() == 0 )
+        if ( JsonBindW::read( json, kPlayerTokenFields, token ) == false )
         {
-            LOG_E(tag_) << "invalid login json with no token " << json;
+            LOG_E(tag_) << "invalid login json with no user or token " << json;
             return;
         }
         
-        strparms_.push_back( juser->str() );
-        strparms_.push_back( jtoken->str() );
+        strparms_.push_back( token.user );
+        strparms_.push_back( token.token );
         
         valid_ = true;
         
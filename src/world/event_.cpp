@@ -56,6 +56,14 @@ octillion::JsonW* octillion::Event::json()
 		jobject->add("cube", eventcube_->json(Cube::J_MOB | Cube::J_PLAYER));
 		break;
 
+	case TYPE_PLAYER_APPEAR:
+		jobject->add("player", other_->json(Player::J_CUBE));
+		break;
+
+	case TYPE_PLAYER_DISAPPEAR:
+		jobject->add("player", other_->json(0));
+		break;
+
 	case TYPE_PLAYER_ATTACK:
 		jobject->add("mob", mob_->json(Player::J_HP));
 		jobject->add("player", player_->json(0));
@@ -1,4 +1,4 @@
-#include <queue>
+#include <vector>
 
 #include "error/ocerror.hpp"
 #include "error/macrolog.hpp"
@@ -74,13 +74,13 @@ void octillion::World::event_move( const octillion::Event& event )
 {
     octillion::Event pevent;    
     int dir = event.type_ - octillion::Event::TYPE_CMD_MOVE_OFFSET;
-    std::shared_ptr<octillion::Cube> c_from = event.player_.lock()->loc_;
-    std::shared_ptr<octillion::Cube> c_to = c_from->find( map_.cubes_, dir );
+    octillion::Cube& c_from = map_.cubes_[event.player_.lock()->loc_];
+    octillion::Cube* c_to = c_from.exit( dir ) ? c_from.neighbor( dir ) : NULL;
     
     pevent.id_ = event.id_;
     pevent.fd_ = event.fd_;
     
-    if ( c_to == nullptr || c_from->exits_[dir] == 0 )
+    if ( c_to == NULL )
     {
         // it should not happen since client already did the checking
         pevent.type_ = octillion::Event::TYPE_ERROR_NO_EXIT;
@@ -88,9 +88,9 @@ void octillion::World::event_move( const octillion::Event& event )
         return;
     }
     
-    event.player_.lock()->loc_ = c_to;
+    event.player_.lock()->loc_ = map_.cubes_.id( c_to );
     
-    LOG_D(tag_) << "event_move p" << event.id_ << " move to " << event.player_.lock()->loc_->title();
+    LOG_D(tag_) << "event_move p" << event.id_ << " move to " << c_to->title();
     
     // send new position to end-user
     pevent.type_ = octillion::Event::TYPE_PLAYER_LOCATION;
@@ -120,22 +120,21 @@ bool octillion::World::valid_event( int type )
 
 bool octillion::World::add_event( const octillion::Event& event )
 {
-    mutex_.lock();    
-    equeue_.push( event );    
-    mutex_.unlock();
+    equeue_.push( event );
     
     return true;
 }
 
 void octillion::World::tick()
 {   
-    mutex_.lock();
+    std::vector<octillion::Event> events;
+
+    // take all the events at once, events added after this line
+    // are handled in the next tick
+    equeue_.drain( events );
     
-    // pop the front event and handle it
-    while( ! equeue_.empty() )
+    for ( auto& event : events )
     {
-        octillion::Event event = equeue_.front();
-        equeue_.pop();
         
         // player's cmd event need to check player id first
         if ( event.id_ != 0 &&
@@ -184,8 +183,6 @@ void octillion::World::tick()
                 LOG_W(tag_) << "unhandled event type " << event.type_;
         }
     }
-    
-    mutex_.unlock();
 }
 
 void octillion::World::event_to_json( const octillion::Event& event, JsonW& json )
@@ -197,9 +194,11 @@ void octillion::World::event_to_json( const octillion::Event& event, JsonW& json
     {
         JsonW jloc;    
         
-        jloc.add("x", (int)event.player_.lock()->loc_->loc().x());
-        jloc.add("y", (int)event.player_.lock()->loc_->loc().y());
-        jloc.add("z", (int)event.player_.lock()->loc_->loc().z());
+        octillion::CubePosition loc = map_.cubes_[event.player_.lock()->loc_].loc();
+        
+        jloc.add("x", (int)loc.x());
+        jloc.add("y", (int)loc.y());
+        jloc.add("z", (int)loc.z());
         
         json["loc"] = jloc;
     }
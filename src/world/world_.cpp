@@ -6,6 +6,8 @@
 #include <map>
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
+#include <algorithm>
 
 #include "error/ocerror.hpp"
 #include "error/macrolog.hpp"
@@ -14,6 +16,7 @@
 #include "world/creature.hpp"
 #include "world/cube.hpp"
 #include "world/command.hpp"
+#include "world/cmdregistry.hpp"
 #include "world/event.hpp"
 #include "world/mob.hpp"
 
@@ -23,8 +26,6 @@
 
 #include "jsonw/jsonw.hpp"
 
-const std::string octillion::World::tag_ = "World";
-
 octillion::World::World()
 {
 	bool init_succeed = true;
@@ -32,10 +33,27 @@ octillion::World::World()
 	// init random seed for World() rand() usage
 	srand((unsigned int) time(NULL));
 
+	// per-area tick, mob's random path is drawn from seed_ instead of rand()
+	seed_ = (uint_fast32_t) time(NULL);
+	tickpool_.reset(new WorkerPool());
+
     LOG_D(tag_) << "World() start";
 
+	// commands handled by tick()
+	cmdhandlers_.add(Command::VALIDATE_USERNAME, &World::withparms<ValidateUsernameParms, &World::cmdValidateUsername>);
+	cmdhandlers_.add(Command::CONFIRM_USER, &World::withparms<ConfirmUserParms, &World::cmdConfirmUser>);
+	cmdhandlers_.add(Command::LOGIN, &World::withparms<LoginParms, &World::cmdLogin>);
+	cmdhandlers_.add(Command::MOVE_NORMAL, &World::withparms<MoveParms, &World::cmdMove>);
+	cmdhandlers_.add(Command::FREEZE_WORLD, &World::cmdFreezeWorld);
+
+	// read-only commands handled by quickcmd()
+	quickcmdhandlers_.add(Command::GET_SERVER_VERSION, &World::cmdGetServerVersion);
+	quickcmdhandlers_.add(Command::GET_GLOBAL_DATA_STAMP, &World::cmdGetGlobalDataStamp);
+	quickcmdhandlers_.add(Command::GET_GLOBAL_DATA, &World::cmdGetGlobalData);
+	quickcmdhandlers_.add(Command::GET_AREA_DATA, &World::withparms<AreaDataParms, &World::cmdGetAreaData>);
+
     // mark vector
-    std::map<int, std::map<std::string, Cube*>*> area_marks;
+    std::map<int, std::map<std::string, CubeId>*> area_marks;
 
 	// default monster configuration
 	std::map<uint_fast32_t, Mob*> mob_wiki;
@@ -105,6 +123,7 @@ octillion::World::World()
 		}
 
 		area_files_[(int)jid->integer()] = jfile->str();
+		area_stamps_[(int)jid->integer()] = jstamp->str();
 	}
 
     // init area
@@ -133,7 +152,7 @@ octillion::World::World()
         else
         {
             // read area cubes
-            Area* area = new Area(json);
+            Area* area = new Area(json, cubes_);
 
             if (area->valid())
             {
@@ -146,13 +165,13 @@ octillion::World::World()
             LOG_I(tag_) << "World() load area:" << area->id() << " contains cubes:" << area->cubes_.size();
 
             // read area marks
-            std::map<std::string, Cube*>* marks = new std::map<std::string, Cube*>();
+            std::map<std::string, CubeId>* marks = new std::map<std::string, CubeId>();
 
 #ifdef MEMORY_DEBUG
             MemleakRecorder::instance().alloc(__FILE__, __LINE__, marks);
 #endif
 
-            Area::getmark(json, *marks, area->cubes_);
+            Area::getmark(json, *marks, cubes_);
             area_marks[area->id()] = marks;
 
             delete json;
@@ -161,14 +180,8 @@ octillion::World::World()
         fin.close();
     }
 
-    // create cubes short cut to areas_
-    for (const auto& it : areas_)
-    {
-        for (const auto& mapit : it->cubes_)
-        {
-            cubes_[mapit.first] = mapit.second;
-        }
-    }
+    // no more cubes, Cube* and CubeId into cubes_ are fixed from now on
+    cubes_.seal();
 
 	// read global links
 	size_t global_link_count = 0;
@@ -233,6 +246,13 @@ octillion::World::World()
         }
     }
 
+    // resolve the neighbors of all cubes once all links are added, so 
+    // moving and exit checks do not look up cubes_ any more
+    for (auto& cube : cubes_)
+    {
+        cube.findneighbors(cubes_);
+    }
+
 	// read global reborn cube
 	JsonW* jgreborn = jglobal->get(u8"reborn");
 	CubePosition reborn_loc;
@@ -250,16 +270,12 @@ octillion::World::World()
 		}
 		else
 		{
-			auto itcube = cubes_.find(reborn_loc);
-			if (itcube == cubes_.end())
+			global_reborn_cube_ = cubes_.cube(reborn_loc);
+			if (global_reborn_cube_ == NULL)
 			{
 				LOG_E(tag_) << "World(), global reborn location does not exist. JsonW: " << jgreborn->text();
 				init_succeed = false;
 			}
-			else
-			{
-				global_reborn_cube_ = itcube->second;
-			}
 		}
 	}
 
@@ -372,13 +388,13 @@ octillion::World::World()
 					continue;
 				}
 
-				// assign to world_mobs_, cube_mobs_, and area_mobs_
-				std::set<Creature*>* creature_set;
-
+				// assign to world_mobs_, and the mobs of its cube and area
 				world_mobs_[mob->id()] = mob;
-				creature_set = add(mob->cube(), cube_mobs_, mob);
-				mob->cube()->mobs_ = creature_set;
-				add(mob->cube()->area(), area_mobs_, mob);
+				mob->cube()->mobs_.push(mob);
+				if (mob->cube()->owner() != NULL)
+				{
+					mob->cube()->owner()->mobs_.push(mob);
+				}
 			}
 		}
 
@@ -407,6 +423,14 @@ octillion::World::World()
     }
 
     LOG_I(tag_) << "World() creates cube links:" << cubes_.size();
+
+	// serialize the static data replies once, instead of per request
+	if (reloadblobs() != OcError::E_SUCCESS)
+	{
+		LOG_E(tag_) << "World() failed to build global/area data replies";
+		init_succeed = false;
+	}
+
     LOG_D(tag_) << "World() done";
 
 	if (init_succeed)
@@ -419,6 +443,8 @@ octillion::World::~World()
 {
     LOG_D(tag_) << "~World() start";
 
+    dumpstats();
+
     for (auto& it : players_)
     {
         Player* player = static_cast<Player*>(it.second);
@@ -442,6 +468,9 @@ octillion::World::~World()
 		delete player;
     }
 
+	// commands that never reach tick()
+	fetchcmds();
+
 	for (auto& it : cmds_in_)
 	{
 		LOG_D(tag_) << "~World() delete cmds_in_ fd:" << it->fd();
@@ -457,44 +486,10 @@ octillion::World::~World()
 
     for (auto& it : cmds_)
     {
-		Command* cmd = it.second;
-        LOG_D(tag_) << "~World() delete cmd fd:" << cmd->fd();
-        delete cmd;
-    }
-
-    for (auto&it : cube_players_)
-    {
-        LOG_D(tag_) << "~World() delete std::set in cube_players_";
-        if (it.second != NULL)
-        {
-#ifdef MEMORY_DEBUG
-            MemleakRecorder::instance().release(it.second);
-#endif
-            delete it.second;
-        }
-        else
-        {
-            Cube* cube = it.first;
-            CubePosition loc = cube->loc();
-            LOG_W(tag_) << "~World(), warning: found null std:set in cube_players_, loc " 
-                << loc.x() << "," << loc.y() << "," << loc.z();
-        }
-    }
-
-    for (auto it : area_players_)
-    {
-        LOG_D(tag_) << "~World() delete std::set in area_players_";
-        if (it.second != NULL)
-        {
-#ifdef MEMORY_DEBUG
-            MemleakRecorder::instance().release(it.second);
-#endif
-            delete it.second;
-        }
-        else
+        for (auto& cmd : it.second)
         {
-            int area = it.first;
-            LOG_W(tag_) << "~World(), warning: found null std:set in area_players_, area id:" << area;
+            LOG_D(tag_) << "~World() delete cmd fd:" << cmd->fd();
+            delete cmd;
         }
     }
 
@@ -504,22 +499,6 @@ octillion::World::~World()
         delete it;
     }
 
-	for (auto it : cube_mobs_)
-	{
-#ifdef MEMORY_DEBUG
-		MemleakRecorder::instance().release(it.second);
-#endif
-		delete it.second;
-	}
-
-	for (auto it : area_mobs_)
-	{
-#ifdef MEMORY_DEBUG
-		MemleakRecorder::instance().release(it.second);
-#endif
-		delete it.second;
-	}
-
 	for (auto it : world_mobs_)
 	{
 		delete static_cast<Mob*>(it.second);
@@ -577,12 +556,11 @@ std::error_code octillion::World::disconnect(int fd)
     // save player information
     database_.save( player );    
 
-	// delete player from cube_players_, 
-	// which keep track of all the players in one specific cube
+	// delete player from the players of its cube and area
 	CubePosition loc = player->cube()->loc();
-	auto itcube = cubes_.find(loc);
+	Cube* cube = cubes_.cube(loc);
 
-	if (itcube == cubes_.end())
+	if (cube == NULL)
 	{
 		// TODO: put player in any default cube
 		LOG_E(tag_) << "disconnect(), Player " << player->id() << " try to leave from non-exist cube x:" << loc.x() << " y:" << loc.y() << " z:" << loc.z();
@@ -599,14 +577,15 @@ std::error_code octillion::World::disconnect(int fd)
 		LOG_E(tag_) << "disconnect(), world_players_ does not contain player id:" << player->id();
 	}
 
-	Cube* cube = itcube->second;
-	uint_fast32_t areaid = cube->area();
-
-	// remove from area_players_
-	erase(areaid, area_players_, player);
+	// remove from the players of the area and the cube
+	if (cube->owner() != NULL)
+	{
+		cube->owner()->players_.erase(player);
+	}
+	cube->players_.erase(player);
 
-	// remove from cube_players_ and update cube player list
-	cube->players_ = erase(cube, cube_players_, player);
+	// remove from nearby_players_
+	nearby_players_.erase(player);
 
 	// remove the fd mapping from players_
 	players_.erase(it);
@@ -624,11 +603,14 @@ std::error_code octillion::World::tick()
     // if need to freeze
     bool freezeworld = false;
     
-    // jsons that need send back to player
-    std::map<int, JsonW*> jsons;
+    // data that need send back to player
+    std::map<int, Outgoing> outgoing;
+
+    // frozen json of the events, shared by their recipients
+    std::vector<std::shared_ptr<const JsonW>> jevents;
 
     // command's response
-    std::map<int, JsonW*> cmdbacks;
+    std::map<int, std::list<JsonW*>> cmdbacks;
 
     // all events generated in this tick
     std::list<Event*> events;
@@ -641,8 +623,10 @@ std::error_code octillion::World::tick()
         return OcError::E_FATAL;
     }
 	
+	// take all the commands from network threads at once
+	fetchcmds();
+
 	// handle login commands in cmds_in_
-	cmds_lock_.lock();
 	for (auto& it : cmds_in_ )
 	{
 		int fd = it->fd();
@@ -676,152 +660,197 @@ std::error_code octillion::World::tick()
 			event->player_ = player;
 			event->eventcube_ = player->cube();
 			events.push_back(event);
+
+			// player goes out of the view of the nearby players
+			std::vector<Creature*> nearby;
+			nearby_players_.nearby(player->cube()->loc(), nearby);
+			for (auto& other : nearby)
+			{
+				if (other != player)
+				{
+					viewevent(static_cast<Player*>(other), player, Event::TYPE_PLAYER_DISAPPEAR, events);
+				}
+			}
 		}
 	}
 
-	cmds_lock_.unlock();
-
-    // handle normal commands in cmds_
-    cmds_lock_.lock();
-    for (auto& it : cmds_)
+    // handle normal commands in cmds_, at most cmds_per_tick_ for each fd
+    size_t cmds_per_tick = cmds_per_tick_.load();
+    for (auto itfd = cmds_.begin(); itfd != cmds_.end(); )
     {
-		Command* cmd = it.second;
-        int fd = cmd->fd();
-        std::error_code err = OcError::E_SUCCESS;
-        JsonW* cmdback = new JsonW();
-        
-        if (cmd == NULL || !cmd->valid())
+        int fd = itfd->first;
+        std::list<Command*>& cmdlist = itfd->second;
+        size_t count = 0;
+        bool closed = false;
+
+        // fd is leaving, its commands are released with cmds_out_ below
+        if (cmds_out_.find(fd) != cmds_out_.end())
         {
-            cmdback->add(u8"err", Command::E_CMD_BAD_FORMAT);
+            ++itfd;
+            continue;
         }
-        else // valid cmd
+
+        while (!cmdlist.empty() && count < cmds_per_tick && !closed)
         {
-            switch (cmd->cmd())
+            Command* cmd = cmdlist.front();
+            std::error_code err = OcError::E_SUCCESS;
+            JsonW* cmdback = new JsonW();
+
+            cmdlist.pop_front();
+            count++;
+
+            if (cmd == NULL || !cmd->valid())
             {
-			case Command::GET_SERVER_VERSION:
-				err = cmdGetServerVersion(fd, cmd, cmdback);
-				break;
-			case Command::GET_GLOBAL_DATA_STAMP:
-				err = cmdGetGlobalDataStamp(fd, cmd, cmdback);
-				break;
-			case Command::GET_GLOBAL_DATA:
-				err = cmdGetGlobalData(fd, cmd, cmdback);
-				break;
-			case Command::GET_AREA_DATA:
-				err = cmdGetAreaData(fd, cmd, cmdback);
-				break;
-            case Command::VALIDATE_USERNAME:
-                err = cmdValidateUsername(fd, cmd, cmdback);
-                break;
-            case Command::CONFIRM_USER:
-                err = cmdConfirmUser(fd, cmd, cmdback, events);
-                break;
-            case Command::LOGIN:
-                err = cmdLogin(fd, cmd, cmdback, events);
-                break;
-            case Command::LOGOUT:
-                // not possible
-				err = OcError::E_FATAL;
-				LOG_E(tag_) << "tick(), fatal, found LOGOUT in cmds_";
-                break;
-            case Command::MOVE_NORMAL:
-                err = cmdMove(fd, cmd, cmdback, events);
-                break;
-            case Command::FREEZE_WORLD:
-                err = cmdFreezeWorld(fd, cmd, cmdback);
-                if (err == OcError::E_SUCCESS)
+                cmdback->add(u8"err", Command::E_CMD_BAD_FORMAT);
+            }
+            else // valid cmd
+            {
+                auto entry = cmdhandlers_.find(cmd->cmd());
+
+                if (entry == nullptr) // undefined commands
+                {
+                    err = cmdUnknown(fd, cmd, cmdback);
+                }
+                else
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    err = (this->*(entry->handler_))(fd, cmd, cmdback, events);
+                    entry->stats_.record(std::chrono::steady_clock::now() - start, err != OcError::E_SUCCESS);
+                }
+
+                if (cmd->cmd() == Command::FREEZE_WORLD && err == OcError::E_SUCCESS)
                 {
                     freezeworld = true;
                 }
-                break;
-            default: // undefined commands
-                err = cmdUnknown(fd, cmd, cmdback);
-                break;
             }
+
+            if ( err == OcError::E_SUCCESS )
+            {
+                // insert data to output data map, keep the command order
+                cmdbacks[fd].push_back(cmdback);
+            }
+            else if ( err == OcError::E_PROTOCOL_FD_LOGOUT )
+            {
+                // close fd due to logout
+                RawProcessor::closefd(fd);
+                delete cmdback;
+                closed = true;
+                LOG_I(tag_) << "tick, request disconnect due to logout cmd";
+            }
+            else
+            {
+                // fatal error, close fd
+                RawProcessor::closefd(fd);
+                delete cmdback;
+                closed = true;
+                LOG_E(tag_) << "tick, failed to handle incoming command cmd:" << cmd->cmd();
+            }
+
+            delete cmd;
         }
 
-        if ( err == OcError::E_SUCCESS )
+        // fd is closing, the rest of commands are meaningless
+        if (closed)
         {
-            // insert data to output data map
-            cmdbacks[fd] = cmdback;
+            for (auto& cmd : cmdlist)
+            {
+                delete cmd;
+            }
+            cmdlist.clear();
         }
-        else if ( err == OcError::E_PROTOCOL_FD_LOGOUT )
+
+        // remaining commands wait for the next tick
+        if (cmdlist.empty())
         {
-            // close fd due to logout
-            RawProcessor::closefd(fd);
-            delete cmdback;
-            LOG_I(tag_) << "tick, request disconnect due to logout cmd";
+            itfd = cmds_.erase(itfd);
         }
         else
         {
-            // fatal error, close fd
-            RawProcessor::closefd(fd);
-            delete cmdback;
-            LOG_E(tag_) << "tick, failed to handle incoming command cmd:" << cmd->cmd();
+            ++itfd;
         }
     }
 
-    // all cmd were transfer to cmdbacks, clear cmds_
-    for (auto& it : cmds_)
-    {
-        delete it.second;
-    }
-    cmds_.clear();
-    cmds_lock_.unlock();
+	// handle player's tick and monster moving, attacking, dead and reborn,
+	// one area per job, areas only share what handoff() applies later
+	partition();
+	tickpool_->run(partitions_.size(), [this](size_t idx) {
+		TickPartition& partition = partitions_[idx];
 
-	// handle player's tick
-	for (auto itplayer : world_players_)
+		for (auto player : partition.players_)
+		{
+			tick(player, partition);
+		}
+
+		for (auto mob : partition.mobs_)
+		{
+			tick(mob, partition);
+		}
+	});
+
+	// merge in area id order, the result does not depend on which
+	// thread finished first
+	for (auto& partition : partitions_)
 	{
-		Player* player = static_cast<Player*>(itplayer);
-		tick(player, events);
+		handoff(partition, events);
 	}
 
-	// handle monster moving, attacking, dead and reborn
-	for (auto itmob : world_mobs_)
+	// players fighting across areas run after every area is done
+	for (auto player : strays_.players_)
 	{
-		Mob* mob = static_cast<Mob*>(itmob.second);
-		tick(mob, events);
+		tick(player, strays_);
 	}
+	handoff(strays_, events);
 
-    // encapsulate cmdbacks (JsonObjectW) into jsons (JsonTextW)
+	ticks_++;
+
+    // if fd has more than one cmdback, the earlier ones are sent
+    // immediately and the last one is sent together with events
     for ( const auto& itcmdbacks : cmdbacks)
     {
         int fd = itcmdbacks.first;
-        JsonW* cmdback = itcmdbacks.second;
-        JsonW* containerobj = new JsonW();
-        containerobj->add(u8"cmd", cmdback);
-        jsons[fd] = containerobj;
+        for (auto& cmdback : itcmdbacks.second)
+        {
+            if (cmdback != itcmdbacks.second.back())
+            {
+                JsonW* containerobj = new JsonW();
+                containerobj->add(u8"cmd", cmdback);
+                RawProcessor::senddata(fd, *containerobj);
+                LOG_I(tag_) << "write fd:" << fd << " json:" << *containerobj;
+                delete containerobj;
+            }
+            else
+            {
+                outgoing[fd].cmdback_ = cmdback;
+            }
+        }
     }
 
-    // handle events
+    // handle events, each event is converted to json once no matter
+    // how many players receive it
+    std::vector<Creature*> recipients;
     for (auto& event : events)
     {        
+        recipients.clear();
+
         if (event->range_ == Event::RANGE_WORLD) // RANGE_WORLD event
         {
-            addjsons(event, &world_players_, jsons);
+            recipients.assign(world_players_.begin(), world_players_.end());
         }
         else if (event->range_ == Event::RANGE_AREA)
         {
-            auto it = area_players_.find(event->areaid_);
-            if (it == area_players_.end())
+            Area* area = findarea(event->areaid_);
+            if (area != NULL)
             {
-                // no players in this area, ignore it
-                continue;
+                recipients.assign(area->players_.begin(), area->players_.end());
             }
-            // add event to all the players in the same cube
-            addjsons(event, it->second, jsons);
         }
         else if (event->range_ == Event::RANGE_CUBE) // RANGE_CUBE event
         {
-            auto it = cube_players_.find(event->eventcube_);
-            if (it == cube_players_.end())
+            // an event without cube has nobody to receive it
+            if (event->eventcube_ != NULL)
             {
-                // no players in this cube, ignore it
-                continue;
+                recipients.assign(event->eventcube_->players_.begin(), event->eventcube_->players_.end());
             }
-
-            // add event to all the players in the same cube
-            addjsons(event, it->second, jsons);
         }
 		else if (event->range_ == Event::RANGE_PRIVATE)
 		{
@@ -829,13 +858,35 @@ std::error_code octillion::World::tick()
 			auto itplayer = players_.find(fd);
 			if (itplayer != players_.end())
 			{
-				addjsons(event, static_cast<Player*>(itplayer->second), jsons);
+				recipients.push_back(itplayer->second);
 			}
 		}
+        else if (event->range_ == Event::RANGE_NEARBY)
+        {
+            // players within nearbyradius() cubes of the event cube, the
+            // player of the event has its own private event
+            nearby_players_.nearby(event->eventcube_->loc(), recipients);
+            recipients.erase(std::remove(recipients.begin(), recipients.end(), event->player_), recipients.end());
+        }
         else // TODO: handle other range events
         {
             LOG_E(tag_) << "tick(), unexpected event range:" << event->range_;
         } // end of if (event->range_ == Event::RANGE_WORLD) 
+
+        if (recipients.size() == 0)
+        {
+            // nobody receives this event, ignore it
+            continue;
+        }
+
+        JsonW* jevent = event->json();
+        jevents.push_back(JsonW::freeze(*jevent));
+        delete jevent;
+
+        for (auto& it : recipients)
+        {
+            addevent(jevents.back().get(), static_cast<Player*>(it), outgoing);
+        }
     }
 
     // release plyevents
@@ -846,35 +897,60 @@ std::error_code octillion::World::tick()
     }
     events.clear();
 
-    // send data back to players_ and release jsons
-    for ( const auto& it : jsons )
+    // send data back to players_, players that only receive the same
+    // events share one frame
+    std::map<std::vector<const JsonW*>, std::shared_ptr<const std::vector<uint8_t>>> frames;
+    for ( const auto& it : outgoing )
     {
         int fd = it.first;
-        JsonW* jtext = it.second;
-        std::string utf8 = jtext->text();
-        RawProcessor::senddata(fd, (uint8_t*)utf8.data(), utf8.size() );
+        const Outgoing& out = it.second;
+        std::shared_ptr<const std::vector<uint8_t>> frame;
 
-        LOG_I(tag_) << "write fd:" << fd << " json:" << utf8 << std::endl;
+        if (out.cmdback_ == NULL)
+        {
+            std::shared_ptr<const std::vector<uint8_t>>& shared = frames[out.events_];
+            if (shared == nullptr)
+            {
+                shared = makeframe(out);
+            }
+            frame = shared;
+        }
+        else
+        {
+            frame = makeframe(out);
+            delete out.cmdback_;
+        }
+
+        RawProcessor::sendframe(fd, frame);
 
-        delete jtext;
+        LOG_I(tag_) << "write fd:" << fd << " events:" << out.events_.size() << " size:" << frame->size();
     }
 
-	// actual delete without generate event
-	cmds_lock_.lock();
+	// actual delete without generate event, commands still queued for the
+	// fd must not run later on a connection that reuses it
 	for (auto& it : cmds_out_)
 	{
 		int fd = it.first;
 		Command* cmd = it.second;
 		disconnect(fd);
 		delete cmd;
+
+		auto itcmds = cmds_.find(fd);
+		if (itcmds != cmds_.end())
+		{
+			for (auto& queued : itcmds->second)
+			{
+				delete queued;
+			}
+			cmds_.erase(itcmds);
+		}
 	}
 	cmds_out_.clear();
-	cmds_lock_.unlock();
 
     // freeze the world and return
     if (freezeworld)
     {
-        // cannot stop the server inside the cmds_lock_ mutex
+        // stop the server after all the replies are queued
         LOG_I(tag_) << "tick, stopping the coreserver";
 
         // stop server
@@ -887,7 +963,7 @@ std::error_code octillion::World::tick()
     return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdGetServerVersion(int fd, Command *cmd, JsonW* jback)
+std::error_code octillion::World::cmdGetServerVersion(int fd, Command *cmd, JsonW* jback, std::shared_ptr<const std::vector<uint8_t>>& frame)
 {
 	jback->add(u8"cmd", cmd->cmd());
 	jback->add(u8"err", Command::E_CMD_SUCCESS);
@@ -895,73 +971,202 @@ std::error_code octillion::World::cmdGetServerVersion(int fd, Command *cmd, Json
 	return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdGetGlobalDataStamp(int fd, Command *cmd, JsonW* jback)
+std::error_code octillion::World::cmdGetGlobalDataStamp(int fd, Command *cmd, JsonW* jback, std::shared_ptr<const std::vector<uint8_t>>& frame)
 {
+	blobs_lock_.lock();
+	std::string stamp = global_config_stamp_;
+	blobs_lock_.unlock();
+
 	jback->add(u8"cmd", cmd->cmd());
 	jback->add(u8"err", Command::E_CMD_SUCCESS);
-	jback->add(u8"stamp", global_config_stamp_);
+	jback->add(u8"stamp", stamp);
 	return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdGetAreaData(int fd, Command *cmd, JsonW* jback)
+std::error_code octillion::World::cmdGetAreaData(int fd, const AreaDataParms& parms, JsonW* jback, std::shared_ptr<const std::vector<uint8_t>>& frame)
 {
-	int areaid = (int)cmd->uiparms_[0];
-	auto it = area_files_.find(areaid);
-	if (it == area_files_.end())
+	int areaid = (int)parms.areaid_;
+	bool known = false;
+
+	// area_blobs_ has every area of the last reloadblobs(), the ones
+	// failed to load have no frame
+	blobs_lock_.lock();
+	auto itblob = area_blobs_.find(areaid);
+	if (itblob != area_blobs_.end())
+	{
+		known = true;
+		frame = itblob->second.frame_;
+	}
+	blobs_lock_.unlock();
+
+	if (!known)
 	{
-		jback->add(u8"cmd", cmd->cmd());
+		jback->add(u8"cmd", Command::GET_AREA_DATA);
 		jback->add(u8"err", Command::E_CMD_BAD_FORMAT);
 		return OcError::E_SUCCESS;
 	}
-	
-	std::string fname = it->second;
-	std::ifstream fin(fname);
-	if (!fin.good())
+
+	if (frame == nullptr)
 	{
-		LOG_E(tag_) << "cmdGetAreaData(), failed to read area file:" << fname;
-		jback->add(u8"cmd", cmd->cmd());
+		LOG_E(tag_) << "cmdGetAreaData(), no data for area:" << areaid;
+		jback->add(u8"cmd", Command::GET_AREA_DATA);
 		jback->add(u8"err", Command::E_CMD_FILE_IO_ERROR);
 		return OcError::E_SUCCESS;
 	}
 
-	JsonW* jarea = new JsonW(fin);
+	return OcError::E_SUCCESS;
+}
+
+std::error_code octillion::World::cmdGetGlobalData(int fd, Command *cmd, JsonW* jback, std::shared_ptr<const std::vector<uint8_t>>& frame)
+{
+	blobs_lock_.lock();
+	frame = global_blob_.frame_;
+	blobs_lock_.unlock();
 
-	if (jarea->valid() == false)
+	if (frame == nullptr)
 	{
-		LOG_E(tag_) << "cmdGetAreaData(), invalid jaon area file:" << fname;
-		jback->add(u8"cmd", cmd->cmd());
-		jback->add(u8"err", Command::E_CMD_FILE_IO_ERROR);
-		return OcError::E_SUCCESS;
+		LOG_E(tag_) << "cmdGetGlobalData(), no data for " << global_config_file_;
+		return OcError::E_FATAL;
 	}
 
-	jback->add(u8"cmd", cmd->cmd());
+	return OcError::E_SUCCESS;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> octillion::World::makeblob(int cmd, JsonW* jdata)
+{
+	JsonW* jback = new JsonW();
+	JsonW* jcontainer = new JsonW();
+
+	jback->add(u8"cmd", cmd);
 	jback->add(u8"err", Command::E_CMD_SUCCESS);
-	jback->add(u8"data", jarea);
+	jback->add(u8"data", jdata);
+	jcontainer->add(u8"cmd", jback);
 
-	return OcError::E_SUCCESS;
+	std::shared_ptr<const std::vector<uint8_t>> frame = RawProcessor::frame(*jcontainer);
+	delete jcontainer;
+
+	return frame;
 }
 
-std::error_code octillion::World::cmdGetGlobalData(int fd, Command *cmd, JsonW* jback)
+std::error_code octillion::World::reloadblobs()
 {
-	// read global data
+	std::error_code err = OcError::E_SUCCESS;
+	Blob global_blob;
+	std::map<int, Blob> area_blobs;
+	std::map<int, Blob> old_area_blobs;
+	std::string old_global_stamp;
+
+	// a reload in between would be lost by the swap below
+	std::lock_guard<std::mutex> reload(reload_lock_);
+
+	blobs_lock_.lock();
+	old_area_blobs = area_blobs_;
+	old_global_stamp = global_blob_.stamp_;
+	global_blob.frame_ = global_blob_.frame_;
+	blobs_lock_.unlock();
+
 	std::ifstream fin(global_config_file_);
 	if (!fin.good())
 	{
-		LOG_E(tag_) << "cmdGetGlobalData(), Failed to open " << global_config_file_;
+		LOG_E(tag_) << "reloadblobs(), failed to open " << global_config_file_;
 		return OcError::E_FATAL;
 	}
 
 	JsonW* jglobal = new JsonW(fin);
+	fin.close();
 	if (jglobal->valid() == false)
 	{
-		LOG_E(tag_) << "cmdGetGlobalData(), Failed to read " << global_config_file_;
+		LOG_E(tag_) << "reloadblobs(), failed to read " << global_config_file_;
+		delete jglobal;
 		return OcError::E_FATAL;
 	}
 
-	jback->add(u8"cmd", cmd->cmd());
-	jback->add(u8"err", Command::E_CMD_SUCCESS);
-	jback->add(u8"data", jglobal);
-	return OcError::E_SUCCESS;
+	JsonW* jstamp = jglobal->get(u8"stamp");
+	JsonW* jarea_files = jglobal->get(u8"area");
+	if (jstamp == NULL || jstamp->str().length() == 0 || 
+		jarea_files == NULL || jarea_files->type() != JsonW::ARRAY)
+	{
+		LOG_E(tag_) << "reloadblobs(), failed to get stamp or area from " << global_config_file_;
+		delete jglobal;
+		return OcError::E_FATAL;
+	}
+
+	global_blob.stamp_ = jstamp->str();
+
+	for (size_t i = 0; i < jarea_files->size(); i++)
+	{
+		JsonW* jarea_file = jarea_files->get(i);
+		JsonW* jid = jarea_file->get(u8"id");
+		JsonW* jastamp = jarea_file->get(u8"stamp");
+		JsonW* jfile = jarea_file->get(u8"file");
+
+		if (jid == NULL || jastamp == NULL || jfile == NULL ||
+			jid->integer() == 0 || jastamp->str().length() == 0 || jfile->str().length() == 0)
+		{
+			LOG_E(tag_) << "reloadblobs(), bad area file data in " << global_config_file_;
+			err = OcError::E_FATAL;
+			continue;
+		}
+
+		int areaid = (int)jid->integer();
+		Blob blob;
+		blob.stamp_ = jastamp->str();
+
+		// same stamp means same content, reuse the serialized reply
+		auto itold = old_area_blobs.find(areaid);
+		if (itold != old_area_blobs.end() && itold->second.stamp_ == blob.stamp_)
+		{
+			area_blobs[areaid] = itold->second;
+			continue;
+		}
+
+		// an area failed to load is kept without frame and an empty stamp,
+		// so that it is known to cmdGetAreaData() and read again next time
+		area_blobs[areaid] = Blob();
+
+		std::ifstream farea(jfile->str());
+		if (!farea.good())
+		{
+			LOG_E(tag_) << "reloadblobs(), failed to read area file:" << jfile->str();
+			err = OcError::E_FATAL;
+			continue;
+		}
+
+		JsonW* jarea = new JsonW(farea);
+		farea.close();
+		if (jarea->valid() == false)
+		{
+			LOG_E(tag_) << "reloadblobs(), invalid json area file:" << jfile->str();
+			delete jarea;
+			err = OcError::E_FATAL;
+			continue;
+		}
+
+		blob.frame_ = makeblob(Command::GET_AREA_DATA, jarea);
+		area_blobs[areaid] = blob;
+
+		LOG_D(tag_) << "reloadblobs(), area:" << areaid << " stamp:" << blob.stamp_ << " size:" << blob.frame_->size();
+	}
+
+	if (global_blob.frame_ == nullptr || global_blob.stamp_ != old_global_stamp)
+	{
+		// makeblob takes the ownership of jglobal
+		global_blob.frame_ = makeblob(Command::GET_GLOBAL_DATA, jglobal);
+	}
+	else
+	{
+		delete jglobal;
+	}
+
+	// the stamp goes with the blob, a client never gets a stamp that does
+	// not match the data it downloads
+	blobs_lock_.lock();
+	global_blob_ = global_blob;
+	global_config_stamp_ = global_blob.stamp_;
+	area_blobs_.swap(area_blobs);
+	blobs_lock_.unlock();
+
+	return err;
 }
 
 std::error_code octillion::World::cmdUnknown(int fd, Command *cmd, JsonW* jback)
@@ -973,12 +1178,12 @@ std::error_code octillion::World::cmdUnknown(int fd, Command *cmd, JsonW* jback)
     return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdValidateUsername(int fd, Command *cmd, JsonW* jsonobject)
+std::error_code octillion::World::cmdValidateUsername(int fd, const ValidateUsernameParms& parms, JsonW* jsonobject, std::list<Event*>& events)
 {
     std::string username, validname;
     std::error_code err;
 
-    username = cmd->strparms_[0];
+    username = parms.username_;
     
     LOG_D(tag_) << "cmdValidateUsername start, fd:" << fd << " name:" << username;
 
@@ -1046,13 +1251,13 @@ std::error_code octillion::World::cmdValidateUsername(int fd, Command *cmd, Json
     return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdConfirmUser(int fd, Command *cmd, JsonW* jsonobject, std::list<Event*>& events)
+std::error_code octillion::World::cmdConfirmUser(int fd, const ConfirmUserParms& parms, JsonW* jsonobject, std::list<Event*>& events)
 {
     std::error_code err;
-    std::string username = cmd->strparms_[0];
-    std::string password = cmd->strparms_[1];
-    int gender = cmd->uiparms_[0];
-    int cls = cmd->uiparms_[1];
+    std::string username = parms.username_;
+    std::string password = parms.password_;
+    int gender = parms.gender_;
+    int cls = parms.cls_;
     
     LOG_D(tag_) << "cmdConfirmUser start, fd:" << fd << " user:" << username << " gender:" << gender << " cls:" << cls;
     
@@ -1089,23 +1294,23 @@ std::error_code octillion::World::cmdConfirmUser(int fd, Command *cmd, JsonW* js
     }
 
     // set cube
-    auto cit = cubes_.find(loc);
-    if (cit == cubes_.end())
+    Cube* cube = cubes_.cube(loc);
+    if (cube == NULL)
     {
         LOG_E(tag_) << "cmdConfirmUser, position " << loc.str() << " does not exist";
         delete player;
         return OcError::E_WORLD_BAD_CUBE_POSITION;
     }
-    player->cube(cit->second);
+    player->cube(cube);
 
-	auto citreborn = cubes_.find(loc_reborn);
-	if (citreborn == cubes_.end())
+	Cube* cubereborn = cubes_.cube(loc_reborn);
+	if (cubereborn == NULL)
 	{
 		LOG_E(tag_) << "cmdConfirmUser, reborn pos " << loc_reborn.str() << " does not exist";
 		delete player;
 		return OcError::E_WORLD_BAD_CUBE_POSITION;
 	}
-	player->cube_reborn(citreborn->second);
+	player->cube_reborn(cubereborn);
 
     // set feedback
     jsonobject->add(u8"cmd", Command::CONFIRM_USER);
@@ -1121,11 +1326,11 @@ std::error_code octillion::World::cmdConfirmUser(int fd, Command *cmd, JsonW* js
     return err;
 }
 
-std::error_code octillion::World::cmdLogin(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events)
+std::error_code octillion::World::cmdLogin(int fd, const LoginParms& parms, JsonW* jsonobject, std::list<Event*>& events)
 {
     std::error_code err;
-    std::string username = cmd->strparms_[0];
-    std::string password = cmd->strparms_[1];
+    std::string username = parms.username_;
+    std::string password = parms.password_;
     
     LOG_D(tag_) << "cmdLogin start, fd:" << fd << " user:" << username;
 
@@ -1177,8 +1382,8 @@ std::error_code octillion::World::cmdLogin(int fd, Command* cmd, JsonW* jsonobje
 
 
 	// validate reborn cube, if bad, set to global reborn cube
-	auto citreborn = cubes_.find(loc_reborn);
-	if (citreborn == cubes_.end())
+	Cube* cubereborn = cubes_.cube(loc_reborn);
+	if (cubereborn == NULL)
 	{
 		LOG_W(tag_) << "cmdLogin, user:" << player->username() << " " << player->id()
 			<< " reborn position " << loc.str() << " does not exist";
@@ -1186,12 +1391,12 @@ std::error_code octillion::World::cmdLogin(int fd, Command* cmd, JsonW* jsonobje
 	}
 	else
 	{
-		player->cube_reborn(citreborn->second);
+		player->cube_reborn(cubereborn);
 	}
 	
 	// validate player locates cube, if bad, set to reborn cube
-    auto cit = cubes_.find(loc);
-    if (cit == cubes_.end())
+    Cube* cube = cubes_.cube(loc);
+    if (cube == NULL)
     {
         LOG_W(tag_) << "cmdLogin, user:" << player->username() << " " << player->id() 
 			<< " login position " << loc.str() << " does not exist";
@@ -1199,7 +1404,7 @@ std::error_code octillion::World::cmdLogin(int fd, Command* cmd, JsonW* jsonobje
     }
 	else
 	{
-		player->cube(cit->second);
+		player->cube(cube);
 	}
 
     // mapping player with fd
@@ -1218,7 +1423,7 @@ std::error_code octillion::World::cmdLogin(int fd, Command* cmd, JsonW* jsonobje
     return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdMove(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events)
+std::error_code octillion::World::cmdMove(int fd, const MoveParms& parms, JsonW* jsonobject, std::list<Event*>& events)
 {
     LOG_D(tag_) << "cmdMove start, fd:" << fd;
 
@@ -1237,13 +1442,13 @@ std::error_code octillion::World::cmdMove(int fd, Command* cmd, JsonW* jsonobjec
 
     // check player's location and the target location
     Player* player = static_cast<Player*>(pit->second);
-    CubePosition targetloc(player->cube()->loc(), cmd->uiparms_[0]);
+    Cube* dest = player->cube()->neighbor(parms.dir_);
 
     // check if cube exist
-    auto cit = cubes_.find(targetloc);
-    if (cit == cubes_.end())
+    if (dest == NULL)
     {
-        LOG_E(tag_) << "cmdMove, player moves to invalid position " << targetloc.str();
+        LOG_E(tag_) << "cmdMove, player moves to invalid position " 
+            << CubePosition(player->cube()->loc(), parms.dir_).str();
         return OcError::E_WORLD_BAD_CUBE_POSITION;
     }
 
@@ -1251,34 +1456,34 @@ std::error_code octillion::World::cmdMove(int fd, Command* cmd, JsonW* jsonobjec
 
     // create cube event
     Event* event = new Event();
-    event->range_ = Event::RANGE_CUBE;
+    event->range_ = Event::RANGE_NEARBY;
     event->type_ = Event::TYPE_PLAYER_ARRIVE;
     event->player_ = player;
-    event->eventcube_ = cit->second;
+    event->eventcube_ = dest;
     event->subcube_ = player->cube();
-    event->direction_ = Cube::opposite_dir(cmd->uiparms_[0]);
+    event->direction_ = Cube::opposite_dir(parms.dir_);
     events.push_back(event);
 	
 	event = new Event();
 	event->range_ = Event::RANGE_CUBE;
 	event->type_ = Event::TYPE_PLAYER_ARRIVE_PRIVATE;
 	event->player_ = player;
-	event->eventcube_ = cit->second;
+	event->eventcube_ = dest;
 	event->subcube_ = player->cube();
-	event->direction_ = Cube::opposite_dir(cmd->uiparms_[0]);
+	event->direction_ = Cube::opposite_dir(parms.dir_);
 	events.push_back(event);
 
     event = new Event();
-    event->range_ = Event::RANGE_CUBE;
+    event->range_ = Event::RANGE_NEARBY;
     event->type_ = Event::TYPE_PLAYER_LEAVE;
 	event->player_ = player;
     event->eventcube_ = player->cube();
-    event->subcube_ = cit->second;
-    event->direction_ = cmd->uiparms_[0];
+    event->subcube_ = dest;
+    event->direction_ = parms.dir_;
     events.push_back(event);
 
     // move player
-    move(player, cit->second);
+    move(player, dest, events);
 	
     // generate cmdback
     jsonobject->add(u8"cmd", Command::MOVE_NORMAL);
@@ -1288,7 +1493,7 @@ std::error_code octillion::World::cmdMove(int fd, Command* cmd, JsonW* jsonobjec
     return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::cmdFreezeWorld(int fd, Command* cmd, JsonW* jsonobject)
+std::error_code octillion::World::cmdFreezeWorld(int fd, Command* cmd, JsonW* jsonobject, std::list<Event*>& events)
 {
     LOG_D(tag_) << "cmdFreezeWorld start, fd:" << fd;
 
@@ -1308,44 +1513,187 @@ void octillion::World::addcmd(Command * cmd)
 		return;
 	}
 
-	if (cmd->cmd() == Command::CONNECT)
+	if (quickcmd(cmd))
 	{
-		cmds_lock_.lock();
-		cmds_in_.insert(cmd);
-		cmds_lock_.unlock();
+		// answered already, no need to wait for tick()
+		delete cmd;
+		return;
 	}
-	else if (cmd->cmd() == Command::DISCONNECT || cmd->cmd() == Command::LOGOUT)
+
+	// a client sending faster than ticks would grow incoming_ without
+	// bound, count its standard cmds until fetchcmds() takes them
+	int fd = cmd->fd();
+	if (fd >= 0 && fd < MAX_COUNTED_FD && cmd->cmd() != Command::CONNECT &&
+		cmd->cmd() != Command::DISCONNECT && cmd->cmd() != Command::LOGOUT)
 	{
-		cmds_lock_.lock();
+		if (queued_[fd].fetch_add(1) >= MAX_QUEUED_CMDS)
+		{
+			queued_[fd].fetch_sub(1);
+			LOG_W(tag_) << "addcmd() too many cmds for fd: " << fd << " drop cmd:" << cmd->cmd();
+			rejectcmd(cmd);
+			return;
+		}
+	}
+
+	// lock-free, network threads never wait for a running tick()
+	incoming_.push(cmd);
+}
 
+void octillion::World::rejectcmd(Command* cmd)
+{
+	// tell the client the cmd was dropped instead of silently ignore it
+	JsonW* cmdback = new JsonW();
+	JsonW* containerobj = new JsonW();
+	cmdback->add(u8"cmd", cmd->cmd());
+	cmdback->add(u8"err", Command::E_CMD_TOO_MANY_COMMANDS);
+	containerobj->add(u8"cmd", cmdback);
+	RawProcessor::senddata(cmd->fd(), *containerobj);
+	delete containerobj;
+	delete cmd;
+}
+
+void octillion::World::fetchcmds()
+{
+	std::vector<Command*> cmds;
+
+	incoming_.drain(cmds);
+
+	for (auto& cmd : cmds)
+	{
 		int fd = cmd->fd();
-		auto it = cmds_out_.find(fd);
-		if (it != cmds_out_.end())
+
+		if (cmd->cmd() == Command::CONNECT)
 		{
-			LOG_D(tag_) << "addcmd() detect multiple disconnect and logout cmd";
+			cmds_in_.insert(cmd);
 		}
-		else
+		else if (cmd->cmd() == Command::DISCONNECT || cmd->cmd() == Command::LOGOUT)
 		{
-			cmds_out_[fd] = cmd;
+			auto it = cmds_out_.find(fd);
+			if (it != cmds_out_.end())
+			{
+				LOG_D(tag_) << "fetchcmds() detect multiple disconnect and logout cmd";
+				delete cmd;
+			}
+			else
+			{
+				cmds_out_[fd] = cmd;
+			}
 		}
-		
-		cmds_lock_.unlock();
-	}
-	else
-	{
-		cmds_lock_.lock();
-		auto it = cmds_.find(cmd->fd());
-		if (it == cmds_.end())
+		else
 		{
-			cmds_[cmd->fd()] = cmd;
+			// out of incoming_, see addcmd()
+			if (fd >= 0 && fd < MAX_COUNTED_FD)
+			{
+				queued_[fd].fetch_sub(1);
+			}
+
+			std::list<Command*>& cmdlist = cmds_[fd];
+			if (cmdlist.size() < MAX_QUEUED_CMDS)
+			{
+				cmdlist.push_back(cmd);
+				continue;
+			}
+
+			LOG_W(tag_) << "fetchcmds() too many cmds for fd: " << fd << " drop cmd:" << cmd->cmd();
+			rejectcmd(cmd);
 		}
-		else
+	}
+}
+
+void octillion::World::dumpstats()
+{
+	auto dump = [this](const char* type, const CmdStats& stats, const CmdDesc* desc) {
+		if (stats.invocations() > 0)
 		{
-			LOG_W(tag_) << "addcmd() multiple cmds for same fd: " << cmd->fd() << " drop it";
-			delete cmd;
+			LOG_I(tag_) << type << " " << desc->name_ << " " << stats.str();
 		}
-		cmds_lock_.unlock();
+	};
+
+	cmdhandlers_.foreach([&dump](const CmdRegistry<CmdHandler>::Entry& entry) {
+		dump("cmd", entry.stats_, entry.desc_);
+	});
+
+	quickcmdhandlers_.foreach([&dump](const CmdRegistry<QuickCmdHandler>::Entry& entry) {
+		dump("quickcmd", entry.stats_, entry.desc_);
+	});
+}
+
+void octillion::World::cmdspertick(size_t count)
+{
+	if (count == 0)
+	{
+		LOG_W(tag_) << "cmdspertick() count cannot be 0, set to 1";
+		count = 1;
 	}
+
+	cmds_per_tick_.store(count);
+}
+
+void octillion::World::nearbyradius(uint_fast32_t radius)
+{
+	nearby_players_.radius(radius);
+}
+
+void octillion::World::tickthreads(size_t count)
+{
+	tickpool_.reset(new WorkerPool(count));
+	LOG_I(tag_) << "tickthreads(), tick areas with " << tickpool_->size() << " thread(s)";
+}
+
+bool octillion::World::quickcmd(Command* cmd)
+{
+	int fd = cmd->fd();
+	std::error_code err = OcError::E_SUCCESS;
+	std::shared_ptr<const std::vector<uint8_t>> frame;
+
+	if (!cmd->valid())
+	{
+		return false;
+	}
+
+	// only the commands that read immutable data (version, stamp, and the
+	// precomputed data frames) are registered here, they never touch players_
+	auto entry = quickcmdhandlers_.find(cmd->cmd());
+	if (entry == nullptr)
+	{
+		return false;
+	}
+
+	if (!initialized_)
+	{
+		LOG_E(tag_) << "quickcmd(), World init failed, close fd:" << fd;
+		RawProcessor::closefd(fd);
+		return true;
+	}
+
+	JsonW* cmdback = new JsonW();
+
+	auto start = std::chrono::steady_clock::now();
+	err = (this->*(entry->handler_))(fd, cmd, cmdback, frame);
+	entry->stats_.record(std::chrono::steady_clock::now() - start, err != OcError::E_SUCCESS);
+
+	if (err != OcError::E_SUCCESS)
+	{
+		RawProcessor::closefd(fd);
+		delete cmdback;
+		LOG_E(tag_) << "quickcmd(), failed to handle incoming command cmd:" << cmd->cmd();
+	}
+	else if (frame != nullptr)
+	{
+		RawProcessor::sendframe(fd, frame);
+		delete cmdback;
+		LOG_I(tag_) << "quickcmd(), write fd:" << fd << " frame size:" << frame->size();
+	}
+	else
+	{
+		JsonW* containerobj = new JsonW();
+		containerobj->add(u8"cmd", cmdback);
+		RawProcessor::senddata(fd, *containerobj);
+		LOG_I(tag_) << "quickcmd(), write fd:" << fd << " json:" << *containerobj;
+		delete containerobj;
+	}
+
+	return true;
 }
 
 std::error_code octillion::World::enter(Player* player, std::list<Event*>& events)
@@ -1355,11 +1703,28 @@ std::error_code octillion::World::enter(Player* player, std::list<Event*>& event
     // put player in the world_players_
     world_players_.insert(player);
 
-	// put player in the area_players_
-	add(player->cube()->area(), area_players_, player);
+	// put player in the players of its area and cube
+	if (player->cube()->owner() != NULL)
+	{
+		player->cube()->owner()->players_.push(player);
+	}
+	player->cube()->players_.push(player);
+
+	// put player in the nearby_players_, it and the nearby players come
+	// into the view of each other
+	nearby_players_.insert(player, player->cube()->loc());
 
-	// put player in the cube_players_, and assign the shortcut to cube
-	player->cube()->players_ = add(player->cube(), cube_players_, player);
+	std::vector<Creature*> nearby;
+	nearby_players_.nearby(player->cube()->loc(), nearby);
+	for (auto& it : nearby)
+	{
+		Player* other = static_cast<Player*>(it);
+		if (other != player)
+		{
+			viewevent(player, other, Event::TYPE_PLAYER_APPEAR, events);
+			viewevent(other, player, Event::TYPE_PLAYER_APPEAR, events);
+		}
+	}
 
     // create event
     Event* event = new Event();
@@ -1381,75 +1746,117 @@ std::error_code octillion::World::enter(Player* player, std::list<Event*>& event
     return OcError::E_SUCCESS;
 }
 
-void octillion::World::addjsons(Event* event, std::set<Creature*>* players, std::map<int, JsonW*>& jsons)
+void octillion::World::addevent(const JsonW* jevent, Player* player, std::map<int, Outgoing>& outgoing)
 {
-    for (auto& player : *players)
-    {
-		addjsons(event, static_cast<Player*>(player), jsons);
-    } // for (auto& player : *players)
-} // void octillion::World::addjsons
+	outgoing[player->fd()].events_.push_back(jevent);
+} // void octillion::World::addevent
 
-void octillion::World::addjsons(Event* event, Player* player, std::map<int, JsonW*>& jsons)
+octillion::Area* octillion::World::findarea(int areaid)
 {
-	JsonW* jarray; // events array
-	int fd = player->fd();
-
-	// get "events" array in jsons for the player
-	// case 1: fd does not exist in jsons
-	// case 2: fd exist in jsons, but there is no "events" name-pair in main object
-	// case 3: fd exist and there is "events" name-pair in main object
-	auto fdjson = jsons.find(fd);
-	if (fdjson == jsons.end())
-	{
-		// case 1: fd does not exist in jsons
-		JsonW* jobject = new JsonW();
-		jarray = new JsonW();
-		jobject->add("events", jarray);
-		jsons[fd] = jobject;
+	for (auto area : areas_)
+	{
+		if (area->id() == areaid)
+		{
+			return area;
+		}
 	}
-	else
+
+	return NULL;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> octillion::World::makeframe(const Outgoing& out)
+{
+	std::shared_ptr<std::vector<uint8_t>> buffer = 
+		std::make_shared<std::vector<uint8_t>>((size_t)RawProcessorClient::kRawProcessorHeaderSize);
+	JsonWriterW<std::vector<uint8_t>> writer(*buffer);
+
+	// same text as the JsonW object {"cmd":...,"events":[...]}
+	writer.begin_object();
+
+	if (out.cmdback_ != NULL)
 	{
-		JsonW* jobject = fdjson->second;
-		jarray = jobject->get("events");
+		writer.key(u8"cmd");
+		writer.value(*out.cmdback_);
+	}
 
-		if (jarray == NULL)
+	if (out.events_.size() > 0)
+	{
+		writer.key(u8"events");
+		writer.begin_array();
+		for (auto jevent : out.events_)
 		{
-			jarray = new JsonW();
-			jobject->add("events", jarray);
+			writer.value(*jevent);
 		}
-	} // end of get jarray
+		writer.end();
+	}
 
-	jarray->add(event->json());
-} // void octillion::World::addjsons
+	writer.end();
+
+	return RawProcessor::frame(buffer);
+}
 
-// help function, move player location and change cube_players_, and area_players_
-// function WILL NOT check the newloc's existence
-void octillion::World::move(Player* player, Cube* cube_to)
+// help function, move player location and change the players of the cubes
+// and areas and nearby_players_, function WILL NOT check the newloc's existence
+void octillion::World::move(Player* player, Cube* cube_to, std::list<Event*>& events)
 {
     Cube* cube_from = player->cube();
 
-    int area_from = cube_from->area();
-    int area_to = cube_to->area();
+	// move player between the areas' players, a cube may have no area
+	if (cube_from->owner() != cube_to->owner())
+	{
+		if (cube_from->owner() != NULL && cube_to->owner() != NULL)
+		{
+			cube_from->owner()->players_.move(player, cube_to->owner()->players_);
+		}
+		else if (cube_from->owner() != NULL)
+		{
+			cube_from->owner()->players_.erase(player);
+		}
+		else
+		{
+			cube_to->owner()->players_.push(player);
+		}
+	}
+
+	// move player between the cubes' players
+	cube_from->players_.move(player, cube_to->players_);
+
+	// move player in nearby_players_, the players that come into or go
+	// out of its view and the player itself are told by private events
+	std::vector<Creature*> entered, left;
+	nearby_players_.move(player, cube_to->loc(), entered, left);
 
-	// move player in area_players_
-	if (area_from != area_to)
+	for (auto& it : entered)
 	{
-		erase(area_from, area_players_, player);
-		add(area_to, area_players_, player);
+		viewevent(player, static_cast<Player*>(it), Event::TYPE_PLAYER_APPEAR, events);
+		viewevent(static_cast<Player*>(it), player, Event::TYPE_PLAYER_APPEAR, events);
 	}
 
-	// move player in cube_players_
-	erase(cube_from, cube_players_, player);
-	cube_to->players_ = add(cube_to, cube_players_, player);
+	for (auto& it : left)
+	{
+		viewevent(player, static_cast<Player*>(it), Event::TYPE_PLAYER_DISAPPEAR, events);
+		viewevent(static_cast<Player*>(it), player, Event::TYPE_PLAYER_DISAPPEAR, events);
+	}
 
 	// move player
     player->cube(cube_to);
 }
 
+void octillion::World::viewevent(Player* player, Player* other, int type, std::list<Event*>& events)
+{
+	Event* event = new Event();
+	event->range_ = Event::RANGE_PRIVATE;
+	event->type_ = type;
+	event->player_ = player;
+	event->other_ = other;
+	event->eventcube_ = player->cube();
+	events.push_back(event);
+}
+
 octillion::Cube* octillion::World::readloc(
     JsonW* json,
-    const std::map<int, std::map<std::string, Cube*>*>& area_marks,
-    const std::map<CubePosition, Cube*>& cubes
+    const std::map<int, std::map<std::string, CubeId>*>& area_marks,
+    CubeStore& cubes
 )
 {
     int areaid;
@@ -1466,7 +1873,7 @@ octillion::Cube* octillion::World::readloc(
 
     if (jloc->type() == JsonW::STRING && areaid > 0 )
     {
-        std::map<std::string, Cube*>* markmap;
+        std::map<std::string, CubeId>* markmap;
         auto itmark = area_marks.find(areaid);
         if (itmark == area_marks.end())
         {
@@ -1482,7 +1889,7 @@ octillion::Cube* octillion::World::readloc(
             return NULL;
         }
 
-        return it->second;
+        return cubes.at(it->second);
     }
     else if (jloc->type() == JsonW::ARRAY)
     {
@@ -1507,13 +1914,12 @@ octillion::Cube* octillion::World::readloc(
             return NULL;
         }
 
-        auto itcube = cubes.find(cubepos);
-        if (itcube == cubes.end())
+        Cube* cube = cubes.cube(cubepos);
+        if (cube == NULL)
         {
             LOG_E(tag_) << "cubepos " << cubepos.str() << " not in cubes";
-            return NULL;
         }
-        return itcube->second;
+        return cube;
     }
     else
     {
@@ -1532,7 +1938,7 @@ void octillion::World::reborn(Player* player, std::list<Event*>& events)
 	events.push_back(event);
 
 	// move player to reborn cube
-	move(player, player->cube_reborn());
+	move(player, player->cube_reborn(), events);
 
 	// reborn player
 	player->status(Player::STATUS_IDLE);
@@ -1555,8 +1961,127 @@ void octillion::World::reborn(Player* player, std::list<Event*>& events)
 	events.push_back(event);
 }
 
-std::error_code octillion::World::tick(Player* player, std::list<Event*>& events)
+void octillion::World::partition()
+{
+	std::map<uint_fast32_t, size_t> areas;
+
+	for (auto itplayer : world_players_)
+	{
+		areas[itplayer->cube()->area()] = 0;
+	}
+
+	for (auto itmob : world_mobs_)
+	{
+		areas[itmob.second->cube()->area()] = 0;
+	}
+
+	// one partition per area in area id order, reuse the old ones
+	partitions_.resize(areas.size());
+
+	size_t idx = 0;
+	for (auto& itarea : areas)
+	{
+		TickPartition& partition = partitions_[idx];
+		std::seed_seq seq{ seed_, (uint_fast32_t)ticks_, itarea.first };
+
+		partition.areaid_ = itarea.first;
+		partition.players_.clear();
+		partition.mobs_.clear();
+		partition.rng_.seed(seq);
+		itarea.second = idx++;
+	}
+
+	strays_.players_.clear();
+
+	for (auto itplayer : world_players_)
+	{
+		Player* player = static_cast<Player*>(itplayer);
+		Creature* target = player->target();
+
+		// player hits a mob of another area, see tick(Player*)
+		if (player->status() == Player::STATUS_COMBAT && target != NULL &&
+			target->cube()->area() != player->cube()->area())
+		{
+			strays_.players_.push_back(player);
+			continue;
+		}
+
+		partitions_[areas[player->cube()->area()]].players_.push_back(player);
+	}
+
+	// world_players_ is ordered by address, tick players by id instead
+	auto byid = [](Player* lhs, Player* rhs) { return lhs->id() < rhs->id(); };
+	for (auto& partition : partitions_)
+	{
+		std::sort(partition.players_.begin(), partition.players_.end(), byid);
+	}
+	std::sort(strays_.players_.begin(), strays_.players_.end(), byid);
+
+	for (auto itmob : world_mobs_)
+	{
+		Mob* mob = static_cast<Mob*>(itmob.second);
+		partitions_[areas[mob->cube()->area()]].mobs_.push_back(mob);
+	}
+}
+
+void octillion::World::handoff(TickPartition& partition, std::list<Event*>& events)
 {
+	events.splice(events.end(), partition.events_);
+
+	for (auto& it : partition.combats_)
+	{
+		combat_mobs_.insert(it.first);
+		combat_players_.insert(it.second);
+	}
+
+	for (auto& it : partition.kills_)
+	{
+		// erase the player and the mob from combat sets
+		combat_players_.erase(it.second);
+		combat_mobs_.erase(it.first);
+
+		// send player back to reset point
+		reborn(it.second, events);
+	}
+
+	for (auto& it : partition.moves_)
+	{
+		Mob* mob = it.first;
+		Cube* dest = it.second;
+
+		// change cube's mob list
+		mob->cube()->mobs_.move(mob, dest->mobs_);
+
+		// change area's mob list if needed
+		if (mob->cube()->owner() != dest->owner())
+		{
+			if (mob->cube()->owner() != NULL && dest->owner() != NULL)
+			{
+				mob->cube()->owner()->mobs_.move(mob, dest->owner()->mobs_);
+			}
+			else if (mob->cube()->owner() != NULL)
+			{
+				mob->cube()->owner()->mobs_.erase(mob);
+			}
+			else
+			{
+				dest->owner()->mobs_.push(mob);
+			}
+		}
+
+		// move mob
+		mob->cube(dest);
+	}
+
+	partition.combats_.clear();
+	partition.kills_.clear();
+	partition.moves_.clear();
+}
+
+std::error_code octillion::World::tick(Player* player, TickPartition& partition)
+{
+	std::list<Event*>& events = partition.events_;
+
 	// handle combat
 	if (player->status() == Player::STATUS_COMBAT)
 	{
@@ -1603,15 +2128,12 @@ std::error_code octillion::World::tick(Player* player, std::list<Event*>& events
 	return OcError::E_SUCCESS;
 }
 
-std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
+std::error_code octillion::World::tick(Mob* mob, TickPartition& partition)
 {
+	std::list<Event*>& events = partition.events_;
+
 	// get the player list in the same cube
-	std::set<Creature*>* players = NULL;
-	auto itplayers = cube_players_.find(mob->cube());
-	if (itplayers != cube_players_.end())
-	{
-		players = itplayers->second;
-	}
+	const OccupantList<Creature, CubeOccupant>& players = mob->cube()->players_;
 
 	// check reborn count
 	if (mob->status() == Mob::STATUS_GHOST)
@@ -1628,6 +2150,7 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 			Event* event = new Event();
 			event->type_ = Event::TYPE_MOB_REBORN;
 			event->range_ = Event::RANGE_CUBE;
+			event->eventcube_ = mob->cube();
 			event->mob_ = mob;
 			events.push_back(event);
 		}
@@ -1640,12 +2163,17 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 	}
 
 	// get the highest lv and lowerest lv in the same cube
-	if (mob->status() == Mob::STATUS_IDLE && players != NULL && players->size() > 0)
+	if (mob->status() == Mob::STATUS_IDLE && players.size() > 0)
 	{
 		Player *plstrong = NULL, *plweak = NULL;
-		for (auto it : *players)
+		for (auto it : players)
 		{
-			if (plstrong == NULL)
+			if (it->hp() <= 0)
+			{
+				// killed in this tick, reborn in handoff()
+				continue;
+			}
+			else if (plstrong == NULL)
 			{
 				plstrong = static_cast<Player*>(it);
 				plweak = static_cast<Player*>(it);
@@ -1664,7 +2192,8 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 			}
 		}
 
-		switch (mob->combat())
+		// nobody to fight if all of them were killed in this tick
+		switch (plstrong == NULL ? Mob::COMBAT_DUMMY : mob->combat())
 		{
 		case Mob::COMBAT_DUMMY: // never attack player
 		case Mob::COMBAT_PEACE: // never automatically attack player 
@@ -1684,8 +2213,7 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 				mob->status( Mob::STATUS_COMBAT );
 				plweak->target(static_cast<Creature*>(mob));
 				plweak->status(Player::STATUS_COMBAT);
-				combat_mobs_.insert(mob);
-				combat_players_.insert(plweak);
+				partition.combats_.push_back(std::make_pair(mob, plweak));
 			}
 			break;
 		case Mob::COMBAT_CRAZY: // fight when player appears
@@ -1694,8 +2222,7 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 			mob->status(Mob::STATUS_COMBAT);
 			plweak->target(static_cast<Creature*>(mob));
 			plweak->status(Player::STATUS_COMBAT);
-			combat_mobs_.insert(mob);
-			combat_players_.insert(plweak);
+			partition.combats_.push_back(std::make_pair(mob, plweak));
 
 			break;
 		}
@@ -1716,6 +2243,12 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 			LOG_E(tag_) << "mob " << mob->id() << " target is in other cube";
 			mob->status(Mob::STATUS_IDLE);
 		}
+		else if (std::find_if(partition.kills_.begin(), partition.kills_.end(),
+			[target](const std::pair<Mob*, Player*>& kill) { return kill.second == target; }) != partition.kills_.end())
+		{
+			// killed by another mob in this tick, reborn in handoff()
+			mob->status(Mob::STATUS_IDLE);
+		}
 		else
 		{
 			int_fast32_t plhp = target->hp();
@@ -1741,15 +2274,10 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 				event->i32parm_ = mobattack;
 				events.push_back(event);
 
-				// erase the player from combat_players
-				combat_players_.erase(target);
-
-				// erase the mob from combat_players
-				combat_mobs_.erase(mob);
+				// leave combat and send player back to reset point
+				// in handoff(), the reborn cube may be in other area
+				partition.kills_.push_back(std::make_pair(mob, target));
 				mob->status(Mob::STATUS_IDLE);
-
-				// send player back to reset point
-				reborn( target, events);
 			}
 			else
 			{
@@ -1783,10 +2311,10 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 			{
 				// move randomly, move to the cube that allows mob
 				// TODO: how about other type?
-				int dir = mob->cube()->random_exit(Cube::MOB_CUBE);
-				dest = mob->cube()->find(cubes_, dir);
+				int dir = mob->cube()->random_exit(Cube::MOB_CUBE, partition.rng_);
+				dest = mob->cube()->neighbor(dir);
 				mob->next_move_count(
-					(rand() % (max_move_tick - min_move_tick + 1))
+					(partition.rng_() % (max_move_tick - min_move_tick + 1))
 					+ min_move_tick);			
 			}
 			else
@@ -1800,7 +2328,7 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 			{
 				dest = mob->next_path();
 				mob->next_move_count(
-					(rand() % (max_move_tick - min_move_tick + 1))
+					(partition.rng_() % (max_move_tick - min_move_tick + 1))
 					+ min_move_tick);
 			}
 			else
@@ -1836,19 +2364,9 @@ std::error_code octillion::World::tick(Mob* mob, std::list<Event*>& events)
 				events.push_back(event);
 			}
 
-			// change cube's mob list
-			mob->cube()->mobs_ = erase(mob->cube(), cube_mobs_, mob);
-			dest->mobs_ = add(dest, cube_mobs_, mob);
-
-			// change area's mob list if needed
-			if (mob->cube()->area() != dest->area())
-			{
-				erase(mob->cube()->area(), area_mobs_, mob);
-				add(dest->area(), area_mobs_, mob);
-			}
-
-			// move mob
-			mob->cube(dest);
+			// change cube's and area's mob list and move mob in handoff(),
+			// the destination may be a cube of other area
+			partition.moves_.push_back(std::make_pair(mob, dest));
 		}
 	}
 
@@ -2,6 +2,7 @@
 #include <memory>
 #include <iostream>
 #include <fstream>
+#include <chrono>
 
 #include "error/ocerror.hpp"
 #include "error/macrolog.hpp"
@@ -22,12 +23,11 @@ octillion::WorldMap::~WorldMap()
 {
 }
 
-std::shared_ptr<octillion::Cube> octillion::WorldMap::readloc(
+octillion::CubeId octillion::WorldMap::readloc(
         std::shared_ptr<JsonW> json,
-        std::map<std::string, std::shared_ptr<octillion::Cube>>& marks,
-        std::map<octillion::CubePosition, std::shared_ptr<octillion::Cube>> cubes )
+        std::map<std::string, octillion::CubeId>& marks,
+        octillion::CubeStore& cubes )
 {
-    std::string tag_ = "WorldMap"; // fake tag_ for static function
     int areaid;
     std::shared_ptr<JsonW> jarea = json->get(u8"area");
     std::shared_ptr<JsonW> jloc = json->get(u8"cube");    
@@ -47,7 +47,7 @@ std::shared_ptr<octillion::Cube> octillion::WorldMap::readloc(
         if (it == marks.end())
         {
             LOG_E(tag_) << "readloc() mark:" << mark << " is not in marks";
-            return nullptr;
+            return octillion::CubeStore::NO_CUBE;
         }
 
         return it->second;
@@ -72,21 +72,20 @@ std::shared_ptr<octillion::Cube> octillion::WorldMap::readloc(
         if (ret == false)
         {
             LOG_E(tag_) << "readloc(), Area::readloc() failed";
-            return nullptr;
+            return octillion::CubeStore::NO_CUBE;
         }
 
-        auto itcube = cubes.find(cubepos);
-        if (itcube == cubes.end())
+        octillion::CubeId cubeid = cubes.find(cubepos);
+        if (cubeid == octillion::CubeStore::NO_CUBE)
         {
             LOG_E(tag_) << "cubepos " << cubepos.str() << " not in cubes";
-            return NULL;
         }
-        return itcube->second;
+        return cubeid;
     }
     else
     {
         LOG_E(tag_) << "readloc() bad json type";
-        return NULL;
+        return octillion::CubeStore::NO_CUBE;
     }
 }
 
@@ -99,10 +98,12 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
     std::map<int, std::string> area_files;
     
     // mark vector
-    std::map<std::string, std::shared_ptr<Cube>> marks;
+    std::map<std::string, CubeId> marks;
     
     octillion::CubePosition pos;
     
+    auto start = std::chrono::steady_clock::now();
+    
     // read global data
 	std::ifstream fin(global_config_filepath);
 	if (!fin.good())
@@ -173,16 +174,12 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
 			LOG_E(tag_) << "Failed to open area file:" << (*it).second;
 			return false;
         }
-        
-        std::shared_ptr<JsonW> json = std::make_shared<JsonW>(fin);
-        if (json->valid() == false)
-        {
-			LOG_E(tag_) << "Failed to read area json file:" << (*it).second;
-			return false;
-        }
 
-        // read area cubes
-        std::shared_ptr<octillion::Area> area = std::make_shared<octillion::Area>(json);
+        // read area cubes, the area pulls cubes from the file one by one, 
+        // json keeps the rest of the fields
+        std::shared_ptr<JsonW> json;
+        JsonReaderW reader(fin);
+        std::shared_ptr<octillion::Area> area = std::make_shared<octillion::Area>(reader, json, cubes_);
 
         if (area->valid())
         {
@@ -196,7 +193,7 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
         
         LOG_I(tag_) << "load area:" << area->id() << " contains cubes:" << area->cubes_.size();
         
-        if ( Area::getmark(json, marks, area->cubes_) == false )
+        if ( area->getmark(marks) == false )
         {
             LOG_E(tag_) << "failed to load marks in area file: " << (*it).second;
             return false;
@@ -255,55 +252,8 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
         fin.close();
     }
   
-    // create cubes short cut to areas_
-    for (const auto& it : areas_)
-    {
-        for (const auto& mapit : it.second->cubes_)
-        {
-            cubes_[mapit.first] = mapit.second;
-        }
-    }
-
-    // check the adjacent for all cubes
-    for (auto itcube = cubes_.begin(); itcube != cubes_.end(); itcube++)
-    {
-        if ((*itcube).second->find(cubes_, octillion::Cube::X_INC) != nullptr)
-            (*itcube).second->adjacent_cubes_[octillion::Cube::X_INC] = octillion::Cube::EXIT_NORMAL;
-        if ((*itcube).second->find(cubes_, octillion::Cube::X_DEC) != nullptr)
-            (*itcube).second->adjacent_cubes_[octillion::Cube::X_DEC] = octillion::Cube::EXIT_NORMAL;
-        if ((*itcube).second->find(cubes_, octillion::Cube::Y_INC) != nullptr)
-            (*itcube).second->adjacent_cubes_[octillion::Cube::Y_INC] = octillion::Cube::EXIT_NORMAL;
-        if ((*itcube).second->find(cubes_, octillion::Cube::Y_DEC) != nullptr)
-            (*itcube).second->adjacent_cubes_[octillion::Cube::Y_DEC] = octillion::Cube::EXIT_NORMAL;
-        if ((*itcube).second->find(cubes_, octillion::Cube::Z_INC) != nullptr)
-            (*itcube).second->adjacent_cubes_[octillion::Cube::Z_INC] = octillion::Cube::EXIT_NORMAL;
-        if ((*itcube).second->find(cubes_, octillion::Cube::Z_DEC) != nullptr)
-            (*itcube).second->adjacent_cubes_[octillion::Cube::Z_DEC] = octillion::Cube::EXIT_NORMAL;
-        if ((*itcube).second->find(cubes_, octillion::Cube::X_INC_Y_INC) != nullptr)
-        {
-            auto adjcube = (*itcube).second->find(cubes_, octillion::Cube::X_INC_Y_INC);
-            if ( adjcube->exits_[octillion::Cube::X_DEC] != 0 && adjcube->exits_[octillion::Cube::Y_DEC] != 0 )
-                (*itcube).second->adjacent_cubes_[octillion::Cube::X_INC_Y_INC] = octillion::Cube::EXIT_NORMAL;
-        }
-        if ((*itcube).second->find(cubes_, octillion::Cube::X_DEC_Y_INC) != nullptr)
-        {
-            auto adjcube = (*itcube).second->find(cubes_, octillion::Cube::X_DEC_Y_INC);
-            if (adjcube->exits_[octillion::Cube::X_INC] != 0 && adjcube->exits_[octillion::Cube::Y_DEC] != 0)
-                (*itcube).second->adjacent_cubes_[octillion::Cube::X_DEC_Y_INC] = octillion::Cube::EXIT_NORMAL;
-        }
-        if ((*itcube).second->find(cubes_, octillion::Cube::X_INC_Y_DEC) != nullptr)
-        {
-            auto adjcube = (*itcube).second->find(cubes_, octillion::Cube::X_INC_Y_DEC);
-            if (adjcube->exits_[octillion::Cube::X_DEC] != 0 && adjcube->exits_[octillion::Cube::Y_INC] != 0)
-                (*itcube).second->adjacent_cubes_[octillion::Cube::X_INC_Y_DEC] = octillion::Cube::EXIT_NORMAL;
-        }
-        if ((*itcube).second->find(cubes_, octillion::Cube::X_DEC_Y_DEC) != nullptr)
-        {
-            auto adjcube = (*itcube).second->find(cubes_, octillion::Cube::X_DEC_Y_DEC);
-            if (adjcube->exits_[octillion::Cube::X_INC] != 0 && adjcube->exits_[octillion::Cube::Y_INC] != 0)
-                (*itcube).second->adjacent_cubes_[octillion::Cube::X_DEC_Y_DEC] = octillion::Cube::EXIT_NORMAL;
-        }
-    }
+    // no more cubes, Cube* and CubeId into cubes_ are fixed from now on
+    cubes_.seal();
 
     // read reborn loc
     std::shared_ptr<JsonW> jreborn = jglobal->get(u8"reborn");
@@ -319,14 +269,13 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
                 (uint_fast32_t) jreborn->get(1)->integer(),
                 (uint_fast32_t) jreborn->get(2)->integer());
                 
-    if ( cubes_.find( pos ) == cubes_.end() ) 
+    reborn_ = cubes_.find( pos );
+    if ( reborn_ == CubeStore::NO_CUBE ) 
     {
         LOG_E(tag_) << "reborn position " << pos.x() << "," << pos.y() << "," << pos.z() << " does not exist";
         return false;
     }        
 
-    reborn_ = cubes_.at( pos );
-
 	// read global links
 	size_t global_link_count = 0;
     std::shared_ptr<JsonW> jglinks = jglobal->get(u8"links");
@@ -340,7 +289,7 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
         std::shared_ptr<JsonW> jfromcube = jfrom->get("cube");
         std::shared_ptr<JsonW> jtocube = jto->get("cube");
 
-        std::shared_ptr<Cube> from, to;
+        CubeId from, to;
 
         // get link type, area 'from' id, area 'to' id
         std::string linktype = jglink->get(u8"type")->str();
@@ -358,7 +307,7 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
         from = readloc( jfrom, marks, cubes_);
         to = readloc( jto, marks, cubes_);
 
-        if (from == nullptr || to == nullptr)
+        if (from == CubeStore::NO_CUBE || to == CubeStore::NO_CUBE)
         {
             LOG_E(tag_) << "bad loc in json " << jglink->text();
             continue;
@@ -369,18 +318,18 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
 		bool ret;
 		if (octillion::Cube::json2attr(jattrs, attr) != OcError::E_SUCCESS)
 		{
-			ret = octillion::Area::addlink(is_twoway, from, to);
+			ret = octillion::Area::addlink(is_twoway, &cubes_[from], &cubes_[to]);
 		}
 		else
 		{
-			ret = octillion::Area::addlink(is_twoway, from, to, attr);
+			ret = octillion::Area::addlink(is_twoway, &cubes_[from], &cubes_[to], attr);
 		}
 
         // create link
         if (ret == false)
         {
             LOG_E(tag_) << "failed to add link between " 
-                << from->loc().str() << " " << to->loc().str();
+                << cubes_[from].loc().str() << " " << cubes_[to].loc().str();
         }
         else
         {
@@ -388,28 +337,31 @@ bool octillion::WorldMap::load_external_data_file( std::string directory, bool u
         }
     }
     
-    // add areaid in each cube
-    for ( auto itarea = areas_.begin(); itarea != areas_.end(); itarea ++ )
+    // resolve the neighbors of all cubes once all links are added, so 
+    // moving and exit checks do not look up cubes_ any more
+    for (auto itcube = cubes_.begin(); itcube != cubes_.end(); itcube++)
     {
-        std::shared_ptr<octillion::Area> area = (*itarea).second;
-
-        for ( auto it = area->cubes_.begin(); it != area->cubes_.end(); it ++ )
-        {
-            octillion::CubePosition pos = it->first;
-        }
+        (*itcube).findneighbors(cubes_);
     }
-    
+
+    // add areaid in each cube
     for ( auto itarea = areas_.begin(); itarea != areas_.end(); itarea ++ )
     {
         std::shared_ptr<octillion::Area> area = (*itarea).second;
 
         for ( auto it = area->cubes_.begin(); it != area->cubes_.end(); it ++ )
         {
-            it->second->areaid_ = area->id();
+            cubes_[*it].areaid_ = area->id();
         }
     }
     
     initialized_ = true;
+    
+    std::chrono::duration<double, std::milli> elapsed = 
+        std::chrono::steady_clock::now() - start;
+    
+    LOG_I(tag_) << "load_external_data_file() read " << areas_.size() << " area(s) " 
+        << cubes_.size() << " cube(s) in " << elapsed.count() << " ms";
    
     return true;
 }
@@ -427,15 +379,16 @@ void octillion::WorldMap::dump()
 
         for ( auto it = area->cubes_.begin(); it != area->cubes_.end(); it ++ )
         {
-            octillion::CubePosition pos = it->first;
-            LOG_I(tag_) << pos.str() << it->second->title() << "(area:"
-                << it->second->area() << ") "            
-                << ( it->second->exits_[0] > 0 ? "N" : "_" )
-                << ( it->second->exits_[1] > 0 ? "E" : "_" )
-                << ( it->second->exits_[2] > 0 ? "S" : "_" )
-                << ( it->second->exits_[3] > 0 ? "W" : "_" )
-                << ( it->second->exits_[4] > 0 ? "U" : "_" )
-                << ( it->second->exits_[5] > 0 ? "D" : "_" );
+            octillion::Cube& cube = cubes_[*it];
+            octillion::CubePosition pos = cube.loc();
+            LOG_I(tag_) << pos.str() << cube.title() << "(area:"
+                << cube.area() << ") "            
+                << ( cube.exit(0) ? "N" : "_" )
+                << ( cube.exit(1) ? "E" : "_" )
+                << ( cube.exit(2) ? "S" : "_" )
+                << ( cube.exit(3) ? "W" : "_" )
+                << ( cube.exit(4) ? "U" : "_" )
+                << ( cube.exit(5) ? "D" : "_" );
         }
     }
     
@@ -444,20 +397,20 @@ void octillion::WorldMap::dump()
     
     for ( auto it = cubes_.begin(); it != cubes_.end(); it ++ )
     {
-        octillion::CubePosition pos = it->first;
-        LOG_I(tag_) << pos.str() << it->second->title() << "(area:"
-                << it->second->area() << ") "            
-                << ( it->second->exits_[0] > 0 ? "N" : "_" )
-                << ( it->second->exits_[1] > 0 ? "E" : "_" )
-                << ( it->second->exits_[2] > 0 ? "S" : "_" )
-                << ( it->second->exits_[3] > 0 ? "W" : "_" )
-                << ( it->second->exits_[4] > 0 ? "U" : "_" )
-                << ( it->second->exits_[5] > 0 ? "D" : "_" );
+        octillion::CubePosition pos = it->loc();
+        LOG_I(tag_) << pos.str() << it->title() << "(area:"
+                << it->area() << ") "            
+                << ( it->exit(0) ? "N" : "_" )
+                << ( it->exit(1) ? "E" : "_" )
+                << ( it->exit(2) ? "S" : "_" )
+                << ( it->exit(3) ? "W" : "_" )
+                << ( it->exit(4) ? "U" : "_" )
+                << ( it->exit(5) ? "D" : "_" );
     }
     
     // other information
     LOG_I(tag_) << "=== Config === ";
-    LOG_I(tag_) << "reborn: " << reborn_->loc().str();
+    LOG_I(tag_) << "reborn: " << cubes_[reborn_].loc().str();
     LOG_I(tag_) << "stamp: " << global_config_stamp_;
     
     LOG_I(tag_) << "=== End ===";
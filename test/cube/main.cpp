@@ -0,0 +1,116 @@
+#include <iostream>
+#include <random>
+
+#include <malloc.h>
+
+#include "world/cube.hpp"
+#include "world/cubestore.hpp"
+
+using octillion::Cube;
+using octillion::CubeId;
+using octillion::CubePosition;
+using octillion::CubeStore;
+
+// bytes in use on the heap
+static size_t heap_used()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+int main()
+{
+    const uint_fast32_t EDGE = 100; // EDGE^3 cubes
+
+    // a 3x1x1 corridor, mobs can only go west from the middle cube
+    // added east to west, the index sorts them
+    CubeStore cubes;
+    for ( uint_fast32_t x = 12; x >= 10; x -- )
+    {
+        cubes.add( CubePosition( x, 10, 10 ), 1, 0xFFFFFFFF );
+    }
+
+    if ( cubes.duplicate() != CubeStore::NO_CUBE || cubes.find( CubePosition( 10, 10, 10 )) != 2 ||
+         cubes.find( CubePosition( 13, 10, 10 )) != CubeStore::NO_CUBE || cubes.at( 3 ) != NULL )
+    {
+        std::cout << "failed 000" << std::endl;
+        return -1;
+    }
+
+    // cubes may move until the store is sealed
+    cubes.seal();
+    if ( cubes.add( CubePosition( 9, 10, 10 ), 1, 0xFFFFFFFF ) != CubeStore::NO_CUBE )
+    {
+        std::cout << "failed 004" << std::endl;
+        return -1;
+    }
+
+    Cube* west = cubes.cube( CubePosition( 10, 10, 10 ));
+    Cube* middle = cubes.cube( CubePosition( 11, 10, 10 ));
+    Cube* east = cubes.cube( CubePosition( 12, 10, 10 ));
+    Cube nowhere( CubePosition( 11, 11, 10 )); // no cube there
+
+    middle->addlink( west );
+    middle->addlink( east, Cube::NPC_CUBE );
+    middle->addlink( &nowhere );
+    west->addlink( middle );
+
+    for ( auto& cube : cubes )
+    {
+        cube.findneighbors( cubes );
+    }
+
+    if ( ! middle->exit( Cube::X_DEC ) || ! middle->exit( Cube::X_INC ) || ! middle->exit( Cube::Y_INC ) ||
+         middle->exit( Cube::Y_DEC ) || middle->neighbor( Cube::X_DEC ) != west || 
+         middle->neighbor( Cube::Y_INC ) != NULL || ! middle->adjacent( Cube::X_INC ) )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    std::minstd_rand rng;
+    for ( int idx = 0; idx < 100; idx ++ )
+    {
+        if ( middle->random_exit( Cube::MOB_CUBE, rng ) != Cube::X_DEC ||
+             east->random_exit( Cube::MOB_CUBE, rng ) != -1 )
+        {
+            std::cout << "failed 002" << std::endl;
+            return -1;
+        }
+    }
+
+    if ( Cube::dir( middle, east ) != Cube::X_INC || Cube::dir( west, east ) != -1 )
+    {
+        std::cout << "failed 003" << std::endl;
+        return -1;
+    }
+
+    // memory of a synthetic world, the cubes and the index as World keeps them
+    size_t before = heap_used();
+    CubeStore world;
+    for ( uint_fast32_t x = 0; x < EDGE; x ++ )
+    {
+        for ( uint_fast32_t y = 0; y < EDGE; y ++ )
+        {
+            for ( uint_fast32_t z = 0; z < EDGE; z ++ )
+            {
+                world.add( CubePosition( x, y, z ), 1, 0xFFFFFFFF );
+            }
+        }
+    }
+    world.seal();
+    size_t after = heap_used();
+
+    if ( world.find( CubePosition( 42, 7, 99 )) != ( 42 * EDGE + 7 ) * EDGE + 99 )
+    {
+        std::cout << "failed 005" << std::endl;
+        return -1;
+    }
+
+    std::cout << "cubes:" << world.size() << " sizeof(Cube):" << sizeof( Cube )
+              << " sizeof(CubeId):" << sizeof( CubeId )
+              << " heap bytes per cube:" << ( after - before ) / world.size() << std::endl;
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "world/cubegrid.hpp"
+
+typedef octillion::CubePosition CubePosition;
+typedef octillion::CubeGrid CubeGrid;
+
+static int_fast64_t elapsed_us( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// a world of 'areas' areas of 64 x 64 x 4 cubes, offset by 100000 like the
+// area files, areas 1000 cubes apart on x
+static void synthetic( int areas, std::vector<CubePosition>& cubes )
+{
+    for ( int area = 0; area < areas; area ++ )
+    {
+        for ( uint_fast32_t x = 0; x < 64; x ++ )
+        {
+            for ( uint_fast32_t y = 0; y < 64; y ++ )
+            {
+                for ( uint_fast32_t z = 0; z < 4; z ++ )
+                {
+                    cubes.push_back( CubePosition( 100000 + area * 1000 + x, 100000 + y, 100000 + z ));
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    const int kAreas = 64;
+    const int kLookups = 4000000;
+    const int kBoxes = 10000;
+
+    CubeGrid grid;
+
+    // box and lookup around 0 and across chunk borders
+    if ( ! grid.insert( CubePosition( 0, 0, 0 ), 1 ) || ! grid.insert( CubePosition( 15, 16, 17 ), 2 ) ||
+         grid.insert( CubePosition( 0, 0, 0 ), 3 ) || grid.size() != 2 || grid.chunks() != 2 ||
+         grid.find( CubePosition( 0, 0, 0 )) != 1 || grid.find( CubePosition( 15, 16, 17 )) != 2 ||
+         grid.find( CubePosition( 15, 16, 16 )) != CubeGrid::NONE || grid.find( CubePosition( 99, 0, 0 )) != CubeGrid::NONE )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    size_t hit = 0;
+    grid.box( CubePosition( 0, 0, 0 ), CubePosition( 15, 16, 17 ), [&hit]( const CubePosition&, uint32_t id ) { hit += id; } );
+    grid.box( CubePosition( 1, 0, 0 ), CubePosition( 20, 20, 20 ), [&hit]( const CubePosition&, uint32_t id ) { hit += id * 10; } );
+    grid.box( CubePosition( 1, 0, 0 ), CubePosition( 0, 20, 20 ), [&hit]( const CubePosition&, uint32_t id ) { hit += id * 100; } );
+    if ( hit != 23 )
+    {
+        std::cout << "failed 002" << std::endl;
+        return -1;
+    }
+
+    // same content in the grid and in an ordered map
+    std::vector<CubePosition> cubes;
+    synthetic( kAreas, cubes );
+
+    CubeGrid world;
+    std::map<CubePosition, uint32_t> tree;
+
+    auto start = std::chrono::steady_clock::now();
+    for ( size_t idx = 0; idx < cubes.size(); idx ++ )
+    {
+        world.insert( cubes[idx], (uint32_t)idx );
+    }
+    auto gridbuild = elapsed_us( start );
+
+    start = std::chrono::steady_clock::now();
+    for ( size_t idx = 0; idx < cubes.size(); idx ++ )
+    {
+        tree[cubes[idx]] = (uint32_t)idx;
+    }
+    auto treebuild = elapsed_us( start );
+
+    // random lookups, about a quarter miss
+    std::vector<CubePosition> probes;
+    srand( 1 );
+    for ( int idx = 0; idx < 4096; idx ++ )
+    {
+        const CubePosition& loc = cubes[rand() % cubes.size()];
+        probes.push_back( idx % 4 == 0 ? CubePosition( loc.x(), loc.y() + 64, loc.z() ) : loc );
+    }
+
+    for ( const auto& loc : probes )
+    {
+        auto it = tree.find( loc );
+        if ( world.find( loc ) != ( it == tree.end() ? CubeGrid::NONE : it->second ))
+        {
+            std::cout << "failed 003" << std::endl;
+            return -1;
+        }
+    }
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for ( int idx = 0; idx < kLookups; idx ++ )
+    {
+        found += world.find( probes[idx & 4095] ) != CubeGrid::NONE;
+    }
+    auto gridfind = elapsed_us( start );
+
+    start = std::chrono::steady_clock::now();
+    for ( int idx = 0; idx < kLookups; idx ++ )
+    {
+        found += tree.find( probes[idx & 4095] ) != tree.end();
+    }
+    auto treefind = elapsed_us( start );
+
+    // 9 x 9 x 3 boxes, the tree walks each row of the box by range
+    size_t gridcount = 0, treecount = 0;
+    start = std::chrono::steady_clock::now();
+    for ( int idx = 0; idx < kBoxes; idx ++ )
+    {
+        const CubePosition& loc = probes[idx & 4095];
+        world.box( CubePosition( loc.x() - 4, loc.y() - 4, loc.z() - 1 ), CubePosition( loc.x() + 4, loc.y() + 4, loc.z() + 1 ),
+            [&gridcount]( const CubePosition&, uint32_t ) { gridcount ++; } );
+    }
+    auto gridbox = elapsed_us( start );
+
+    start = std::chrono::steady_clock::now();
+    for ( int idx = 0; idx < kBoxes; idx ++ )
+    {
+        const CubePosition& loc = probes[idx & 4095];
+        for ( uint_fast32_t x = loc.x() - 4; x <= loc.x() + 4; x ++ )
+        {
+            for ( uint_fast32_t y = loc.y() - 4; y <= loc.y() + 4; y ++ )
+            {
+                auto it = tree.lower_bound( CubePosition( x, y, loc.z() - 1 ));
+                auto end = tree.upper_bound( CubePosition( x, y, loc.z() + 1 ));
+                for ( ; it != end; ++ it )
+                {
+                    treecount ++;
+                }
+            }
+        }
+    }
+    auto treebox = elapsed_us( start );
+
+    if ( gridcount != treecount )
+    {
+        std::cout << "failed 004 grid:" << gridcount << " tree:" << treecount << std::endl;
+        return -1;
+    }
+
+    std::cout << "cubes:" << cubes.size() << " chunks:" << world.chunks()
+              << " grid bytes per cube:" << world.bytes() / cubes.size()
+              << " map bytes per cube:" << sizeof( std::pair<const CubePosition, uint32_t> ) + 4 * sizeof( void* ) << std::endl;
+    std::cout << "build: " << gridbuild << "us grid, " << treebuild << "us map" << std::endl;
+    std::cout << "find: " << gridfind * 1000 / kLookups << "ns grid, " << treefind * 1000 / kLookups << "ns map (" << found << ")" << std::endl;
+    std::cout << "box 9x9x3: " << gridbox * 1000 / kBoxes << "ns grid, " << treebox * 1000 / kBoxes << "ns map (" << gridcount << ")" << std::endl;
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include "world/cubekey.hpp"
+
+typedef octillion::CubeKey CubeKey;
+typedef octillion::CubePosition CubePosition;
+
+// the hash CubePosition had before, for comparison
+class CantorHash
+{
+public:
+    std::size_t operator()( const CubePosition& key ) const
+    {
+        std::size_t a = key.x(), b = key.y(), c = key.z();
+        std::size_t d = 5 * ( a + b ) * ( a + b + 1 ) + b;
+        return 5 * ( c + d ) * ( c + d + 1 ) + d;
+    }
+};
+
+// largest bucket of a set of an area's cubes
+template<typename Set>
+static size_t worst_bucket( const Set& set )
+{
+    size_t worst = 0;
+    for ( size_t idx = 0; idx < set.bucket_count(); idx ++ )
+    {
+        worst = std::max( worst, set.bucket_size( idx ));
+    }
+    return worst;
+}
+
+int main()
+{
+    const int kLookups = 4000000;
+
+    // round trip, bits above 21 are dropped
+    CubeKey max( CubeKey::MAX_AXIS, 0, CubeKey::MAX_AXIS );
+    if ( !( CubeKey( 100123, 99877, 100004 ).pos() == CubePosition( 100123, 99877, 100004 )) ||
+         max.x() != CubeKey::MAX_AXIS || max.y() != 0 || max.z() != CubeKey::MAX_AXIS ||
+         CubeKey( CubeKey::MAX_AXIS + 2, 0, 0 ).x() != 1 || CubeKey::valid( CubePosition( 0, CubeKey::MAX_AXIS + 1, 0 )) ||
+         sizeof( CubeKey ) != 8 || sizeof( CubePosition ) != 12 )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    // a 2x2x2 block at an even corner is 8 keys in a row
+    CubeKey corner( 100000, 100000, 100000 );
+    for ( uint_fast32_t idx = 0; idx < 8; idx ++ )
+    {
+        CubeKey key( 100000 + ( idx & 1 ), 100000 + (( idx >> 1 ) & 1 ), 100000 + ( idx >> 2 ));
+        if ( key.code() != corner.code() + idx )
+        {
+            std::cout << "failed 002" << std::endl;
+            return -1;
+        }
+    }
+
+    // an area of 64 x 64 x 4 cubes
+    std::vector<CubePosition> cubes;
+    for ( uint_fast32_t x = 0; x < 64; x ++ )
+    {
+        for ( uint_fast32_t y = 0; y < 64; y ++ )
+        {
+            for ( uint_fast32_t z = 0; z < 4; z ++ )
+            {
+                cubes.push_back( CubePosition( 100000 + x, 100000 + y, 100000 + z ));
+            }
+        }
+    }
+
+    std::unordered_set<CubePosition> mixed( cubes.begin(), cubes.end() );
+    std::unordered_set<CubePosition, CantorHash> cantor( cubes.begin(), cubes.end() );
+    std::unordered_set<CubeKey> keys;
+    for ( const auto& loc : cubes )
+    {
+        keys.insert( CubeKey( loc ));
+    }
+
+    if ( mixed.size() != cubes.size() || keys.size() != cubes.size() )
+    {
+        std::cout << "failed 003" << std::endl;
+        return -1;
+    }
+
+    // sorted keys against the ordered map of positions
+    std::vector<CubeKey> sorted( keys.begin(), keys.end() );
+    std::sort( sorted.begin(), sorted.end() );
+    std::map<CubePosition, uint32_t> tree;
+    for ( size_t idx = 0; idx < cubes.size(); idx ++ )
+    {
+        tree[cubes[idx]] = (uint32_t)idx;
+    }
+
+    std::vector<CubePosition> probes;
+    srand( 1 );
+    for ( int idx = 0; idx < 4096; idx ++ )
+    {
+        probes.push_back( cubes[rand() % cubes.size()] );
+    }
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for ( int idx = 0; idx < kLookups; idx ++ )
+    {
+        found += std::binary_search( sorted.begin(), sorted.end(), CubeKey( probes[idx & 4095] ));
+    }
+    auto sortedus = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+
+    start = std::chrono::steady_clock::now();
+    for ( int idx = 0; idx < kLookups; idx ++ )
+    {
+        found += tree.count( probes[idx & 4095] );
+    }
+    auto treeus = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+
+    if ( found != 2 * (size_t)kLookups )
+    {
+        std::cout << "failed 004" << std::endl;
+        return -1;
+    }
+
+    std::cout << "sizeof CubePosition:" << sizeof( CubePosition ) << " CubeKey:" << sizeof( CubeKey ) << std::endl;
+    std::cout << "worst bucket of " << cubes.size() << " cubes: " << worst_bucket( mixed ) << " mixed, "
+              << worst_bucket( cantor ) << " cantor, " << worst_bucket( keys ) << " key" << std::endl;
+    std::cout << "find: " << sortedus * 1000 / kLookups << "ns sorted keys, " << treeus * 1000 / kLookups << "ns map" << std::endl;
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "memory/objectpool.hpp"
+#include "server/dataqueue.hpp"
+#include "world/command.hpp"
+#include "world/cubeposition.hpp"
+#include "world/event.hpp"
+#include "world/interactive.hpp"
+#include "world/mob.hpp"
+#include "world/player.hpp"
+#include "world/script.hpp"
+#include "world/stringtable.hpp"
+
+// every operator new in this program is counted
+static size_t allocs = 0;
+
+void* operator new( std::size_t size )
+{
+    allocs ++;
+    void* ptr = std::malloc( size == 0 ? 1 : size );
+    if ( ptr == NULL )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete( void* ptr ) noexcept { std::free( ptr ); }
+void operator delete( void* ptr, std::size_t ) noexcept { std::free( ptr ); }
+
+// size of T and heap allocations to create and delete one T
+template<typename T, typename F>
+static void report( const char* name, F create )
+{
+    const int kRounds = 1000;
+
+    size_t before = allocs;
+    for ( int idx = 0; idx < kRounds; idx ++ )
+    {
+        T* obj = create();
+        delete obj;
+    }
+
+    // the object itself is one of them
+    std::cout << name << " sizeof:" << sizeof( T )
+              << " allocs:" << (double)( allocs - before ) / kRounds - 1 << std::endl;
+}
+
+// same for T whose operator new takes blocks from ObjectPool<T>, the object
+// itself is a heap allocation only when the pool misses
+template<typename T, typename F>
+static void reportpooled( const char* name, F create )
+{
+    const int kRounds = 1000;
+
+    uint_fast64_t misses = octillion::ObjectPool<T>::instance().stats().misses;
+    size_t before = allocs;
+    for ( int idx = 0; idx < kRounds; idx ++ )
+    {
+        T* obj = create();
+        delete obj;
+    }
+    misses = octillion::ObjectPool<T>::instance().stats().misses - misses;
+
+    std::cout << name << " sizeof:" << sizeof( T )
+              << " allocs:" << (double)( allocs - before - misses ) / kRounds
+              << " pool misses:" << misses << std::endl;
+}
+
+int main()
+{
+    report<octillion::CubePosition>( "CubePosition", []() { return new octillion::CubePosition( 1, 2, 3 ); } );
+    reportpooled<octillion::Event>( "Event", []() { return new octillion::Event( octillion::Event::TYPE_PLAYER_ARRIVE ); } );
+    reportpooled<octillion::Command>( "Command", []() { return new octillion::Command( 1, octillion::Command::CONNECT ); } );
+
+    report<octillion::Mob>( "Mob", []() { return new octillion::Mob(); } );
+    report<octillion::Player>( "Player", []() { return new octillion::Player(); } );
+    report<octillion::Script>( "Script", []() { return new octillion::Script(); } );
+    report<octillion::Condition>( "Condition", []() { return new octillion::Condition(); } );
+    report<octillion::Action>( "Action", []() { return new octillion::Action(); } );
+    report<octillion::Interactive>( "Interactive", []() { return new octillion::Interactive(); } );
+    report<octillion::StringTable>( "StringTable", []() { return new octillion::StringTable(); } );
+
+    // DataQueue logs every ctor, size only
+    std::cout << "DataQueue sizeof:" << sizeof( octillion::DataQueue ) << std::endl;
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
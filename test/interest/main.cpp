@@ -0,0 +1,135 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "world/interestgrid.hpp"
+
+typedef octillion::CubePosition CubePosition;
+
+// players within 'radius' cubes by checking everyone
+static std::vector<int> brute( const std::map<int, CubePosition>& players, const CubePosition& loc, uint_fast32_t radius )
+{
+    std::vector<int> out;
+    for ( const auto& it : players )
+    {
+        const CubePosition& at = it.second;
+        if ( std::max( at.x(), loc.x() ) - std::min( at.x(), loc.x() ) <= radius &&
+             std::max( at.y(), loc.y() ) - std::min( at.y(), loc.y() ) <= radius &&
+             std::max( at.z(), loc.z() ) - std::min( at.z(), loc.z() ) <= radius )
+        {
+            out.push_back( it.first );
+        }
+    }
+    return out;
+}
+
+static CubePosition random_loc( uint_fast32_t span )
+{
+    return CubePosition( 1000 + rand() % span, 1000 + rand() % span, 1000 + rand() % 4 );
+}
+
+int main()
+{
+    const int kPlayers = 2000;
+    const uint_fast32_t kSpan = 200;
+
+    octillion::InterestGrid<int> grid( 3 );
+    std::map<int, CubePosition> players;
+
+    srand( 1 );
+
+    // positions near 0 do not underflow
+    if ( ! grid.insert( -1, CubePosition( 0, 1, 2 )) || grid.insert( -1, CubePosition( 0, 0, 0 )) )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    std::vector<int> out;
+    grid.query( CubePosition( 1, 0, 0 ), 2, out );
+    if ( out.size() != 1 || out[0] != -1 || ! grid.erase( -1 ) || grid.erase( -1 ) || grid.size() != 0 )
+    {
+        std::cout << "failed 002" << std::endl;
+        return -1;
+    }
+
+    for ( int id = 0; id < kPlayers; id ++ )
+    {
+        CubePosition loc = random_loc( kSpan );
+        players[id] = loc;
+        grid.insert( id, loc );
+    }
+
+    // query, move and erase agree with checking every player
+    for ( int round = 0; round < 5000; round ++ )
+    {
+        int id = rand() % kPlayers;
+        uint_fast32_t radius = rand() % 12;
+        CubePosition loc = random_loc( kSpan );
+
+        out.clear();
+        grid.query( loc, radius, out );
+        std::sort( out.begin(), out.end() );
+        if ( out != brute( players, loc, radius ) )
+        {
+            std::cout << "failed 003 round:" << round << std::endl;
+            return -1;
+        }
+
+        // move one step or jump, report who comes into and goes out of range
+        CubePosition to = ( round % 2 == 0 ) ? 
+            CubePosition( players[id], rand() % 6 ) : random_loc( kSpan );
+        std::vector<int> entered, left;
+        std::vector<int> before = brute( players, players[id], grid.radius() );
+        grid.move( id, to, entered, left );
+        players[id] = to;
+        std::vector<int> after = brute( players, to, grid.radius() );
+
+        std::vector<int> expect_entered, expect_left;
+        std::set_difference( after.begin(), after.end(), before.begin(), before.end(), std::back_inserter( expect_entered ));
+        std::set_difference( before.begin(), before.end(), after.begin(), after.end(), std::back_inserter( expect_left ));
+        expect_entered.erase( std::remove( expect_entered.begin(), expect_entered.end(), id ), expect_entered.end() );
+        expect_left.erase( std::remove( expect_left.begin(), expect_left.end(), id ), expect_left.end() );
+
+        if ( entered != expect_entered || left != expect_left )
+        {
+            std::cout << "failed 004 round:" << round << std::endl;
+            return -1;
+        }
+
+        if ( round % 100 == 0 )
+        {
+            grid.erase( id );
+            players.erase( id );
+            grid.insert( id, to );
+            players[id] = to;
+        }
+    }
+
+    // nearby lookups cost the cells around the position, not the players
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for ( int round = 0; round < 100000; round ++ )
+    {
+        out.clear();
+        grid.nearby( players[round % kPlayers], out );
+        found += out.size();
+    }
+    auto gridus = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+
+    start = std::chrono::steady_clock::now();
+    for ( int round = 0; round < 1000; round ++ )
+    {
+        found += brute( players, players[round % kPlayers], grid.radius() ).size();
+    }
+    auto bruteus = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+
+    std::cout << "nearby: " << gridus / 100 << "ns/query grid, " << bruteus << "ns/query scan of " 
+              << kPlayers << " players (" << found << ")" << std::endl;
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,379 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <dirent.h>
+
+#include "jsonw/jsonw.hpp"
+
+// typical inbound command and outbound event payloads
+static const char* kLoginCmd = u8"{\"cmd\":1,\"user\":\"guest0001\",\"passwd\":\"7b2f0b3c8e\"}";
+static const char* kMoveCmd = u8"{\"cmd\":11,\"token\":\"a94a8fe5ccb19ba61c4c0873d391e987\"}";
+static const char* kTextEvent = u8"{\"type\":20,\"loc\":{\"x\":100001,\"y\":100000,\"z\":100000},"
+    u8"\"title\":\"主控室\",\"desc\":[\"你張開眼睛，發現自己身處於一個巨大的白色空間中。\","
+    u8"\"「年輕的靈魂，先試著移動自己看看。」\"],\"exits\":\"nsew\"}";
+
+// number of characters in utf8 text
+static size_t chars(const std::string& str)
+{
+    size_t count = 0;
+    for (char c : str)
+    {
+        if ((c & 0xC0) != 0x80)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// walk the whole tree once like the loaders do, look up every key and
+// read every string, also count the string storage in utf8 and in ucs
+static void walk(const JsonW& json, size_t& lookups, size_t& u8bytes, size_t& ucsbytes)
+{
+    if (json.type() == JsonW::OBJECT)
+    {
+        std::vector<std::string> keys;
+        json.keys(keys);
+        for (const auto& key : keys)
+        {
+            lookups++;
+            u8bytes += key.length();
+            ucsbytes += chars(key) * sizeof(wchar_t);
+            walk(*json.get(key), lookups, u8bytes, ucsbytes);
+        }
+    }
+    else if (json.type() == JsonW::ARRAY)
+    {
+        for (size_t i = 0; i < json.size(); i++)
+        {
+            walk(*json.get(i), lookups, u8bytes, ucsbytes);
+        }
+    }
+    else if (json.type() == JsonW::STRING)
+    {
+        const std::string& str = json.str();
+        u8bytes += str.length();
+        ucsbytes += chars(str) * sizeof(wchar_t);
+    }
+}
+
+// pull every event without building the tree, like the streaming loaders
+static size_t pull(const std::string& text)
+{
+    JsonReaderW reader(text.data(), text.length());
+    size_t u8bytes = 0;
+
+    while (reader.next() != JsonReaderW::Event::End)
+    {
+        if (reader.event() == JsonReaderW::Event::Error)
+        {
+            return 0;
+        }
+
+        if (reader.event() == JsonReaderW::Event::Key ||
+            reader.event() == JsonReaderW::Event::String)
+        {
+            u8bytes += reader.str().length();
+        }
+    }
+
+    return u8bytes;
+}
+
+// synthetic area of about 'size' bytes, a cube per line like data/*.json,
+// or with no white space at all if not pretty
+static std::string area(size_t size, bool pretty)
+{
+    static const char* kTitles[] = { u8"主控室", u8"小倉庫", u8"倉庫閣樓", u8"白色空間的\\角落" };
+    std::string nl = pretty ? "\n" : "";
+    std::string indent = pretty ? "        " : "";
+    std::string sp = pretty ? " " : "";
+    std::string text = "{" + nl + "    \"id\":" + sp + "1," + nl +
+        "    \"title\":" + sp + "\"synthetic area\"," + nl +
+        "    \"offset\":" + sp + "[100000," + sp + "100000," + sp + "100000]," + nl +
+        "    \"cubes\":" + nl + "    [" + nl;
+
+    if (!pretty)
+    {
+        text.erase(std::remove(text.begin(), text.end(), ' '), text.end());
+    }
+
+    for (int i = 0; text.length() < size; i++)
+    {
+        text += (i == 0 ? "" : "," + nl) + indent +
+            "{\"loc\":[" + std::to_string(i % 1000) + "," + std::to_string(i / 1000 % 1000) + ",0]," + sp +
+            "\"mark\":\"m" + std::to_string(i) + "\"," + sp +
+            "\"title\":\"" + kTitles[i % 4] + "\"}";
+    }
+
+    return text + nl + (pretty ? "    " : "") + "]" + nl + "}" + nl;
+}
+
+// synthetic "strings" table of about 'size' bytes, the text of an area
+static std::string texts(size_t size, bool pretty)
+{
+    static const char* kTexts[] = {
+        u8"你張開眼睛，發現自己身處於一個巨大的白色空間中。",
+        u8"神秘聲音在你腦內響起，「就是這樣，到上層來見我吧。」",
+        u8"你往前走，站在一片白色的長廊中間，左右看似空曠卻無法通過，更遠的前方似乎接著往上的階梯。",
+        u8"「年輕的靈魂，先試著移動自己看看。」\\n" };
+    std::string nl = pretty ? "\n" : "";
+    std::string indent = pretty ? "    " : "";
+    std::string sp = pretty ? " " : "";
+    std::string text = "{" + nl + indent + "\"strings\":" + nl + indent + "[" + nl;
+
+    for (int i = 0; text.length() < size; i++)
+    {
+        text += (i == 0 ? "" : "," + nl) + indent +
+            "{\"id\":" + sp + std::to_string(i) + "," + sp + "\"text\":" + sp + "\"" + kTexts[i % 4] + "\"}";
+    }
+
+    return text + nl + indent + "]" + nl + "}" + nl;
+}
+
+// tokens of the text, without building anything
+static size_t tokens(const std::string& text)
+{
+    JsonTokenW tokens(text.data(), text.length());
+    size_t count = 0;
+
+    for (;;)
+    {
+        JsonTokenW::Type type = tokens.next();
+        if (type == JsonTokenW::Type::End || type == JsonTokenW::Type::Bad)
+        {
+            return count;
+        }
+        count++;
+    }
+}
+
+// utf8 check, tokens without and with the structural index, parse and
+// pull of a multi-megabyte text at every instruction set the cpu has
+static void large(const std::string& name, const std::string& text, int rounds)
+{
+    static const int kModes[] = { JsonIndexW::SCALAR, JsonIndexW::SSE2, JsonIndexW::AVX2 };
+    static const char* kNames[] = { "scalar", "sse2", "avx2" };
+    int best = JsonIndexW::simd();
+
+    for (int mode : kModes)
+    {
+        if (mode > best)
+        {
+            break;
+        }
+        JsonIndexW::simd(mode);
+
+        auto start = std::chrono::steady_clock::now();
+        size_t valid = 0;
+        for (int i = 0; i < rounds; i++)
+        {
+            size_t size = text.length();
+            valid += JsonTokenW::utf8valid(text.data(), size) ? size : 0;
+        }
+        auto checked = std::chrono::steady_clock::now();
+
+        size_t scanned = 0;
+        JsonIndexW::enable(false);
+        for (int i = 0; i < rounds; i++)
+        {
+            scanned += tokens(text);
+        }
+        JsonIndexW::enable(true);
+        auto scan = std::chrono::steady_clock::now();
+
+        size_t indexed = 0;
+        for (int i = 0; i < rounds; i++)
+        {
+            indexed += tokens(text);
+        }
+        auto index = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < rounds; i++)
+        {
+            JsonW json(text.data(), text.length());
+            if (!json.valid())
+            {
+                std::cout << name << " is not valid json" << std::endl;
+                return;
+            }
+        }
+        auto parsed = std::chrono::steady_clock::now();
+
+        size_t pulled = 0;
+        for (int i = 0; i < rounds; i++)
+        {
+            pulled += pull(text);
+        }
+        auto streamed = std::chrono::steady_clock::now();
+
+        auto ms = [rounds](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+        {
+            return std::chrono::duration<double, std::milli>(b - a).count() / rounds;
+        };
+
+        std::cout << std::left << std::setw(24) << name << std::setw(8) << kNames[mode]
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << text.length() << "B"
+            << std::setw(10) << ms(start, checked) << "ms utf8"
+            << std::setw(10) << ms(checked, scan) << "ms scan"
+            << std::setw(10) << ms(scan, index) << "ms index"
+            << std::setw(8) << (scanned == indexed ? "same" : "differ")
+            << std::setw(10) << ms(index, parsed) << "ms parse"
+            << std::setw(10) << ms(parsed, streamed) << "ms pull"
+            << std::setw(10) << (valid + pulled) / rounds << "B" << std::endl;
+    }
+}
+
+// reply that carries a whole area, built from a copy of the parsed area
+// and from a frozen area shared by every reply
+static void embed(const std::string& name, const std::string& text, int rounds)
+{
+    JsonW json(text.data(), text.length());
+    size_t copied = 0, shared = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        JsonW reply;
+        reply[u8"cmd"] = 903;
+        reply[u8"data"] = json;
+        copied += reply.text().length();
+    }
+    auto copy = std::chrono::steady_clock::now();
+
+    std::shared_ptr<const JsonW> jfrozen = JsonW::freeze(json);
+    auto frozen = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        JsonW reply;
+        reply[u8"cmd"] = 903;
+        reply.add(u8"data", jfrozen);
+        shared += reply.text().length();
+    }
+    auto share = std::chrono::steady_clock::now();
+
+    auto ms = [rounds](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+    {
+        return std::chrono::duration<double, std::milli>(b - a).count() / rounds;
+    };
+
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << text.length() << "B"
+        << std::setw(10) << ms(start, copy) << "ms copy"
+        << std::setw(10) << ms(copy, frozen) * rounds << "ms freeze"
+        << std::setw(10) << ms(frozen, share) << "ms shared"
+        << std::setw(10) << (copied == shared ? "same" : "differ") << std::endl;
+}
+
+static void bench(const std::string& name, const std::string& text, int rounds)
+{
+    size_t lookups = 0, u8bytes = 0, ucsbytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        JsonW json(text.data(), text.length());
+        if (!json.valid())
+        {
+            std::cout << name << " is not valid json" << std::endl;
+            return;
+        }
+    }
+    auto parsed = std::chrono::steady_clock::now();
+
+    JsonW json(text.data(), text.length());
+    for (int i = 0; i < rounds; i++)
+    {
+        lookups = u8bytes = ucsbytes = 0;
+        walk(json, lookups, u8bytes, ucsbytes);
+    }
+    auto walked = std::chrono::steady_clock::now();
+
+    size_t outsize = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        outsize += json.text().length();
+    }
+    auto written = std::chrono::steady_clock::now();
+
+    size_t pulled = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        pulled += pull(text);
+    }
+    auto streamed = std::chrono::steady_clock::now();
+
+    auto us = [rounds](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+    {
+        return std::chrono::duration<double, std::micro>(b - a).count() / rounds;
+    };
+
+    std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(8) << text.length() << "B"
+        << std::setw(10) << us(start, parsed) << "us parse"
+        << std::setw(10) << us(parsed, walked) << "us walk(" << lookups << ")"
+        << std::setw(10) << us(walked, written) << "us text"
+        << std::setw(10) << us(written, streamed) << "us pull"
+        << std::setw(8) << u8bytes << "/" << ucsbytes << "B str" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : "../../data/";
+    int rounds = argc > 2 ? std::stoi(argv[2]) : 1000;
+
+    DIR* dp = opendir(dir.c_str());
+    if (dp == NULL)
+    {
+        std::cout << "failed to open " << dir << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> files;
+    struct dirent* entry;
+    while ((entry = readdir(dp)) != NULL)
+    {
+        std::string fname(entry->d_name);
+        if (fname.length() > 5 && fname.substr(fname.length() - 5) == ".json")
+        {
+            files.push_back(fname);
+        }
+    }
+    closedir(dp);
+
+    std::cout << "sizeof(JsonW) " << sizeof(JsonW) << "B" << std::endl;
+
+    for (const auto& fname : files)
+    {
+        std::ifstream fin(dir + fname);
+        std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+        bench(fname, text, rounds);
+    }
+
+    bench("cmd: login", kLoginCmd, rounds * 10);
+    bench("cmd: move", kMoveCmd, rounds * 10);
+    bench("event: cube text", kTextEvent, rounds * 10);
+
+    int simd = JsonIndexW::simd();
+    for (size_t mb : { 1, 4, 16 })
+    {
+        int count = std::max(1, rounds / 100 / (int)mb);
+        large("area " + std::to_string(mb) + "MB pretty", area(mb << 20, true), count);
+        large("area " + std::to_string(mb) + "MB compact", area(mb << 20, false), count);
+        large("strings " + std::to_string(mb) + "MB pretty", texts(mb << 20, true), count);
+    }
+    JsonIndexW::simd(simd);
+
+    for (size_t mb : { 1, 4, 16 })
+    {
+        int count = std::max(1, rounds / 100 / (int)mb);
+        embed("reply with area " + std::to_string(mb) + "MB", area(mb << 20, false), count);
+    }
+
+    return 0;
+}
@@ -0,0 +1,363 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+
+#include "jsonw/jsonw.hpp"
+
+// write the events of the reader back to text, return true if the
+// reader ends with Event::End
+static bool events(JsonReaderW& reader, std::string& text)
+{
+    JsonWriterW<std::string> writer(text);
+    JsonReaderW::Event event;
+
+    while ((event = reader.next()) != JsonReaderW::Event::End && 
+           event != JsonReaderW::Event::Error)
+    {
+        switch (event)
+        {
+        case JsonReaderW::Event::StartObject: writer.begin_object(); break;
+        case JsonReaderW::Event::StartArray: writer.begin_array(); break;
+        case JsonReaderW::Event::EndObject: 
+        case JsonReaderW::Event::EndArray: writer.end(); break;
+        case JsonReaderW::Event::Key: writer.key(reader.str()); break;
+        case JsonReaderW::Event::String: writer.value(reader.str()); break;
+        case JsonReaderW::Event::Integer: writer.value(reader.integer()); break;
+        case JsonReaderW::Event::Float: writer.value(reader.frac()); break;
+        case JsonReaderW::Event::Boolean: writer.value(reader.boolean()); break;
+        default: writer.null(); break;
+        }
+    }
+
+    return event == JsonReaderW::Event::End;
+}
+
+// events of JsonReaderW written back by JsonWriterW have to parse into
+// the same json, except that the reader does not detect duplicate keys.
+// Reading from a stream gives the same events as reading from a buffer.
+static bool pull(const std::string& fname, const std::string& data, const JsonW& json)
+{
+    JsonReaderW reader(data.data(), data.length());
+    std::string text;
+    bool done = events(reader, text);
+
+    std::istringstream iss(data);
+    JsonReaderW sreader(iss);
+    std::string stext;
+    if (events(sreader, stext) != done || stext != text)
+    {
+        std::cout << "failed " << fname << " stream:" << stext << std::endl;
+        return false;
+    }
+
+    JsonW again(text.data(), text.length());
+    bool same;
+
+    if (json.valid() && json.type() != JsonW::BAD)
+    {
+        same = done && again.text() == json.text();
+    }
+    else if (json.valid())
+    {
+        // no value at all, or a bad token after the value
+        same = !done || text.length() == 0;
+    }
+    else
+    {
+        same = !done || !again.valid();
+    }
+
+    if (!same)
+    {
+        std::cout << "failed " << fname << " pull:" << text << std::endl;
+    }
+
+    return same;
+}
+
+// corpus/expect.txt has one line per corpus file:
+//   <file> <valid> <type> <text>
+// where <text> is JsonW::text() of a valid json, or '*' to skip the text 
+// check. The expected results are what the token queue parser returned 
+// before the single pass parser replaced it.
+static bool check(const std::string& dir, const std::string& line)
+{
+    std::istringstream iss(line);
+    std::string fname, text;
+    int valid, type;
+
+    iss >> fname >> valid >> type;
+    std::getline(iss, text);
+    if (text.length() > 0 && text[0] == ' ')
+    {
+        text.erase(0, 1);
+    }
+
+    std::ifstream fin(dir + fname, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    JsonW json(data.data(), data.length());
+
+    if ((int)json.valid() != valid || json.type() != type)
+    {
+        std::cout << "failed " << fname << " valid:" << json.valid() << " type:" << json.type() << std::endl;
+        return false;
+    }
+
+    if (valid && text != "*" && json.text() != text)
+    {
+        std::cout << "failed " << fname << " text:" << json.text() << std::endl;
+        return false;
+    }
+
+    return pull(fname, data, json);
+}
+
+// a frozen copy has the same text, cannot be changed, and is shared 
+// rather than copied by the documents that hold it
+static bool frozen(const std::string& path, const JsonW& json)
+{
+    std::shared_ptr<const JsonW> jfrozen = JsonW::freeze(json);
+    std::vector<std::string> keys;
+    json.keys(keys);
+
+    JsonW reply;
+    reply.add(u8"cmd", 1);
+    reply.add(u8"data", jfrozen);
+    JsonW copy(reply);
+    copy[u8"cmd"] = 2;
+
+    JsonW& jkey = (*std::const_pointer_cast<JsonW>(jfrozen))[keys.front()];
+    jkey = u8"changed";
+
+    if (!jfrozen->frozen() || !jfrozen->get(keys.front())->frozen() || json.frozen() ||
+        jfrozen->text() != json.text() || jfrozen->text(false) != json.text(false) ||
+        reply.text() != u8"{\"cmd\":1,\"data\":" + json.text() + u8"}" ||
+        copy.get(u8"data") != std::const_pointer_cast<JsonW>(jfrozen) ||
+        copy.text() != u8"{\"cmd\":2,\"data\":" + json.text() + u8"}" ||
+        std::const_pointer_cast<JsonW>(jfrozen)->add(u8"more", 1) ||
+        std::const_pointer_cast<JsonW>(jfrozen)->erase(keys.front()))
+    {
+        std::cout << "failed " << path << " frozen" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// text() of a parsed file has to parse back into the same text
+static bool roundtrip(const std::string& path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    JsonW json(fin);
+    if (!json.valid() || json.type() != JsonW::OBJECT)
+    {
+        std::cout << "failed " << path << " is not a json object" << std::endl;
+        return false;
+    }
+
+    for (bool singleline : { true, false })
+    {
+        std::string text = json.text(singleline);
+        JsonW again(text.data(), text.length());
+        if (again.text(singleline) != text)
+        {
+            std::cout << "failed " << path << " round trip" << std::endl;
+            return false;
+        }
+    }
+
+    return frozen(path, json);
+}
+
+// a text over several chunks of the stream reader, with tokens across
+// the chunk ends, has to read the same as from a buffer
+static bool chunks()
+{
+    std::string data = u8"[";
+    for (int idx = 0; data.length() < 300000; idx++)
+    {
+        data += u8"{\"id\":" + std::to_string(idx * 7919) + u8",\"x\":-" + std::to_string(idx) +
+            u8".25e-3,\"name\":\"主控室\\u0041\\n" + std::string(idx % 13, 'a') + 
+            u8"\",\"on\":" + (idx % 2 ? u8"true" : u8"false") + u8",\"none\":null}, ";
+    }
+    data += u8"\"" + std::string(100000, 'b') + u8"主\"]";
+
+    JsonW json(data.data(), data.length());
+    std::istringstream iss(data);
+    JsonReaderW reader(iss);
+    std::shared_ptr<JsonW> jvalue;
+    if (reader.next() == JsonReaderW::Event::StartArray)
+    {
+        jvalue = reader.value();
+    }
+
+    if (!json.valid() || jvalue == nullptr || jvalue->text() != json.text() ||
+        reader.next() != JsonReaderW::Event::End)
+    {
+        std::cout << "failed chunks" << std::endl;
+        return false;
+    }
+
+    // invalid utf8 and NUL far after the start are found as well
+    const std::pair<std::string, JsonReaderW::Event> tails[] = {
+        { std::string(1, '\xC0'), JsonReaderW::Event::Error },
+        { std::string(1, '\0') + std::string(1, '\xC0'), JsonReaderW::Event::Error },
+        { std::string(1, '\0') + u8"]", JsonReaderW::Event::Error },
+        { u8"] x" + std::string(100000, ' ') + std::string(1, '\xFF'), JsonReaderW::Event::Error },
+        { u8"] x" + std::string(100000, ' ') + u8"主", JsonReaderW::Event::End }
+    };
+
+    for (const auto& it : tails)
+    {
+        std::istringstream itail(data.substr(0, data.length() - 1) + it.first);
+        JsonReaderW rtail(itail);
+        std::string text;
+        if (events(rtail, text) != (it.second == JsonReaderW::Event::End))
+        {
+            std::cout << "failed chunks tail " << it.first.substr(0, 8) << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// record with every kind of member JsonBindW supports
+struct Record
+{
+    int level;
+    uint_fast32_t id;
+    long long exp;
+    bool admin;
+    std::string name;
+    std::string note;
+    uint_fast32_t loc[3];
+};
+
+constexpr JsonFieldW<Record> kRecordFields[] = {
+    { u8"level", &Record::level },
+    { u8"id", &Record::id },
+    { u8"exp", &Record::exp },
+    { u8"admin", &Record::admin },
+    { u8"name", &Record::name, JsonFieldW<Record>::NONEMPTY },
+    { u8"note", &Record::note, JsonFieldW<Record>::OPTIONAL },
+    { u8"loc", &Record::loc }
+};
+
+// JsonBindW has to accept or reject a text the same way from the reader 
+// and from JsonW, and what it writes has to read back the same
+static bool bind(const std::string& text, bool expect)
+{
+    Record record = Record(), parsed = Record();
+    JsonW json(text.data(), text.length());
+    bool streamed = JsonBindW::read(text.data(), text.length(), kRecordFields, record);
+    bool dom = json.valid() && JsonBindW::read(json, kRecordFields, parsed);
+
+    if (streamed != expect || dom != expect)
+    {
+        std::cout << "failed bind " << text << std::endl;
+        return false;
+    }
+
+    if (!expect)
+    {
+        return true;
+    }
+
+    std::string out;
+    JsonWriterW<std::string> writer(out);
+    JsonBindW::write(writer, kRecordFields, record);
+
+    Record again = Record();
+    if (!JsonBindW::read(out.data(), out.length(), kRecordFields, again) ||
+        again.level != parsed.level || again.id != parsed.id || again.exp != parsed.exp ||
+        again.admin != parsed.admin || again.name != parsed.name || again.note != parsed.note ||
+        again.loc[0] != parsed.loc[0] || again.loc[1] != parsed.loc[1] || again.loc[2] != parsed.loc[2])
+    {
+        std::cout << "failed bind round trip " << text << " " << out << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string corpus = argc > 1 ? argv[1] : "corpus/";
+    std::string data = argc > 2 ? argv[2] : "../../data/";
+    int count = 0, failed = 0;
+
+    std::ifstream fexpect(corpus + "expect.txt");
+    std::string line;
+    while (std::getline(fexpect, line))
+    {
+        if (line.length() == 0)
+        {
+            continue;
+        }
+
+        count++;
+        if (!check(corpus, line))
+        {
+            failed++;
+        }
+    }
+
+    DIR* dp = opendir(data.c_str());
+    struct dirent* entry;
+    while (dp != NULL && (entry = readdir(dp)) != NULL)
+    {
+        std::string fname(entry->d_name);
+        if (fname.length() > 5 && fname.substr(fname.length() - 5) == ".json")
+        {
+            count++;
+            if (!roundtrip(data + fname))
+            {
+                failed++;
+            }
+        }
+    }
+
+    if (dp != NULL)
+    {
+        closedir(dp);
+    }
+
+    count++;
+    if (!chunks())
+    {
+        failed++;
+    }
+
+    const std::string base = u8"\"level\":-3,\"id\":4294967295,\"exp\":-9000000000,\"admin\":true,\"loc\":[1,2,3]";
+    const std::pair<std::string, bool> binds[] = {
+        { u8"{" + base + u8",\"name\":\"主控室\"}", true },
+        { u8"{" + base + u8",\"name\":\"a\",\"note\":\"\",\"x\":[{\"name\":1}]}", true },
+        { u8"{\"name\":\"a\" " + base + u8"}", true },
+        { u8"{" + base + u8"}", false },
+        { u8"{" + base + u8",\"name\":\"\"}", false },
+        { u8"{" + base + u8",\"name\":1}", false },
+        { u8"{" + base + u8",\"name\":\"a\",\"level\":1}", false },
+        { u8"{\"level\":2147483648," + base.substr(10) + u8",\"name\":\"a\"}", false },
+        { u8"{\"id\":-1," + base + u8",\"name\":\"a\"}", false },
+        { u8"{" + base.substr(0, base.length() - 13) + u8"\"loc\":[1,2],\"name\":\"a\"}", false },
+        { u8"{" + base.substr(0, base.length() - 13) + u8"\"loc\":[1,2,3,4],\"name\":\"a\"}", false },
+        { u8"{" + base + u8",\"name\":\"a\"} tru", false },
+        { u8"[" + base + u8"]", false }
+    };
+
+    for (const auto& it : binds)
+    {
+        count++;
+        if (!bind(it.first, it.second))
+        {
+            failed++;
+        }
+    }
+
+    std::cout << count - failed << "/" << count << " passed" << std::endl;
+    return failed == 0 ? 0 : -1;
+}
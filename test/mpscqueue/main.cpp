@@ -0,0 +1,90 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "server/mpscqueue.hpp"
+
+int main()
+{
+    const int kProducers = 4;
+    const int kItems = 100000;
+
+    octillion::MpscQueue<int> queue;
+    std::vector<int> out;
+    std::vector<int> next( kProducers, 0 );
+    std::vector<std::thread> producers;
+
+    // single thread, drain keeps push order
+    for ( int i = 0; i < 10; i ++ )
+    {
+        queue.push( i );
+    }
+
+    if ( queue.drain( out ) != 10 || out.size() != 10 )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    for ( int i = 0; i < 10; i ++ )
+    {
+        if ( out[i] != i )
+        {
+            std::cout << "failed 002" << std::endl;
+            return -1;
+        }
+    }
+
+    if ( ! queue.empty() || queue.drain( out ) != 0 )
+    {
+        std::cout << "failed 003" << std::endl;
+        return -1;
+    }
+
+    // multiple producers, consumer drains while they are pushing,
+    // every item arrives once and each producer's order is kept
+    out.clear();
+
+    for ( int p = 0; p < kProducers; p ++ )
+    {
+        producers.push_back( std::thread( [&queue, p, kItems]() {
+            for ( int i = 0; i < kItems; i ++ )
+            {
+                queue.push( p * kItems + i );
+            }
+        }));
+    }
+
+    size_t total = 0;
+    while ( total < (size_t)( kProducers * kItems ))
+    {
+        std::vector<int> batch;
+        total += queue.drain( batch );
+
+        for ( auto value : batch )
+        {
+            int p = value / kItems;
+            if ( value % kItems != next[p] )
+            {
+                std::cout << "failed 004" << std::endl;
+                return -1;
+            }
+            next[p]++;
+        }
+    }
+
+    for ( auto& thread : producers )
+    {
+        thread.join();
+    }
+
+    if ( ! queue.empty() )
+    {
+        std::cout << "failed 005" << std::endl;
+        return -1;
+    }
+
+    std::cout << "MpscQueue test passed" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "memory/objectpool.hpp"
+#include "server/mpscqueue.hpp"
+
+// a message as the network threads create them
+class Pooled
+{
+public:
+    Pooled( int value ) : value_( value ) {}
+    virtual ~Pooled() {}
+
+    int value_;
+    char payload_[48];
+
+    static void* operator new( size_t size ) { return octillion::ObjectPool<Pooled>::instance().allocate( size ); }
+    static void operator delete( void* ptr, size_t size ) { octillion::ObjectPool<Pooled>::instance().release( ptr, size ); }
+};
+
+// bigger than the pool blocks, goes to the global operator
+class Bigger : public Pooled
+{
+public:
+    Bigger( int value ) : Pooled( value ) {}
+    char more_[64];
+};
+
+// the same without the pool
+class Plain
+{
+public:
+    Plain( int value ) : value_( value ) {}
+    virtual ~Plain() {}
+
+    int value_;
+    char payload_[48];
+};
+
+// one producer creates, the consumer deletes what it drains, return the
+// time in microseconds
+template<typename T>
+static int_fast64_t crossthread( int items, int64_t& sum )
+{
+    octillion::MpscQueue<T*> queue;
+    std::vector<T*> out;
+    bool done = false;
+    std::atomic<bool> finished{ false };
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer( [&queue, &finished, items]() {
+        for ( int idx = 0; idx < items; idx ++ )
+        {
+            queue.push( new T( idx ));
+        }
+        finished.store( true );
+    } );
+
+    while ( ! done )
+    {
+        done = finished.load();
+        out.clear();
+        queue.drain( out );
+        for ( auto obj : out )
+        {
+            sum += obj->value_;
+            delete obj;
+        }
+    }
+
+    producer.join();
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+}
+
+int main()
+{
+    const int kItems = 1000000;
+    typedef octillion::ObjectPool<Pooled> Pool;
+
+    // a released block is reused by the next allocation on the thread,
+    // other sizes pass through
+    std::thread( []() {
+        Pooled* first = new Pooled( 1 );
+        void* block = first;
+        delete first;
+
+        Pooled* second = new Pooled( 2 );
+        Pooled* bigger = new Bigger( 3 );
+        if ( (void*)second != block || (void*)bigger == block )
+        {
+            std::cout << "failed 001" << std::endl;
+            exit( -1 );
+        }
+        delete second;
+        delete bigger;
+    } ).join();
+
+    Pool::Stats stats = Pool::instance().stats();
+    if ( stats.hits != 1 || stats.misses != 1 || stats.returns != 1 )
+    {
+        std::cout << "failed 002 hits:" << stats.hits << " misses:" << stats.misses << std::endl;
+        return -1;
+    }
+
+    // created on one thread and deleted on another, blocks come back by
+    // the depot
+    int64_t pooledsum = 0, plainsum = 0;
+    int_fast64_t pooledus = crossthread<Pooled>( kItems, pooledsum );
+    int_fast64_t plainus = crossthread<Plain>( kItems, plainsum );
+
+    // the consumer (this thread) publishes at most BATCH - 1 operations late
+    stats = Pool::instance().stats();
+    if ( pooledsum != plainsum || pooledsum != (int64_t)kItems * ( kItems - 1 ) / 2 ||
+         stats.refills == 0 || stats.returns == 0 || stats.misses >= (uint_fast64_t)kItems / 2 ||
+         stats.hits + stats.misses + Pool::BATCH < (uint_fast64_t)kItems )
+    {
+        std::cout << "failed 003 hits:" << stats.hits << " misses:" << stats.misses << std::endl;
+        return -1;
+    }
+
+    std::cout << "cross thread " << kItems << " objects: " << pooledus << "us pool, " << plainus << "us new/delete" << std::endl;
+    std::cout << "hits:" << stats.hits << " misses:" << stats.misses
+              << " refills:" << stats.refills << " returns:" << stats.returns << std::endl;
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
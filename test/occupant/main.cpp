@@ -0,0 +1,97 @@
+#include <iostream>
+#include <vector>
+
+#include "world/occupantlist.hpp"
+
+class Item : public octillion::OccupantHook<octillion::CubeOccupant>, 
+             public octillion::OccupantHook<octillion::AreaOccupant>
+{
+public:
+    Item( int id ) : id_( id ) {}
+    int id_;
+};
+
+typedef octillion::OccupantList<Item, octillion::CubeOccupant> CubeList;
+typedef octillion::OccupantList<Item, octillion::AreaOccupant> AreaList;
+
+static bool same( const CubeList& list, const std::vector<int>& ids )
+{
+    std::vector<int> got;
+    for ( Item* item : list )
+    {
+        got.push_back( item->id_ );
+    }
+    return got == ids && list.size() == ids.size();
+}
+
+int main()
+{
+    std::vector<Item> items;
+    for ( int idx = 0; idx < 5; idx ++ )
+    {
+        items.push_back( Item( idx ));
+    }
+
+    CubeList cube1, cube2;
+    AreaList area;
+
+    // push keeps the order, an item is in one list per tag only
+    for ( auto& item : items )
+    {
+        cube1.push( &item );
+        area.push( &item );
+    }
+
+    if ( ! same( cube1, { 0, 1, 2, 3, 4 } ) || area.size() != 5 )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    if ( cube2.push( &items[0] ) || ! cube1.contains( &items[0] ) || cube2.contains( &items[0] ))
+    {
+        std::cout << "failed 002" << std::endl;
+        return -1;
+    }
+
+    // erase head, middle and tail
+    if ( ! cube1.erase( &items[0] ) || ! cube1.erase( &items[2] ) || ! cube1.erase( &items[4] ) ||
+         cube1.erase( &items[2] ) || ! same( cube1, { 1, 3 } ))
+    {
+        std::cout << "failed 003" << std::endl;
+        return -1;
+    }
+
+    // move between lists of the same tag, the other tag is untouched
+    if ( ! cube1.move( &items[1], cube2 ) || ! same( cube1, { 3 } ) || ! same( cube2, { 1 } ) ||
+         ! area.contains( &items[1] ) || area.size() != 5 )
+    {
+        std::cout << "failed 004" << std::endl;
+        return -1;
+    }
+
+    if ( cube1.move( &items[1], cube2 ))
+    {
+        std::cout << "failed 005" << std::endl;
+        return -1;
+    }
+
+    // a copy of an item is not in any list
+    Item copy = items[3];
+    if ( static_cast<octillion::OccupantHook<octillion::CubeOccupant>&>( copy ).linked() || cube1.contains( &copy ))
+    {
+        std::cout << "failed 006" << std::endl;
+        return -1;
+    }
+
+    cube1.erase( &items[3] );
+    cube2.erase( &items[1] );
+    if ( ! cube1.empty() || ! cube2.empty() || cube1.begin() != cube1.end() )
+    {
+        std::cout << "failed 007" << std::endl;
+        return -1;
+    }
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
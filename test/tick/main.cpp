@@ -0,0 +1,124 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+#include <sys/resource.h>
+
+#include "world/tickscheduler.hpp"
+
+// cpu time of this process in microseconds
+static long long cpu_us()
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1000000LL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+int main()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // rate is clamped
+    octillion::TickScheduler scheduler( 0 );
+    if ( scheduler.hz() != 1 || scheduler.period() != std::chrono::seconds( 1 ) )
+    {
+        std::cout << "failed 001" << std::endl;
+        return -1;
+    }
+
+    scheduler.hz( 100000 );
+    if ( scheduler.hz() != octillion::TickScheduler::MAX_HZ )
+    {
+        std::cout << "failed 002" << std::endl;
+        return -1;
+    }
+
+    // 50 ticks at 50 hz take about a second and almost no cpu
+    scheduler.hz( 50 );
+    int count = 0;
+    long long cpu = cpu_us();
+    Clock::time_point start = Clock::now();
+
+    scheduler.run( [&count]() { return ++ count < 51; } );
+
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>( Clock::now() - start ).count();
+    cpu = cpu_us() - cpu;
+
+    if ( scheduler.stats().ticks != 50 || elapsed < 990 || elapsed > 1200 )
+    {
+        std::cout << "failed 003 ticks:" << scheduler.stats().ticks << " elapsed:" << elapsed << "ms" << std::endl;
+        return -1;
+    }
+
+    if ( cpu > 100000 )
+    {
+        std::cout << "failed 004 cpu:" << cpu << "us" << std::endl;
+        return -1;
+    }
+
+    if ( scheduler.stats().overruns != 0 || scheduler.stats().skipped != 0 )
+    {
+        std::cout << "failed 005" << std::endl;
+        return -1;
+    }
+
+    // at 100 hz one 55ms tick misses 5 slots, skip drops all 5
+    scheduler.hz( 100 );
+    scheduler.catchup( 0 );
+    count = 0;
+    scheduler.run( [&count]()
+    {
+        if ( ++ count == 3 ) std::this_thread::sleep_for( std::chrono::milliseconds( 55 ));
+        return count < 20;
+    });
+
+    if ( scheduler.stats().ticks != 19 || scheduler.stats().overruns != 1 || scheduler.stats().skipped != 5 )
+    {
+        std::cout << "failed 006 ticks:" << scheduler.stats().ticks << " overruns:" << scheduler.stats().overruns
+                  << " skipped:" << scheduler.stats().skipped << std::endl;
+        return -1;
+    }
+
+    if ( scheduler.stats().max_us < 55000 )
+    {
+        std::cout << "failed 007" << std::endl;
+        return -1;
+    }
+
+    // catch up runs 3 of the missed slots late and skips 2
+    scheduler.catchup( 3 );
+    count = 0;
+    scheduler.run( [&count]()
+    {
+        if ( ++ count == 3 ) std::this_thread::sleep_for( std::chrono::milliseconds( 55 ));
+        return count < 20;
+    });
+
+    if ( scheduler.stats().ticks != 19 || scheduler.stats().overruns != 1 || scheduler.stats().skipped != 2 ||
+         scheduler.stats().max_lag_us < 20000 )
+    {
+        std::cout << "failed 008 skipped:" << scheduler.stats().skipped
+                  << " lag:" << scheduler.stats().max_lag_us << std::endl;
+        return -1;
+    }
+
+    // stop() from another thread
+    std::thread stopper( [&scheduler]()
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+        scheduler.stop();
+    });
+
+    scheduler.run( []() { return true; } );
+    stopper.join();
+
+    if ( scheduler.stats().ticks < 5 || scheduler.stats().ticks > 15 )
+    {
+        std::cout << "failed 009 ticks:" << scheduler.stats().ticks << std::endl;
+        return -1;
+    }
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
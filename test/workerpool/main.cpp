@@ -0,0 +1,63 @@
+#include <iostream>
+#include <atomic>
+#include <vector>
+
+#include "server/workerpool.hpp"
+
+int main()
+{
+    const size_t kJobs = 64;
+    const int kBatches = 10000;
+
+    // every job runs exactly once in every batch
+    for ( size_t size : { 1, 2, 4, 0 } )
+    {
+        octillion::WorkerPool pool( size );
+        std::vector<std::atomic<int>> hits( kJobs );
+
+        if ( size > 0 && pool.size() != size )
+        {
+            std::cout << "failed 001" << std::endl;
+            return -1;
+        }
+
+        for ( int batch = 0; batch < kBatches; batch ++ )
+        {
+            size_t count = batch % ( kJobs + 1 );
+            pool.run( count, [&hits]( size_t idx ) { hits[idx].fetch_add( 1 ); } );
+
+            for ( size_t idx = 0; idx < kJobs; idx ++ )
+            {
+                int expect = idx < count ? 1 : 0;
+                if ( hits[idx].exchange( 0 ) != expect )
+                {
+                    std::cout << "failed 002 size:" << size << " batch:" << batch << std::endl;
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // results written by index do not depend on the thread that ran them
+    octillion::WorkerPool pool( 4 );
+    std::vector<long long> sums( kJobs, 0 );
+    pool.run( kJobs, [&sums]( size_t idx )
+    {
+        for ( long long n = 0; n < 100000; n ++ )
+        {
+            sums[idx] += n * ( idx + 1 );
+        }
+    });
+
+    for ( size_t idx = 0; idx < kJobs; idx ++ )
+    {
+        if ( sums[idx] != 4999950000LL * ( idx + 1 ) )
+        {
+            std::cout << "failed 003" << std::endl;
+            return -1;
+        }
+    }
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}